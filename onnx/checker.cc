@@ -1,8 +1,14 @@
 #include "onnx/checker.h"
+#include "onnx/common/ir_pb_converter.h"
 #include "onnx/defs/schema.h"
 #include "onnx/proto_utils.h"
+#include "onnx/shape_inference/implementation.h"
 #include "onnx/string_utils.h"
 
+#include <algorithm>
+#include <cstring>
+#include <exception>
+#include <memory>
 #include <unordered_set>
 
 namespace ONNX_NAMESPACE {
@@ -65,7 +71,37 @@ void check_value_info(const ValueInfoProto& value_info, const CheckerContext&) {
   }
 }
 
-void check_tensor(const TensorProto& tensor, const CheckerContext& /*ctx*/) {
+namespace {
+
+// Returns the size in bytes of the elements of a raw tensor of data_type,
+// or 0 if it cannot be stored in raw_data.
+size_t raw_element_size(int data_type) {
+  switch (data_type) {
+    case TensorProto::UINT8:
+    case TensorProto::INT8:
+    case TensorProto::BOOL:
+      return 1;
+    case TensorProto::UINT16:
+    case TensorProto::INT16:
+    case TensorProto::FLOAT16:
+      return 2;
+    case TensorProto::FLOAT:
+    case TensorProto::INT32:
+    case TensorProto::UINT32:
+      return 4;
+    case TensorProto::INT64:
+    case TensorProto::DOUBLE:
+    case TensorProto::UINT64:
+    case TensorProto::COMPLEX64:
+      return 8;
+    case TensorProto::COMPLEX128:
+      return 16;
+    default:
+      return 0;
+  }
+}
+
+void check_data_type(const TensorProto& tensor) {
   enforce_has_field(tensor, data_type);
   if (tensor.data_type() == TensorProto::UNDEFINED) {
     fail_check(
@@ -73,6 +109,70 @@ void check_tensor(const TensorProto& tensor, const CheckerContext& /*ctx*/) {
         tensor.name(),
         ") to UNDEFINED is not allowed");
   }
+}
+
+// Checks that a raw payload of raw_data_size bytes holds the elements of
+// tensor, given its data_type and dims.
+void check_raw_data_size(const TensorProto& tensor, uint64_t raw_data_size) {
+  if (tensor.data_type() == TensorProto::STRING) {
+    fail_check(
+        "STRING data (tensor name: ",
+        tensor.name(),
+        ") should not be stored in raw_data field");
+  }
+  size_t element_size = raw_element_size(tensor.data_type());
+  if (element_size == 0) {
+    fail_check(
+        "Unrecognized data_type (tensor name: ",
+        tensor.name(),
+        "): ",
+        tensor.data_type());
+  }
+  // a segment of the tensor is only a part of it
+  if (tensor.has_segment()) {
+    return;
+  }
+  uint64_t expected_size = element_size;
+  for (auto dim : tensor.dims()) {
+    if (dim < 0) {
+      fail_check(
+          "TensorProto (tensor name: ",
+          tensor.name(),
+          ") has a negative dimension ",
+          dim);
+    }
+    expected_size *= static_cast<uint64_t>(dim);
+  }
+  if (raw_data_size != expected_size) {
+    fail_check(
+        "TensorProto (tensor name: ",
+        tensor.name(),
+        ") should have ",
+        expected_size,
+        " bytes of raw data for its dims and data_type, but has ",
+        raw_data_size);
+  }
+}
+
+// Returns the index of the first NaN or infinity among the num_scalars
+// floating point numbers in data, whose bits are stored as Bits, or
+// num_scalars if there is none.
+template <typename Bits, Bits exponent_mask>
+size_t find_non_finite(const char* data, size_t num_scalars) {
+  for (size_t i = 0; i < num_scalars; i++) {
+    Bits bits;
+    std::memcpy(&bits, data + i * sizeof(Bits), sizeof(Bits));
+    if ((bits & exponent_mask) == exponent_mask) {
+      return i;
+    }
+  }
+  return num_scalars;
+}
+
+} // namespace
+
+void check_tensor(const TensorProto& tensor, const CheckerContext& /*ctx*/) {
+  check_data_type(tensor);
 
   int num_value_fields = 0;
 
@@ -102,12 +202,7 @@ void check_tensor(const TensorProto& tensor, const CheckerContext& /*ctx*/) {
         ") should contain one and only one value field.");
   }
   if (has_raw_data) {
-    if (tensor.data_type() == TensorProto::STRING) {
-      fail_check(
-          "STRING data (tensor name: ",
-          tensor.name(),
-          ") should not be stored in raw_data field");
-    }
+    check_raw_data_size(tensor, tensor.raw_data().size());
     return;
   } else {
 #define check_field(field)               \
@@ -164,6 +259,92 @@ void check_tensor(const TensorProto& tensor, const CheckerContext& /*ctx*/) {
 #undef check_field
 }
 
+void check_tensor_metadata(
+    const TensorProto& tensor,
+    uint64_t raw_data_size,
+    const CheckerContext& /*ctx*/) {
+  check_data_type(tensor);
+  if (tensor.float_data_size() || tensor.int32_data_size() ||
+      tensor.string_data_size() || tensor.int64_data_size() ||
+      tensor.has_raw_data() || tensor.double_data_size() ||
+      tensor.uint64_data_size()) {
+    fail_check(
+        "TensorProto (tensor name: ",
+        tensor.name(),
+        ") should contain no value field when its raw data is stored outside of it.");
+  }
+  check_raw_data_size(tensor, raw_data_size);
+}
+
+void check_tensor_finite(
+    const TensorProto& tensor,
+    uint64_t raw_data_size,
+    const std::function<void(char*, size_t)>& read,
+    const CheckerContext& ctx,
+    size_t chunk_size) {
+  check_tensor_metadata(tensor, raw_data_size, ctx);
+  // complex numbers are scanned as their real and imaginary parts
+  size_t (*find)(const char*, size_t) = nullptr;
+  size_t scalar_size = 0;
+  switch (tensor.data_type()) {
+    case TensorProto::FLOAT16:
+      find = find_non_finite<uint16_t, 0x7C00>;
+      scalar_size = 2;
+      break;
+    case TensorProto::FLOAT:
+    case TensorProto::COMPLEX64:
+      find = find_non_finite<uint32_t, 0x7F800000>;
+      scalar_size = 4;
+      break;
+    case TensorProto::DOUBLE:
+    case TensorProto::COMPLEX128:
+      find = find_non_finite<uint64_t, 0x7FF0000000000000>;
+      scalar_size = 8;
+      break;
+    default:
+      // the other types have no NaN or infinity
+      return;
+  }
+  chunk_size = std::max(chunk_size - chunk_size % scalar_size, scalar_size);
+  ThreadPool* pool = ctx.get_thread_pool();
+  const size_t num_pieces = pool != nullptr ? pool->num_threads() : 1;
+
+  std::vector<char> buffer;
+  for (uint64_t offset = 0; offset < raw_data_size; offset += chunk_size) {
+    size_t size = static_cast<size_t>(
+        std::min<uint64_t>(chunk_size, raw_data_size - offset));
+    buffer.resize(size);
+    read(buffer.data(), size);
+    // each piece of the chunk records its first non finite scalar, so that
+    // the one reported does not depend on the number of threads
+    const size_t num_scalars = size / scalar_size;
+    const size_t piece = (num_scalars + num_pieces - 1) / num_pieces;
+    std::vector<size_t> found(num_pieces, num_scalars);
+    auto scan = [&](size_t i) {
+      size_t begin = std::min(i * piece, num_scalars);
+      size_t end = std::min(begin + piece, num_scalars);
+      size_t j = find(buffer.data() + begin * scalar_size, end - begin);
+      if (j < end - begin) {
+        found[i] = begin + j;
+      }
+    };
+    if (pool != nullptr) {
+      pool->ParallelFor(num_pieces, scan);
+    } else {
+      scan(0);
+    }
+    size_t first = *std::min_element(found.begin(), found.end());
+    if (first < num_scalars) {
+      fail_check(
+          "TensorProto (tensor name: ",
+          tensor.name(),
+          ") has a NaN or an infinity at byte ",
+          offset + first * scalar_size,
+          " of its raw data");
+    }
+  }
+}
+
 // NB: This is a generic "attribute well-formedness" check, it doesn't
 // actually test if an attribute is valid per a schema
 void check_attribute(
@@ -244,10 +425,15 @@ void check_attribute(
   }
 }
 
-void check_node(
+namespace {
+
+// Checks node like check_node, and returns its schema. The nested graphs of
+// node are skipped unless check_nested_graphs is set.
+const OpSchema* check_node_and_resolve_schema(
     const NodeProto& node,
     const CheckerContext& ctx,
-    const LexicalScopeContext& lex_ctx) {
+    const LexicalScopeContext& lex_ctx,
+    bool check_nested_graphs = true) {
   enforce_non_empty_field(node, op_type);
 
   if (node.input().empty() && node.output().empty()) {
@@ -268,23 +454,65 @@ void check_node(
   auto domain_version = dit->second;
 
   for (const auto& attr : node.attribute()) {
+    if (!check_nested_graphs && (attr.type() == AttributeProto::GRAPH ||
+                                 attr.type() == AttributeProto::GRAPHS)) {
+      continue;
+    }
     check_attribute(attr, ctx, lex_ctx);
   }
 
-  const auto* schema =
-      OpSchemaRegistry::Schema(node.op_type(), domain_version, node.domain());
+  const auto* schema = ctx.get_schemas().Find(node.op_type(), node.domain());
   if (!schema) {
     fail_check(
         "No Schema registered for " + node.op_type() +
         " with domain_version of " + ONNX_NAMESPACE::to_string(domain_version));
   }
   schema->Verify(node);
+  return schema;
 }
 
-void check_graph(
+} // namespace
+
+void check_node(
+    const NodeProto& node,
+    const CheckerContext& ctx,
+    const LexicalScopeContext& lex_ctx) {
+  check_node_and_resolve_schema(node, ctx, lex_ctx);
+}
+
+namespace {
+
+bool has_graph_attribute(const NodeProto& node) {
+  for (const auto& attr : node.attribute()) {
+    if (attr.has_g() || attr.graphs_size() > 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Checks node, returning the error it fails with, if any.
+std::exception_ptr check_node_in_graph(
+    const NodeProto& node,
+    const CheckerContext& ctx,
+    const LexicalScopeContext& lex_ctx) {
+  try {
+    check_node(node, ctx, lex_ctx);
+  } catch (ValidationError& ex) {
+    ex.AppendContext("Bad node spec: " + ProtoDebugString(node));
+    return std::current_exception();
+  } catch (...) {
+    return std::current_exception();
+  }
+  return nullptr;
+}
+
+// Checks the name, inputs and outputs of graph, and adds the names of its
+// inputs to lex_ctx.
+void check_graph_inputs_and_outputs(
     const GraphProto& graph,
     const CheckerContext& ctx,
-    const LexicalScopeContext& parent_lex) {
+    LexicalScopeContext& lex_ctx) {
   enforce_non_empty_field(graph, name);
 
   for (const auto& value_info : graph.input()) {
@@ -294,73 +522,144 @@ void check_graph(
     check_value_info(value_info, ctx);
   }
 
-  std::unordered_set<std::string> output_names{};
-  // Inherit values avaiailable in outer scope
+  // Values available in outer scope are looked up in the parent of lex_ctx.
   // Note that we do not allow shadowing, so the presence of an already-defined
   // name is always an error.
   for (const auto& value_info : graph.input()) {
-    if (output_names.count(value_info.name())) {
+    if (lex_ctx.output_names.count(value_info.name())) {
       fail_check(
           "Graph must be in single static assignment (SSA) form, however '",
           value_info.name(),
           "' has been used as graph input names multiple times.");
     }
-    output_names.insert(value_info.name());
+    lex_ctx.output_names.insert(value_info.name());
   }
-  output_names.insert(
-      parent_lex.output_names.begin(), parent_lex.output_names.end());
-  for (const auto& init : graph.initializer()) {
-    if (!output_names.count(init.name())) {
-      fail_check(init.name() + " in initializer but not in graph input");
+}
+
+// Checks that the inputs of node are defined, before checking it.
+void check_node_inputs_defined(
+    const NodeProto& node,
+    const LexicalScopeContext& lex_ctx) {
+  // nodes must be in topologically sorted order
+  for (const auto& input : node.input()) {
+    // explicit optional input
+    if (input.empty()) {
+      continue;
+    }
+    if (!lex_ctx.this_or_ancestor_graph_has(input)) {
+      fail_check(
+          "Nodes in a graph must be topologically sorted, however input '",
+          input,
+          "' of node: \n",
+          ProtoDebugString(node),
+          "\n is not output of any previous nodes.");
     }
-    check_tensor(init, ctx);
   }
+}
 
-  for (const auto& node : graph.node()) {
-    // nodes must be in topologically sorted order
-    for (const auto& input : node.input()) {
-      // explicit optional input
-      if (input.empty()) {
-        continue;
-      }
-      if (!output_names.count(input)) {
-        fail_check(
-            "Nodes in a graph must be topologically sorted, however input '",
-            input,
-            "' of node: \n",
-            ProtoDebugString(node),
-            "\n is not output of any previous nodes.");
-      }
+// Checks that the outputs of node are not defined yet, after checking it,
+// and adds them to lex_ctx.
+void define_node_outputs(const NodeProto& node, LexicalScopeContext& lex_ctx) {
+  // check for SSA form
+  for (const auto& output : node.output()) {
+    // optional output
+    if (output.empty()) {
+      continue;
     }
-    // This needs to happen before SSA check since we don't want to recurse and
-    // find that outputs from control flow ops are colliding with names in the
-    // inner block
-    LexicalScopeContext lex_ctx;
-    lex_ctx.output_names = output_names;
-    try {
-      check_node(node, ctx, lex_ctx);
-    } catch (ValidationError& ex) {
-      ex.AppendContext("Bad node spec: " + ProtoDebugString(node));
-      throw ex;
+    if (lex_ctx.this_or_ancestor_graph_has(output)) {
+      fail_check(
+          "Graph must be in single static assignment (SSA) form, however '",
+          output,
+          "' has been used as output names multiple times.");
     }
-    // check for SSA form
-    for (const auto& output : node.output()) {
-      // optional output
-      if (output.empty()) {
-        continue;
+    lex_ctx.output_names.insert(output);
+  }
+}
+
+} // namespace
+
+void check_graph(
+    const GraphProto& graph,
+    const CheckerContext& ctx,
+    const LexicalScopeContext& parent_lex) {
+  LexicalScopeContext lex_ctx(&parent_lex);
+  check_graph_inputs_and_outputs(graph, ctx, lex_ctx);
+
+  // The initializers, then the nodes, are checked in two phases. The names
+  // are checked first, in order, up to the first error. Then the tensors and
+  // nodes before that error are checked, concurrently if ctx has a thread
+  // pool, except for the nodes with nested graphs, which see the names
+  // defined before them and are checked in the first phase. The error
+  // reported is the one of the first item failing, so that it does not
+  // depend on the number of threads.
+  const size_t num_initializers = static_cast<size_t>(graph.initializer_size());
+  const size_t num_items = num_initializers + static_cast<size_t>(graph.node_size());
+  std::vector<std::exception_ptr> errors(num_items);
+  std::exception_ptr name_error;
+  // the number of items whose checks run, which include the item failing
+  // the name checks when it fails after its own checks
+  size_t num_checked = 0;
+  try {
+    for (const auto& init : graph.initializer()) {
+      if (!lex_ctx.this_or_ancestor_graph_has(init.name())) {
+        fail_check(init.name() + " in initializer but not in graph input");
       }
-      if (output_names.count(output)) {
-        fail_check(
-            "Graph must be in single static assignment (SSA) form, however '",
-            output,
-            "' has been used as output names multiple times.");
+      num_checked++;
+    }
+    for (const auto& node : graph.node()) {
+      check_node_inputs_defined(node, lex_ctx);
+      // This needs to happen before SSA check since we don't want to recurse
+      // and find that outputs from control flow ops are colliding with names
+      // in the inner block. Nested graphs see the names defined before the
+      // node.
+      if (has_graph_attribute(node)) {
+        errors[num_checked] = check_node_in_graph(node, ctx, lex_ctx);
       }
-      output_names.insert(output);
+      num_checked++;
+      define_node_outputs(node, lex_ctx);
     }
+  } catch (ValidationError&) {
+    name_error = std::current_exception();
+  }
+
+  auto check_item = [&](size_t i) {
+    if (i < num_initializers) {
+      try {
+        check_tensor(graph.initializer(static_cast<int>(i)), ctx);
+      } catch (...) {
+        errors[i] = std::current_exception();
+      }
+      return;
+    }
+    const auto& node = graph.node(static_cast<int>(i - num_initializers));
+    if (!has_graph_attribute(node)) {
+      // lex_ctx is only read for nested graphs
+      errors[i] = check_node_in_graph(node, ctx, lex_ctx);
+    }
+  };
+  if (ctx.get_thread_pool() != nullptr) {
+    ctx.get_thread_pool()->ParallelFor(num_checked, check_item);
+  } else {
+    for (size_t i = 0; i < num_checked; i++) {
+      check_item(i);
+    }
+  }
+
+  for (size_t i = 0; i < num_checked; i++) {
+    if (errors[i]) {
+      std::rethrow_exception(errors[i]);
+    }
+  }
+  if (name_error) {
+    std::rethrow_exception(name_error);
   }
 }
 
-void check_model(const ModelProto& model) {
+namespace {
+
+// Checks the fields of model other than its graph, and returns the context
+// to check its graph in.
+CheckerContext check_model_fields(const ModelProto& model) {
   if (!model.ir_version()) {
     fail_check("The model does not have an ir_version set properly.");
   }
@@ -376,7 +675,6 @@ void check_model(const ModelProto& model) {
       }
     }
   }
-  std::unordered_map<std::string, int> versions;
   CheckerContext ctx;
   ctx.set_ir_version(static_cast<int>(model.ir_version()));
   std::unordered_map<std::string, int> opset_imports;
@@ -396,10 +694,191 @@ void check_model(const ModelProto& model) {
           "model with IR version < 3 cannot have opset_import specified");
   }
   ctx.set_opset_imports(opset_imports);
+  return ctx;
+}
+
+} // namespace
+
+void check_model(const ModelProto& model, size_t num_threads) {
+  CheckerContext ctx = check_model_fields(model);
+  std::unique_ptr<ThreadPool> pool;
+  if (num_threads != 1) {
+    pool.reset(new ThreadPool(num_threads));
+    ctx.set_thread_pool(pool.get());
+  }
   LexicalScopeContext lex_ctx;
   check_graph(model.graph(), ctx, lex_ctx);
 }
 
+void check_model_and_infer_shapes(ModelProto& model) {
+  CheckerContext ctx = check_model_fields(model);
+  auto* graph = model.mutable_graph();
+  LexicalScopeContext parent_lex;
+  LexicalScopeContext lex_ctx(&parent_lex);
+  check_graph_inputs_and_outputs(*graph, ctx, lex_ctx);
+  for (const auto& init : graph->initializer()) {
+    if (!lex_ctx.this_or_ancestor_graph_has(init.name())) {
+      fail_check(init.name() + " in initializer but not in graph input");
+    }
+    check_tensor(init, ctx);
+  }
+
+  // Every value of the graph gets a type, and the name of every output of a
+  // node is recorded, so both tables are sized for all of them up front.
+  size_t num_values = static_cast<size_t>(
+      graph->value_info_size() + graph->input_size() + graph->output_size());
+  for (const auto& node : graph->node()) {
+    num_values += static_cast<size_t>(node.output_size());
+  }
+  lex_ctx.output_names.reserve(num_values);
+  std::unordered_map<std::string, TypeProto*> valueTypesByName;
+  valueTypesByName.reserve(num_values);
+  for (auto& vi : *graph->mutable_value_info()) {
+    valueTypesByName[vi.name()] = vi.mutable_type();
+  }
+  for (auto& vi : *graph->mutable_input()) {
+    valueTypesByName[vi.name()] = vi.mutable_type();
+  }
+  for (auto& vi : *graph->mutable_output()) {
+    valueTypesByName[vi.name()] = vi.mutable_type();
+  }
+
+  // The first inference error is only thrown once the whole graph is known
+  // to be valid, as it would be by running inference after checking.
+  std::exception_ptr inference_error;
+  std::vector<DataTypeId> input_types;
+  for (const auto& node : graph->node()) {
+    check_node_inputs_defined(node, lex_ctx);
+    const OpSchema* schema = nullptr;
+    try {
+      schema = check_node_and_resolve_schema(node, ctx, lex_ctx);
+    } catch (ValidationError& ex) {
+      ex.AppendContext("Bad node spec: " + ProtoDebugString(node));
+      throw;
+    }
+    define_node_outputs(node, lex_ctx);
+    if (inference_error) {
+      continue;
+    }
+    try {
+      input_types.assign(
+          static_cast<size_t>(node.input_size()), kUndefinedDataTypeId);
+      for (int i = 0; i < node.input_size(); ++i) {
+        auto iter = valueTypesByName.find(node.input(i));
+        if (iter != valueTypesByName.end()) {
+          input_types[static_cast<size_t>(i)] =
+              Utils::DataTypeUtils::ToTypeId(*iter->second);
+        }
+      }
+      schema->CheckInputTypes(input_types);
+      shape_inference::InferenceContextImpl infer_ctx(node, valueTypesByName);
+      schema->GetTypeAndShapeInferenceFunction()(infer_ctx);
+      shape_inference::mergeNodeOutputTypes(
+          node, infer_ctx.allOutputTypes_, graph, valueTypesByName);
+    } catch (...) {
+      inference_error = std::current_exception();
+    }
+  }
+  if (inference_error) {
+    std::rethrow_exception(inference_error);
+  }
+}
+
+void check_graph(
+    Graph& graph,
+    const CheckerContext& ctx,
+    const LexicalScopeContext& parent_lex) {
+  if (!graph.has_name()) {
+    fail_check("Field 'name' of graph is required but missing.");
+  }
+
+  LexicalScopeContext lex_ctx(&parent_lex);
+  for (auto* v : graph.inputs()) {
+    auto name = v->uniqueName();
+    if (lex_ctx.output_names.count(name)) {
+      fail_check(
+          "Graph must be in single static assignment (SSA) form, however '",
+          name,
+          "' has been used as graph input names multiple times.");
+    }
+    lex_ctx.output_names.insert(std::move(name));
+  }
+  for (const auto& name : graph.initializer_names()) {
+    if (!lex_ctx.this_or_ancestor_graph_has(name)) {
+      fail_check(name + " in initializer but not in graph input");
+    }
+  }
+
+  for (auto* n : graph.nodes()) {
+    if (n->kind() == kUndefined || n->kind() == kCaptured) {
+      continue;
+    }
+    // the node as it would be exported, but with empty nested graphs, which
+    // are checked as Graphs
+    NodeProto node;
+    for (auto* v : n->inputs()) {
+      node.add_input(v->node()->kind() == kUndefined ? "" : v->uniqueName());
+    }
+    for (auto* v : n->outputs()) {
+      node.add_output(v->uniqueName());
+    }
+    node.set_op_type(n->kind().toString());
+    if (n->has_name()) {
+      node.set_name(n->name());
+    }
+    if (n->has_domain()) {
+      node.set_domain(n->domain());
+    }
+    std::vector<Graph*> nested_graphs;
+    for (auto name : n->attributeNames()) {
+      if (n->kindOf(name) == AttributeKind::g) {
+        auto* attr = node.add_attribute();
+        attr->set_name(name.toString());
+        attr->set_type(AttributeProto::GRAPH);
+        attr->mutable_g();
+        nested_graphs.push_back(n->g(name).get());
+      } else if (n->kindOf(name) == AttributeKind::gs) {
+        auto* attr = node.add_attribute();
+        attr->set_name(name.toString());
+        attr->set_type(AttributeProto::GRAPHS);
+        for (const auto& g : n->gs(name)) {
+          attr->add_graphs();
+          nested_graphs.push_back(g.get());
+        }
+      } else {
+        addAttribute(&node, n, name);
+      }
+    }
+
+    check_node_inputs_defined(node, lex_ctx);
+    try {
+      for (auto* g : nested_graphs) {
+        check_graph(*g, ctx, lex_ctx);
+      }
+      check_node_and_resolve_schema(node, ctx, lex_ctx, false);
+    } catch (ValidationError& ex) {
+      ex.AppendContext("Bad node spec: " + ProtoDebugString(node));
+      throw;
+    }
+    define_node_outputs(node, lex_ctx);
+  }
+}
+
+void check_graph(Graph& graph) {
+  CheckerContext ctx;
+  ctx.set_ir_version(IR_VERSION);
+  std::unordered_map<std::string, int> opset_imports;
+  for (const auto& opset : graph.opset_versions()) {
+    opset_imports[opset.domain()] = static_cast<int>(opset.version());
+  }
+  if (opset_imports.empty()) {
+    fail_check("graph must specify opset_import for ONNX");
+  }
+  ctx.set_opset_imports(opset_imports);
+  LexicalScopeContext lex_ctx;
+  check_graph(graph, ctx, lex_ctx);
+}
+
 #undef fail_check
 #undef enforce_has_field
 #undef enforce_has_repeated_field
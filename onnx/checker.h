@@ -1,8 +1,13 @@
 #pragma once
 
+#include <functional>
+#include <memory>
 #include <stdexcept>
 #include <unordered_map>
 #include <unordered_set>
+#include "onnx/common/ir.h"
+#include "onnx/common/thread_pool.h"
+#include "onnx/defs/schema.h"
 #include "onnx/onnx_pb.h"
 #include "onnx/string_utils.h"
 
@@ -42,6 +47,11 @@ class CheckerContext final {
   }
   void set_opset_imports(std::unordered_map<std::string, int> imps) {
     opset_imports_ = std::move(imps);
+    schemas_ = std::make_shared<const OpSchemaTable>(opset_imports_);
+  }
+  // The schemas of the operators of the imported operator sets.
+  const OpSchemaTable& get_schemas() const {
+    return *schemas_;
   }
   bool is_main_graph() const {
 	return is_main_graph_;
@@ -49,6 +59,14 @@ class CheckerContext final {
   void set_is_main_graph(bool is_main_graph) {
 	  is_main_graph_ = is_main_graph;
   }
+  // The nodes and initializers of a graph are checked concurrently on the
+  // pool when set.
+  ThreadPool* get_thread_pool() const {
+    return thread_pool_;
+  }
+  void set_thread_pool(ThreadPool* thread_pool) {
+    thread_pool_ = thread_pool;
+  }
 
   explicit CheckerContext() : ir_version_(-1) {}
 
@@ -56,15 +74,55 @@ private:
 	int ir_version_;
 	std::unordered_map<std::string, int> opset_imports_;
 	bool is_main_graph_ = true;
+	ThreadPool* thread_pool_ = nullptr;
+	std::shared_ptr<const OpSchemaTable> schemas_ =
+	    std::make_shared<const OpSchemaTable>(opset_imports_);
 };
 
+// The names defined in a graph, and in the graphs it is nested in. A scope
+// refers to the scope of its parent graph, which must outlive it, instead
+// of copying its names.
 struct LexicalScopeContext final {
+  LexicalScopeContext() = default;
+  explicit LexicalScopeContext(const LexicalScopeContext* parent)
+      : parent(parent) {}
+
+  // Returns true if name is defined in this graph or in a parent graph.
+  bool this_or_ancestor_graph_has(const std::string& name) const {
+    for (auto* scope = this; scope != nullptr; scope = scope->parent) {
+      if (scope->output_names.count(name) > 0) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // the names defined in this graph so far
   std::unordered_set<std::string> output_names;
+  const LexicalScopeContext* parent = nullptr;
 };
 
 using IR_VERSION_TYPE = decltype(Version::IR_VERSION);
 void check_value_info(const ValueInfoProto& value_info, const CheckerContext&);
 void check_tensor(const TensorProto& tensor, const CheckerContext&);
+// Checks tensor like check_tensor, when its raw data of raw_data_size bytes
+// is stored outside of it, e.g. in a file which is mapped or read lazily.
+// Only its fields are read, so tensor must contain no value field.
+void check_tensor_metadata(
+    const TensorProto& tensor,
+    uint64_t raw_data_size,
+    const CheckerContext&);
+// Checks tensor like check_tensor_metadata, then checks that its raw data
+// holds no NaN or infinity. The data is read in chunks of at most
+// chunk_size bytes, each by calling read(buffer, size), which must copy the
+// next size bytes to buffer. Each chunk is scanned on the thread pool of
+// the context when set.
+void check_tensor_finite(
+    const TensorProto& tensor,
+    uint64_t raw_data_size,
+    const std::function<void(char*, size_t)>& read,
+    const CheckerContext&,
+    size_t chunk_size = 1 << 24);
 void check_attribute(
     const AttributeProto& attr,
     const CheckerContext&,
@@ -77,6 +135,29 @@ void check_graph(
     const GraphProto& graph,
     const CheckerContext&,
     const LexicalScopeContext&);
-void check_model(const ModelProto& model);
+// Checks model, on num_threads threads, or on all the hardware threads if
+// num_threads is 0. Errors are reported as if the model was checked in
+// order on one thread.
+void check_model(const ModelProto& model, size_t num_threads = 1);
+// Checks model and infers the types and shapes of the values of its main
+// graph, adding them to its value_info, in one pass over the graph which
+// looks up the schema of each node once. The known types of the inputs of
+// each node are checked against its schema before its outputs are
+// inferred. Besides the errors of check_model and InferShapes, this throws
+// a ValidationError when the type of an input of a node is not allowed by
+// its schema, or differs from that of another input of the same type
+// constraint, in place of the inference error of the node. Errors are
+// reported as if the model was checked before running inference on it,
+// but value_info may be partially updated when this throws.
+void check_model_and_infer_shapes(ModelProto& model);
+// Checks graph like check_graph checks the graph it exports to, without
+// converting it. The payloads of its initializers are not checked.
+void check_graph(
+    Graph& graph,
+    const CheckerContext&,
+    const LexicalScopeContext&);
+// Checks graph like check_model checks the model it exports to, with the
+// operator sets graph imports.
+void check_graph(Graph& graph);
 } // namespace checker
 } // namespace ONNX_NAMESPACE
@@ -72,8 +72,32 @@ def check_graph(graph, ctx=DEFAULT_CONTEXT):
     pass
 
 
-def check_model(model):
-    C.check_model(model.SerializeToString())
+# Checks tensor like check_tensor, when its raw data of raw_data_size bytes is
+# stored outside of it, so that tensor must contain no value field.
+def check_tensor_metadata(tensor, raw_data_size, ctx=DEFAULT_CONTEXT):
+    if not isinstance(tensor, TensorProto):
+        raise RuntimeError(
+            'You cannot pass an object that is not of type TensorProto')
+    C.check_tensor_metadata(tensor.SerializeToString(), raw_data_size, ctx)
+
+
+# Checks tensor like check_tensor_metadata, then checks that raw_data, its
+# raw data stored outside of it, holds no NaN or infinity. raw_data is
+# scanned in chunks of at most chunk_size bytes, each on num_threads threads,
+# or on all the hardware threads if num_threads is 0. The byte offset in the
+# error raised is the same for any chunk size and number of threads.
+def check_tensor_finite(tensor, raw_data, ctx=DEFAULT_CONTEXT, chunk_size=1 << 24, num_threads=1):
+    if not isinstance(tensor, TensorProto):
+        raise RuntimeError(
+            'You cannot pass an object that is not of type TensorProto')
+    C.check_tensor_finite(tensor.SerializeToString(), raw_data, ctx, chunk_size, num_threads)
+
+
+# The nodes and initializers of each graph are checked on num_threads threads,
+# or on all the hardware threads if num_threads is 0. The error raised is the
+# same for any number of threads.
+def check_model(model, num_threads=1):
+    C.check_model(model.SerializeToString(), num_threads)
 
 
 ValidationError = C.ValidationError
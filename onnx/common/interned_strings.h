@@ -135,6 +135,11 @@ _(body) \
 _(then_branch) \
 _(else_branch) \
 _(Captured) \
+_(MatMul) \
+_(Flatten) \
+_(Unsqueeze) \
+_(Shape) \
+_(Dropout) \
 _(__control_inputs)
 
 enum BuiltinSymbol {
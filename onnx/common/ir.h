@@ -410,6 +410,8 @@ private:
   std::string name_;
   bool has_doc_string_;
   std::string doc_string_;
+  bool has_domain_;
+  std::string domain_;
 
 protected:
   Node(Graph * graph_, NodeKind kind_); //defined after graph
@@ -435,6 +437,18 @@ public:
     has_doc_string_ = true;
     doc_string_ = std::move(doc_string);
   }
+  bool has_domain() const {
+    return has_domain_;
+  }
+  // The operator set the kind of this node belongs to; empty for the
+  // default ONNX domain.
+  const std::string& domain() const {
+    return domain_;
+  }
+  void setDomain(std::string domain) {
+    has_domain_ = true;
+    domain_ = std::move(domain);
+  }
   NodeKind kind() const {
     return kind_;
   }
@@ -783,6 +797,26 @@ protected:
   }
 };
 
+// An operator set imported by a model: a domain and its version.
+struct OpSetID final {
+  OpSetID(std::string domain, int64_t version)
+  : domain_(std::move(domain)), version_(version) {}
+
+  const std::string& domain() const {
+    return domain_;
+  }
+  int64_t version() const {
+    return version_;
+  }
+  void setVersion(int64_t version) {
+    version_ = version;
+  }
+
+private:
+  std::string domain_;
+  int64_t version_;
+};
+
 struct Graph final {
 ONNX_DISALLOW_COPY_AND_ASSIGN(Graph);
 friend struct Node;
@@ -814,6 +848,8 @@ private:
   bool has_doc_string_;
   std::string doc_string_;
 
+  std::vector<OpSetID> opset_versions_;
+
 public:
   Graph()
   : next_unique_(0)
@@ -837,6 +873,15 @@ public:
     initializers_.push_back(std::move(initializer));
     initializer_names_.push_back(std::move(name));
   }
+  void eraseInitializer(const std::string& name) {
+    for (size_t i = 0; i < initializer_names_.size(); i++) {
+      if (initializer_names_[i] == name) {
+        initializers_.erase(initializers_.begin() + static_cast<std::ptrdiff_t>(i));
+        initializer_names_.erase(initializer_names_.begin() + static_cast<std::ptrdiff_t>(i));
+        return;
+      }
+    }
+  }
   void clearInitializers() {
     initializers_.clear();
     initializer_names_.clear();
@@ -979,6 +1024,24 @@ public:
     name_ = name;
   }
 
+  // Operator sets imported by the model, only set on the main graph.
+  std::vector<OpSetID>& opset_versions_mutable() {
+    return opset_versions_;
+  }
+  const std::vector<OpSetID>& opset_versions() const {
+    return opset_versions_;
+  }
+  // Imports version `version` of `domain` unless the domain is already
+  // imported.
+  void addOpSetImport(const std::string& domain, int64_t version) {
+    for (const auto& opset : opset_versions_) {
+      if (opset.domain() == domain) {
+        return;
+      }
+    }
+    opset_versions_.emplace_back(domain, version);
+  }
+
   friend std::ostream& operator<<(std::ostream & out, const Graph & g);
 
 private:
@@ -1036,7 +1099,8 @@ inline Node::Node(Graph * graph_, NodeKind kind_) :
   graph_(graph_),
   stage_(graph_->new_node_stage_),
   has_name_(false),
-  has_doc_string_(false) {
+  has_doc_string_(false),
+  has_domain_(false) {
   graph_->all_nodes.emplace(this);
 }
 
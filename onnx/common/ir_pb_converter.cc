@@ -252,6 +252,9 @@ std::unique_ptr<Graph> graphProtoToGraph(const ONNX_NAMESPACE::GraphProto& gp, b
     if (np.has_name()) {
       n->setName(np.name());
     }
+    if (np.has_domain()) {
+      n->setDomain(np.domain());
+    }
   }
 
   for (auto n : g->nodes()) {
@@ -299,7 +302,12 @@ std::unique_ptr<Graph> ImportModelProto(const ONNX_NAMESPACE::ModelProto& mp) {
     return nullptr;
   }
 
-  return graphProtoToGraph(mp.graph(), false);
+  std::unique_ptr<Graph> g(graphProtoToGraph(mp.graph(), false));
+  for (int i = 0; i < mp.opset_import_size(); i++) {
+    const auto& opset = mp.opset_import(i);
+    g->opset_versions_mutable().emplace_back(opset.domain(), opset.version());
+  }
+  return g;
 }
 
 
@@ -450,9 +458,8 @@ void encodeTypeProtoTensorType(ONNX_NAMESPACE::TypeProto_Tensor* tensor_type, Va
 }
 
 void encodeValueInfo(ONNX_NAMESPACE::ValueInfoProto* v, Value* n) {
-  if (n->has_unique_name()) {
-    v->set_name(value_name(n));
-  }
+  // values created by passes have no name until one is generated
+  v->set_name(value_name(n));
   ONNX_NAMESPACE::TypeProto* t = v->mutable_type();
   ONNX_NAMESPACE::TypeProto_Tensor* tensor_type = t->mutable_tensor_type();
   encodeTypeProtoTensorType(tensor_type, n);
@@ -519,6 +526,9 @@ void encodeGraph(ONNX_NAMESPACE::GraphProto * p_g, const std::shared_ptr<Graph>
     if (node->has_name()) {
       p_n->set_name(node->name());
     }
+    if (node->has_domain()) {
+      p_n->set_domain(node->domain());
+    }
   }
 
   auto num_initializers = g->initializers().size();
@@ -530,8 +540,16 @@ void encodeGraph(ONNX_NAMESPACE::GraphProto * p_g, const std::shared_ptr<Graph>
 }
 
 void ExportModelProto(ONNX_NAMESPACE::ModelProto* p_m, const std::shared_ptr<Graph>& g) {
+  p_m->clear_graph();
   ONNX_NAMESPACE::GraphProto* p_g = p_m->mutable_graph();
   encodeGraph(p_g, g);
+  // passes may have imported new operator sets
+  p_m->clear_opset_import();
+  for (const auto& opset : g->opset_versions()) {
+    auto* p_opset = p_m->add_opset_import();
+    p_opset->set_domain(opset.domain());
+    p_opset->set_version(opset.version());
+  }
 }
 
 } // namespace ONNX_NAMESPACE
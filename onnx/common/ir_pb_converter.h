@@ -11,4 +11,10 @@ namespace ONNX_NAMESPACE {
 void ExportModelProto(ONNX_NAMESPACE::ModelProto* p_m, const std::shared_ptr<Graph>& g);
 std::unique_ptr<Graph> ImportModelProto(const ONNX_NAMESPACE::ModelProto& mp);
 
+// Converters for the parts of a model, used to check and infer graphs
+// without converting them entirely.
+std::vector<Dimension> tensorShapeProtoToDimensions(const ONNX_NAMESPACE::TensorShapeProto & tsp);
+void addAttribute(ONNX_NAMESPACE::NodeProto * n_p, Node * n, Symbol name);
+void encodeTypeProtoTensorType(ONNX_NAMESPACE::TypeProto_Tensor* tensor_type, Value* n);
+
 } // namespace ONNX_NAMESPACE
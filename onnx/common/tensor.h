@@ -3,6 +3,10 @@
 
 #pragma once
 
+#include <string>
+#include <vector>
+
+#include "onnx/common/assertions.h"
 #include "onnx/onnx_pb.h"
 
 namespace ONNX_NAMESPACE {
@@ -139,6 +143,125 @@ public:
     has_name_ = true;
     name_ = std::move(name);
   }
+
+  // Permutes the dimensions of the tensor and moves its data accordingly,
+  // with the same semantics as the Transpose operator: dimension i of the
+  // result is dimension perm[i] of the original tensor.
+  void transpose(const std::vector<int64_t>& perm);
+
+private:
+  template <typename T>
+  static void permute(std::vector<T>& data, const std::vector<size_t>& src_index, size_t chunk) {
+    ONNX_ASSERT(data.size() == src_index.size() * chunk);
+    std::vector<T> result(data.size());
+    for (size_t i = 0; i < src_index.size(); ++i) {
+      for (size_t c = 0; c < chunk; ++c) {
+        result[i * chunk + c] = data[src_index[i] * chunk + c];
+      }
+    }
+    data.swap(result);
+  }
 };
 
+// Size in bytes of a single element of the given type when stored in
+// raw_data, or 0 for types that cannot be stored there.
+inline size_t elementByteSize(ONNX_NAMESPACE::TensorProto_DataType elem_type) {
+  switch (elem_type) {
+    case ONNX_NAMESPACE::TensorProto_DataType_BOOL:
+    case ONNX_NAMESPACE::TensorProto_DataType_INT8:
+    case ONNX_NAMESPACE::TensorProto_DataType_UINT8:
+      return 1;
+    case ONNX_NAMESPACE::TensorProto_DataType_FLOAT16:
+    case ONNX_NAMESPACE::TensorProto_DataType_INT16:
+    case ONNX_NAMESPACE::TensorProto_DataType_UINT16:
+      return 2;
+    case ONNX_NAMESPACE::TensorProto_DataType_FLOAT:
+    case ONNX_NAMESPACE::TensorProto_DataType_INT32:
+    case ONNX_NAMESPACE::TensorProto_DataType_UINT32:
+      return 4;
+    case ONNX_NAMESPACE::TensorProto_DataType_DOUBLE:
+    case ONNX_NAMESPACE::TensorProto_DataType_INT64:
+    case ONNX_NAMESPACE::TensorProto_DataType_UINT64:
+    case ONNX_NAMESPACE::TensorProto_DataType_COMPLEX64:
+      return 8;
+    case ONNX_NAMESPACE::TensorProto_DataType_COMPLEX128:
+      return 16;
+    default:
+      return 0;
+  }
+}
+
+inline void Tensor::transpose(const std::vector<int64_t>& perm) {
+  const size_t rank = sizes_.size();
+  ONNX_ASSERT(perm.size() == rank);
+
+  std::vector<size_t> in_strides(rank, 1);
+  for (size_t i = rank; i > 1; --i) {
+    in_strides[i - 2] = in_strides[i - 1] * static_cast<size_t>(sizes_[i - 1]);
+  }
+  std::vector<int64_t> out_sizes(rank);
+  size_t num_elements = 1;
+  for (size_t i = 0; i < rank; ++i) {
+    out_sizes[i] = sizes_[static_cast<size_t>(perm[i])];
+    num_elements *= static_cast<size_t>(out_sizes[i]);
+  }
+
+  // src_index[i] is the position in the original data of the i-th element
+  // of the transposed tensor.
+  std::vector<size_t> src_index(num_elements);
+  std::vector<int64_t> counter(rank, 0);
+  for (size_t i = 0; i < num_elements; ++i) {
+    size_t src = 0;
+    for (size_t d = 0; d < rank; ++d) {
+      src += static_cast<size_t>(counter[d]) * in_strides[static_cast<size_t>(perm[d])];
+    }
+    src_index[i] = src;
+    for (size_t d = rank; d > 0; --d) {
+      if (++counter[d - 1] < out_sizes[d - 1]) {
+        break;
+      }
+      counter[d - 1] = 0;
+    }
+  }
+
+  if (!raw_data_.empty()) {
+    size_t elem_size = elementByteSize(elem_type_);
+    ONNX_ASSERT(elem_size != 0 && raw_data_.size() == num_elements * elem_size);
+    std::string result(raw_data_.size(), '\0');
+    for (size_t i = 0; i < num_elements; ++i) {
+      raw_data_.copy(&result[i * elem_size], elem_size, src_index[i] * elem_size);
+    }
+    raw_data_.swap(result);
+  } else {
+    switch (elem_type_) {
+      case ONNX_NAMESPACE::TensorProto_DataType_FLOAT:
+        permute(float_data_, src_index, 1);
+        break;
+      case ONNX_NAMESPACE::TensorProto_DataType_COMPLEX64:
+        permute(float_data_, src_index, 2);
+        break;
+      case ONNX_NAMESPACE::TensorProto_DataType_DOUBLE:
+        permute(double_data_, src_index, 1);
+        break;
+      case ONNX_NAMESPACE::TensorProto_DataType_COMPLEX128:
+        permute(double_data_, src_index, 2);
+        break;
+      case ONNX_NAMESPACE::TensorProto_DataType_INT64:
+        permute(int64_data_, src_index, 1);
+        break;
+      case ONNX_NAMESPACE::TensorProto_DataType_UINT32:
+      case ONNX_NAMESPACE::TensorProto_DataType_UINT64:
+        permute(uint64_data_, src_index, 1);
+        break;
+      case ONNX_NAMESPACE::TensorProto_DataType_STRING:
+        permute(string_data_, src_index, 1);
+        break;
+      default:
+        permute(int32_data_, src_index, 1);
+        break;
+    }
+  }
+  sizes_ = std::move(out_sizes);
+}
+
 } // namespace ONNX_NAMESPACE
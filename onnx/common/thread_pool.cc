@@ -0,0 +1,120 @@
+// ATTENTION: The code in this file is highly EXPERIMENTAL.
+// Adventurous users should note that the APIs will probably change.
+
+#include "onnx/common/thread_pool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <memory>
+
+namespace ONNX_NAMESPACE {
+
+namespace {
+
+// The state of a ParallelFor loop, shared with the workers helping with it,
+// which may only start once the loop has returned.
+struct Loop {
+  Loop(size_t n, const std::function<void(size_t)>& fn)
+    : n(n), fn(fn), next(0), done(0) {}
+
+  // Runs iterations until there are none left to start.
+  void work() {
+    for (size_t i = next++; i < n; i = next++) {
+      try {
+        fn(i);
+      } catch (...) {
+        std::lock_guard<std::mutex> guard(mutex);
+        if (!error) {
+          error = std::current_exception();
+        }
+      }
+      std::lock_guard<std::mutex> guard(mutex);
+      if (++done == n) {
+        finished.notify_all();
+      }
+    }
+  }
+
+  const size_t n;
+  // only called while the loop runs
+  const std::function<void(size_t)>& fn;
+  std::atomic<size_t> next;
+  size_t done;
+  std::exception_ptr error;
+  std::mutex mutex;
+  std::condition_variable finished;
+};
+
+} // namespace
+
+ThreadPool::ThreadPool(size_t num_threads) {
+  if (num_threads == 0) {
+    num_threads = std::thread::hardware_concurrency();
+  }
+  for (size_t i = 1; i < num_threads; i++) {
+    workers_.emplace_back([this] { run(); });
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> guard(mutex_);
+    stopping_ = true;
+  }
+  wake_.notify_all();
+  for (auto& worker : workers_) {
+    worker.join();
+  }
+}
+
+void ThreadPool::run() {
+  for (;;) {
+    std::function<void()> task;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      wake_.wait(lock, [this] { return stopping_ || !tasks_.empty(); });
+      if (tasks_.empty()) {
+        return;
+      }
+      task = std::move(tasks_.front());
+      tasks_.pop_front();
+    }
+    task();
+  }
+}
+
+void ThreadPool::ParallelFor(size_t n, const std::function<void(size_t)>& fn) {
+  if (n == 0) {
+    return;
+  }
+  if (n == 1 || workers_.empty()) {
+    for (size_t i = 0; i < n; i++) {
+      fn(i);
+    }
+    return;
+  }
+  auto loop = std::make_shared<Loop>(n, fn);
+  size_t helpers = std::min(n - 1, workers_.size());
+  {
+    std::lock_guard<std::mutex> guard(mutex_);
+    for (size_t i = 0; i < helpers; i++) {
+      // a helper starting after the last iteration has started does nothing,
+      // and never reads fn
+      tasks_.emplace_back([loop] { loop->work(); });
+    }
+  }
+  if (helpers == 1) {
+    wake_.notify_one();
+  } else {
+    wake_.notify_all();
+  }
+  loop->work();
+  std::unique_lock<std::mutex> lock(loop->mutex);
+  loop->finished.wait(lock, [&loop] { return loop->done == loop->n; });
+  if (loop->error) {
+    std::rethrow_exception(loop->error);
+  }
+}
+
+} // namespace ONNX_NAMESPACE
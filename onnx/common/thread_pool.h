@@ -0,0 +1,46 @@
+// ATTENTION: The code in this file is highly EXPERIMENTAL.
+// Adventurous users should note that the APIs will probably change.
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ONNX_NAMESPACE {
+
+// A fixed set of worker threads running the iterations of ParallelFor loops.
+struct ThreadPool final {
+  // Runs loops on num_threads threads, the calling thread included, or on
+  // all the hardware threads if num_threads is 0.
+  explicit ThreadPool(size_t num_threads = 0);
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  size_t num_threads() const {
+    return workers_.size() + 1;
+  }
+
+  // Calls fn(i) for every i in [0, n), on the workers and on the calling
+  // thread, and returns once all the calls have returned. The calling thread
+  // runs the iterations no worker has started, so loops can be nested in fn
+  // without waiting for busy workers. If calls throw, the first exception is
+  // rethrown once the others have returned.
+  void ParallelFor(size_t n, const std::function<void(size_t)>& fn);
+
+ private:
+  void run();
+
+  std::vector<std::thread> workers_;
+  std::deque<std::function<void()>> tasks_;
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  bool stopping_ = false;
+};
+
+} // namespace ONNX_NAMESPACE
@@ -0,0 +1,53 @@
+"""onnx cost estimation. Estimates the number of operations and the bytes
+read and written by the nodes of a model, from the cost functions of the
+operator schemas.
+
+"""
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+from __future__ import unicode_literals
+
+from collections import namedtuple
+
+import onnx.onnx_cpp2py_export.cost as C
+from onnx import ModelProto
+
+# Each field is -1 if it is not known.
+OpCost = namedtuple('OpCost', ['flops', 'bytes_read', 'bytes_written'])
+
+NodeCost = namedtuple('NodeCost', ['name', 'op_type', 'cost'])
+
+# total is the sum of the known node costs, and num_unknown the number of
+# nodes whose cost is not known.
+GraphCost = namedtuple('GraphCost', ['nodes', 'total', 'num_unknown'])
+
+"""Estimate the cost of each node of the main graph of the provided
+ModelProto.
+
+Shape inference is run first, and the cost of a node is only known if the
+sizes of its inputs and outputs are. Nodes whose op has no cost function
+have an unknown cost.
+
+Arguments:
+    input (ModelProto): ModelProto
+
+Return:
+    return (GraphCost) cost of each node in graph order, and their total
+"""
+
+
+def estimate_cost(model):
+    if not isinstance(model, ModelProto):
+        raise ValueError('Cost estimation only accepts ModelProto, '
+                         'incorrect type: {}'.format(type(model)))
+
+    model_str = model.SerializeToString()
+    nodes = [NodeCost(name, op_type, OpCost(flops, bytes_read, bytes_written))
+             for name, op_type, flops, bytes_read, bytes_written
+             in C.estimate_cost(model_str)]
+    known = [n.cost for n in nodes if min(n.cost) >= 0]
+    total = OpCost(sum(c.flops for c in known),
+                   sum(c.bytes_read for c in known),
+                   sum(c.bytes_written for c in known))
+    return GraphCost(nodes, total, len(nodes) - len(known))
@@ -0,0 +1,146 @@
+#pragma once
+
+#include "onnx/defs/schema.h"
+#include "onnx/proto_utils.h"
+#include "onnx/shape_inference/implementation.h"
+#include "onnx/string_utils.h"
+
+namespace ONNX_NAMESPACE {
+namespace cost {
+
+struct CostContextImpl : public InferenceContext {
+  CostContextImpl(
+      const NodeProto& n,
+      const std::unordered_map<std::string, TypeProto*>& valueTypesByName) {
+    for (const auto& attr : n.attribute()) {
+      attributesByName_[attr.name()] = &attr;
+    }
+
+    for (const auto& input : n.input()) {
+      if (input.empty()) {
+        allInputTypes_.push_back(nullptr);
+        continue;
+      }
+      auto iter = valueTypesByName.find(input);
+      if (iter != valueTypesByName.end()) {
+        allInputTypes_.push_back(iter->second);
+      } else {
+        allInputTypes_.push_back(&unknownType_);
+      }
+    }
+
+    for (const auto& output : n.output()) {
+      auto iter = valueTypesByName.find(output);
+      allOutputTypes_.push_back(
+          iter != valueTypesByName.end() ? *iter->second : TypeProto());
+      hasOutput_.push_back(!output.empty());
+    }
+  }
+
+  const AttributeProto* getAttribute(const std::string& name) const override {
+    auto iter = attributesByName_.find(name);
+    if (iter == attributesByName_.end()) {
+      return nullptr;
+    } else {
+      return iter->second;
+    }
+  }
+  size_t getNumInputs() const override {
+    return allInputTypes_.size();
+  }
+
+  const TypeProto* getInputType(size_t index) const override {
+    if (index >= allInputTypes_.size()) {
+      throw std::runtime_error(
+          "input " + ONNX_NAMESPACE::to_string(index) + " is out of bounds");
+    }
+    return allInputTypes_[index];
+  }
+
+  size_t getNumOutputs() const override {
+    return allOutputTypes_.size();
+  }
+
+  TypeProto* getOutputType(size_t index) override {
+    if (index >= allOutputTypes_.size()) {
+      throw std::runtime_error(
+          "output " + ONNX_NAMESPACE::to_string(index) + " is out of bounds");
+    }
+    return hasOutput_[index] ? &allOutputTypes_[index] : nullptr;
+  }
+  std::unordered_map<std::string, const AttributeProto*> attributesByName_;
+  std::vector<const TypeProto*> allInputTypes_;
+  std::vector<TypeProto> allOutputTypes_;
+  std::vector<bool> hasOutput_;
+  // the type of the inputs whose type is not known
+  TypeProto unknownType_;
+};
+
+struct NodeCost {
+  std::string name;
+  std::string op_type;
+  OpCost cost;
+};
+
+struct GraphCost {
+  std::vector<NodeCost> nodes;
+  // the sum of the known node costs
+  OpCost total;
+  size_t num_unknown = 0;
+};
+
+// Estimates the cost of each node of the main graph of m, after running
+// shape inference. The cost of the nodes without a schema or a cost
+// function is unknown.
+inline GraphCost EstimateCost(const ModelProto& m) {
+  ModelProto inferred = m;
+  shape_inference::InferShapes(inferred);
+
+  std::unordered_map<std::string, int> opset_imports;
+  for (const auto& opset_import : inferred.opset_import()) {
+    opset_imports[opset_import.domain()] =
+        static_cast<int>(opset_import.version());
+  }
+  const OpSchemaTable schemas(opset_imports);
+
+  auto* g = inferred.mutable_graph();
+  std::unordered_map<std::string, TypeProto*> valueTypesByName;
+  for (auto& vi : *g->mutable_value_info()) {
+    valueTypesByName[vi.name()] = vi.mutable_type();
+  }
+  for (auto& vi : *g->mutable_input()) {
+    valueTypesByName[vi.name()] = vi.mutable_type();
+  }
+  for (auto& vi : *g->mutable_output()) {
+    valueTypesByName[vi.name()] = vi.mutable_type();
+  }
+
+  GraphCost result;
+  result.total.flops = 0;
+  result.total.bytes_read = 0;
+  result.total.bytes_written = 0;
+  for (const auto& n : g->node()) {
+    NodeCost node_cost;
+    node_cost.name = n.name();
+    node_cost.op_type = n.op_type();
+
+    const OpSchema* schema = schemas.Find(n.op_type(), n.domain());
+    if (schema && schema->GetCostFunction()) {
+      CostContextImpl ctx(n, valueTypesByName);
+      node_cost.cost = schema->GetCostFunction()(ctx);
+    }
+
+    if (node_cost.cost.is_known()) {
+      result.total.flops += node_cost.cost.flops;
+      result.total.bytes_read += node_cost.cost.bytes_read;
+      result.total.bytes_written += node_cost.cost.bytes_written;
+    } else {
+      result.num_unknown++;
+    }
+    result.nodes.push_back(std::move(node_cost));
+  }
+  return result;
+}
+
+} // namespace cost
+} // namespace ONNX_NAMESPACE
@@ -2,19 +2,40 @@
 #include <pybind11/stl.h>
 #include <climits>
 #include <limits>
+#include <memory>
 #include <unordered_map>
 
 #include "onnx/checker.h"
+#include "onnx/common/ir_pb_converter.h"
+#include "onnx/common/thread_pool.h"
+#include "onnx/cost/implementation.h"
 #include "onnx/defs/schema.h"
 #include "onnx/optimizer/optimize.h"
+#include "onnx/optimizer/partition.h"
 #include "onnx/py_utils.h"
 #include "onnx/shape_inference/implementation.h"
+#include "onnx/string_utils.h"
 
 namespace ONNX_NAMESPACE {
 
 namespace py = pybind11;
 using namespace pybind11::literals;
 
+namespace {
+
+// A model, and the IncrementalInference which updates it.
+struct IncrementalInferenceModel {
+  explicit IncrementalInferenceModel(const py::bytes& bytes) {
+    ParseProtoFromPyBytes(&model, bytes);
+    inference.reset(new shape_inference::IncrementalInference(model));
+  }
+
+  ModelProto model;
+  std::unique_ptr<shape_inference::IncrementalInference> inference;
+};
+
+} // namespace
+
 PYBIND11_MODULE(onnx_cpp2py_export, onnx_cpp2py_export) {
   onnx_cpp2py_export.doc() = "Python interface to onnx";
 
@@ -40,6 +61,9 @@ PYBIND11_MODULE(onnx_cpp2py_export, onnx_cpp2py_export) {
       .def_property_readonly("outputs", &OpSchema::outputs)
       .def_property_readonly(
           "type_constraints", &OpSchema::typeConstraintParams)
+      .def_property_readonly(
+          "has_cost_function",
+          [](OpSchema* op) -> bool { return op->GetCostFunction() != nullptr; })
       .def_static(
           "is_infinite",
           [](int v) { return v == std::numeric_limits<int>::max(); });
@@ -176,6 +200,49 @@ PYBIND11_MODULE(onnx_cpp2py_export, onnx_cpp2py_export) {
         checker::check_tensor(proto, ctx);
       });
 
+  checker.def(
+      "check_tensor_metadata",
+      [](const py::bytes& bytes,
+         uint64_t raw_data_size,
+         const checker::CheckerContext& ctx) -> void {
+        TensorProto proto{};
+        ParseProtoFromPyBytes(&proto, bytes);
+        checker::check_tensor_metadata(proto, raw_data_size, ctx);
+      });
+
+  checker.def(
+      "check_tensor_finite",
+      [](const py::bytes& bytes,
+         const py::bytes& raw_data,
+         const checker::CheckerContext& ctx,
+         size_t chunk_size,
+         size_t num_threads) -> void {
+        TensorProto proto{};
+        ParseProtoFromPyBytes(&proto, bytes);
+        const std::string data = raw_data;
+        checker::CheckerContext pool_ctx = ctx;
+        std::unique_ptr<ThreadPool> pool;
+        if (num_threads != 1) {
+          pool.reset(new ThreadPool(num_threads));
+          pool_ctx.set_thread_pool(pool.get());
+        }
+        size_t offset = 0;
+        checker::check_tensor_finite(
+            proto,
+            data.size(),
+            [&data, &offset](char* buffer, size_t size) {
+              data.copy(buffer, size, offset);
+              offset += size;
+            },
+            pool_ctx,
+            chunk_size);
+      },
+      "bytes"_a,
+      "raw_data"_a,
+      "ctx"_a,
+      "chunk_size"_a = 1 << 24,
+      "num_threads"_a = 1);
+
   checker.def(
       "check_attribute",
       [](const py::bytes& bytes, const checker::CheckerContext& ctx) -> void {
@@ -202,11 +269,15 @@ PYBIND11_MODULE(onnx_cpp2py_export, onnx_cpp2py_export) {
         checker::check_graph(proto, ctx, lex_ctx);
       });
 
-  checker.def("check_model", [](const py::bytes& bytes) -> void {
-    ModelProto proto{};
-    ParseProtoFromPyBytes(&proto, bytes);
-    checker::check_model(proto);
-  });
+  checker.def(
+      "check_model",
+      [](const py::bytes& bytes, size_t num_threads) -> void {
+        ModelProto proto{};
+        ParseProtoFromPyBytes(&proto, bytes);
+        checker::check_model(proto, num_threads);
+      },
+      "bytes"_a,
+      "num_threads"_a = 1);
 
   // Submodule `optimizer`
   auto optimizer = onnx_cpp2py_export.def_submodule("optimizer");
@@ -223,20 +294,153 @@ PYBIND11_MODULE(onnx_cpp2py_export, onnx_cpp2py_export) {
         return py::bytes(out);
       });
 
+  optimizer.def(
+      "optimize_batch",
+      [](const std::vector<py::bytes>& bytes,
+         const std::vector<std::string>& names,
+         size_t num_threads) {
+        std::vector<ModelProto> protos(bytes.size());
+        for (size_t i = 0; i < bytes.size(); i++) {
+          ParseProtoFromPyBytes(&protos[i], bytes[i]);
+        }
+        std::vector<std::string> outs(protos.size());
+        {
+          py::gil_scoped_release release;
+          auto const results =
+              optimization::OptimizeBatch(protos, names, num_threads);
+          for (size_t i = 0; i < results.size(); i++) {
+            results[i].SerializeToString(&outs[i]);
+          }
+        }
+        std::vector<py::bytes> out;
+        for (const auto& s : outs) {
+          out.emplace_back(s);
+        }
+        return out;
+      });
+
+  // Submodule `partition`
+  auto partition = onnx_cpp2py_export.def_submodule("partition");
+  partition.doc() = "Partitioning submodule";
+
+  partition.def(
+      "partition",
+      [](const py::bytes& bytes, const std::set<std::string>& supported_ops) {
+        ModelProto proto{};
+        ParseProtoFromPyBytes(&proto, bytes);
+        std::vector<ModelProto> partitions;
+        auto const result =
+            optimization::PartitionModel(proto, supported_ops, &partitions);
+        std::string out;
+        result.SerializeToString(&out);
+        std::vector<py::bytes> outs;
+        for (const auto& p : partitions) {
+          std::string s;
+          p.SerializeToString(&s);
+          outs.emplace_back(s);
+        }
+        return std::make_pair(py::bytes(out), outs);
+      });
+
   // Submodule `shape_inference`
   auto shape_inference = onnx_cpp2py_export.def_submodule("shape_inference");
   shape_inference.doc() = "Shape Inference submodule";
 
+  py::class_<shape_inference::InferenceCache>(
+      shape_inference, "InferenceCache")
+      .def(py::init<>())
+      .def_property_readonly("hits", &shape_inference::InferenceCache::hits)
+      .def_property_readonly(
+          "misses", &shape_inference::InferenceCache::misses)
+      .def_property_readonly(
+          "hit_rate", &shape_inference::InferenceCache::hitRate)
+      .def_property_readonly(
+          "saved_seconds", &shape_inference::InferenceCache::savedSeconds);
+
+  py::class_<IncrementalInferenceModel>(
+      shape_inference, "IncrementalInference")
+      .def(py::init<const py::bytes&>())
+      .def(
+          "update_input_types",
+          [](IncrementalInferenceModel& self,
+             const std::unordered_map<std::string, py::bytes>& bytes) {
+            std::unordered_map<std::string, TypeProto> inputTypes;
+            for (const auto& input : bytes) {
+              ParseProtoFromPyBytes(&inputTypes[input.first], input.second);
+            }
+            return self.inference->updateInputTypes(inputTypes);
+          })
+      .def("model", [](const IncrementalInferenceModel& self) {
+        std::string out;
+        self.model.SerializeToString(&out);
+        return py::bytes(out);
+      });
+
   shape_inference.def(
     "infer_shapes",
+    [](const py::bytes& bytes, shape_inference::InferenceCache* cache) {
+      ModelProto proto{};
+      ParseProtoFromPyBytes(&proto, bytes);
+      shape_inference::InferShapes(proto, cache);
+      std::string out;
+      proto.SerializeToString(&out);
+      return py::bytes(out);
+    },
+    "bytes"_a,
+    "cache"_a = nullptr);
+
+  shape_inference.def(
+    "check_and_infer_shapes",
     [](const py::bytes& bytes) {
       ModelProto proto{};
       ParseProtoFromPyBytes(&proto, bytes);
-      shape_inference::InferShapes(proto);
+      checker::check_model_and_infer_shapes(proto);
       std::string out;
       proto.SerializeToString(&out);
       return py::bytes(out);
     });
+
+  shape_inference.def(
+    "check_and_infer_shapes_on_graph",
+    [](const py::bytes& bytes) {
+      ModelProto proto{};
+      ParseProtoFromPyBytes(&proto, bytes);
+      std::shared_ptr<Graph> g(ImportModelProto(proto));
+      if (g == nullptr) {
+        throw checker::ValidationError(
+            "model with IR version " +
+            ONNX_NAMESPACE::to_string(proto.ir_version()) +
+            " cannot be converted to a graph");
+      }
+      checker::check_graph(*g);
+      shape_inference::InferShapes(*g);
+      ExportModelProto(&proto, g);
+      std::string out;
+      proto.SerializeToString(&out);
+      return py::bytes(out);
+    });
+
+  // Submodule `cost`
+  auto cost = onnx_cpp2py_export.def_submodule("cost");
+  cost.doc() = "Cost estimation submodule";
+
+  cost.def(
+    "estimate_cost",
+    [](const py::bytes& bytes) {
+      ModelProto proto{};
+      ParseProtoFromPyBytes(&proto, bytes);
+      auto const result = cost::EstimateCost(proto);
+      std::vector<std::tuple<std::string, std::string, int64_t, int64_t, int64_t>> nodes;
+      for (const auto& node : result.nodes) {
+        nodes.emplace_back(
+            node.name,
+            node.op_type,
+            node.cost.flops,
+            node.cost.bytes_read,
+            node.cost.bytes_written);
+      }
+      return nodes;
+    });
 }
 
 } // namespace ONNX_NAMESPACE
@@ -0,0 +1,141 @@
+#pragma once
+
+#include <vector>
+
+#include "onnx/common/tensor.h"
+#include "onnx/defs/shape_inference.h"
+
+namespace ONNX_NAMESPACE {
+
+// Estimated cost of running a node, from the types and shapes of its inputs
+// and outputs. Each field is -1 when it cannot be estimated.
+struct OpCost {
+  int64_t flops;
+  int64_t bytes_read;
+  int64_t bytes_written;
+
+  OpCost() : flops(-1), bytes_read(-1), bytes_written(-1) {}
+
+  bool is_known() const {
+    return flops >= 0 && bytes_read >= 0 && bytes_written >= 0;
+  }
+};
+
+// The output types of the context are those computed by shape inference.
+// The types of missing optional inputs and outputs are nullptr.
+typedef OpCost (*CostFunction)(InferenceContext&);
+
+// Returns the dimension i of a tensor type, or -1 if it is not known.
+inline int64_t getDimValue(const TypeProto* type, int i) {
+  if (type == nullptr || !type->has_tensor_type() ||
+      !type->tensor_type().has_shape() ||
+      i >= type->tensor_type().shape().dim_size()) {
+    return -1;
+  }
+  const auto& dim = type->tensor_type().shape().dim(i);
+  return dim.has_dim_value() ? dim.dim_value() : -1;
+}
+
+// Returns the number of elements of a tensor type, or -1 if it is not known.
+inline int64_t getNumElements(const TypeProto* type) {
+  if (type == nullptr || !type->has_tensor_type() ||
+      !type->tensor_type().has_shape()) {
+    return -1;
+  }
+  int64_t n = 1;
+  for (int i = 0; i < type->tensor_type().shape().dim_size(); i++) {
+    int64_t d = getDimValue(type, i);
+    if (d < 0) {
+      return -1;
+    }
+    n *= d;
+  }
+  return n;
+}
+
+// Returns the size in bytes of a tensor type, or -1 if it is not known.
+inline int64_t getTensorBytes(const TypeProto* type) {
+  int64_t n = getNumElements(type);
+  if (n < 0) {
+    return -1;
+  }
+  auto elem_size = static_cast<int64_t>(
+      elementByteSize(type->tensor_type().elem_type()));
+  return elem_size == 0 ? -1 : n * elem_size;
+}
+
+// Returns the cost of a node running flops operations, which reads all of
+// its inputs and writes all of its outputs once. Missing optional inputs
+// and outputs have no type. For the ops whose output shapes are not
+// inferred, output_elements gives the number of elements of each output,
+// and output_elem_type their element type if it is not that of the first
+// input.
+inline OpCost makeOpCost(
+    InferenceContext& ctx,
+    int64_t flops,
+    const std::vector<int64_t>& output_elements = {},
+    int32_t output_elem_type = TensorProto::UNDEFINED) {
+  OpCost cost;
+  if (flops < 0) {
+    return cost;
+  }
+  int64_t bytes_read = 0;
+  for (size_t i = 0; i < ctx.getNumInputs(); i++) {
+    if (ctx.getInputType(i) == nullptr) {
+      continue;
+    }
+    int64_t bytes = getTensorBytes(ctx.getInputType(i));
+    if (bytes < 0) {
+      return cost;
+    }
+    bytes_read += bytes;
+  }
+  int64_t bytes_written = 0;
+  for (size_t i = 0; i < ctx.getNumOutputs(); i++) {
+    const TypeProto* type = ctx.getOutputType(i);
+    if (type == nullptr) {
+      continue;
+    }
+    int64_t bytes = getTensorBytes(type);
+    if (bytes < 0 && i < output_elements.size() && output_elements[i] >= 0 &&
+        ctx.getNumInputs() > 0 && ctx.getInputType(0) != nullptr) {
+      int32_t elem_type = type->tensor_type().elem_type();
+      if (elem_type == TensorProto::UNDEFINED) {
+        elem_type = output_elem_type;
+      }
+      if (elem_type == TensorProto::UNDEFINED) {
+        elem_type = ctx.getInputType(0)->tensor_type().elem_type();
+      }
+      auto elem_size = static_cast<int64_t>(
+          elementByteSize(static_cast<TensorProto_DataType>(elem_type)));
+      bytes = elem_size == 0 ? -1 : output_elements[i] * elem_size;
+    }
+    if (bytes < 0) {
+      return cost;
+    }
+    bytes_written += bytes;
+  }
+  cost.flops = flops;
+  cost.bytes_read = bytes_read;
+  cost.bytes_written = bytes_written;
+  return cost;
+}
+
+// One operation per output element for each input after the first, and at
+// least one. The output has the shape of the first input unless inferred.
+inline OpCost elementwiseCost(InferenceContext& ctx) {
+  int64_t n = -1;
+  if (ctx.getNumOutputs() > 0) {
+    n = getNumElements(ctx.getOutputType(0));
+  }
+  if (n < 0 && ctx.getNumInputs() > 0) {
+    n = getNumElements(ctx.getInputType(0));
+  }
+  if (n < 0) {
+    return OpCost();
+  }
+  int64_t ops = ctx.getNumInputs() > 2 ? static_cast<int64_t>(ctx.getNumInputs()) - 1 : 1;
+  return makeOpCost(ctx, n * ops, {n});
+}
+
+} // namespace ONNX_NAMESPACE
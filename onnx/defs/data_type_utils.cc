@@ -2,6 +2,7 @@
 #include <iostream>
 #include <iterator>
 #include <sstream>
+#include <stdexcept>
 
 #include "data_type_utils.h"
 
@@ -91,16 +92,45 @@ std::mutex& DataTypeUtils::GetTypeStrLock() {
   return lock;
 }
 
+std::unordered_map<DataType, DataTypeId>& DataTypeUtils::GetTypeToIdMap() {
+  static std::unordered_map<DataType, DataTypeId> map;
+  return map;
+}
+
+// The ids of the tensor types are their data types, and those of the other
+// types follow them.
+static constexpr DataTypeId kFirstNonTensorDataTypeId = 32;
+static_assert(
+    TensorProto_DataType_DataType_MAX < kFirstNonTensorDataTypeId,
+    "the ids of the tensor types overlap those of the other types");
+
 DataType DataTypeUtils::ToType(const TypeProto& type_proto) {
   auto typeStr = ToString(type_proto);
   std::lock_guard<std::mutex> lock(GetTypeStrLock());
-  if (GetTypeStrToProtoMap().find(typeStr) == GetTypeStrToProtoMap().end()) {
-    GetTypeStrToProtoMap()[typeStr] = type_proto;
+  auto inserted = GetTypeStrToProtoMap().emplace(typeStr, type_proto);
+  DataType data_type = &inserted.first->first;
+  if (inserted.second &&
+      type_proto.value_case() != TypeProto::ValueCase::kTensorType) {
+    auto& ids = GetTypeToIdMap();
+    size_t id = kFirstNonTensorDataTypeId + ids.size();
+    if (id >= kMaxDataTypeIds) {
+      throw std::logic_error("too many data types for their ids: " + typeStr);
+    }
+    ids.emplace(data_type, static_cast<DataTypeId>(id));
   }
-  return &(GetTypeStrToProtoMap().find(typeStr)->first);
+  return data_type;
 }
 
 DataType DataTypeUtils::ToType(const std::string& type_str) {
+  // The type strings of schemas are mostly in canonical form already, and
+  // are then found without being parsed.
+  {
+    std::lock_guard<std::mutex> lock(GetTypeStrLock());
+    auto it = GetTypeStrToProtoMap().find(type_str);
+    if (it != GetTypeStrToProtoMap().end()) {
+      return &it->first;
+    }
+  }
   TypeProto type;
   FromString(type_str, type);
   return ToType(type);
@@ -113,6 +143,65 @@ const TypeProto& DataTypeUtils::ToTypeProto(const DataType& data_type) {
   return it->second;
 }
 
+#ifdef ONNX_ML
+// Returns true if all the data types of type_proto have a type string, so
+// that it can be converted to one.
+static bool HasDataTypeStrings(const TypeProto& type_proto) {
+  const auto& type_strs =
+      TypesWrapper::GetTypesWrapper().TensorDataTypeToTypeStr();
+  switch (type_proto.value_case()) {
+    case TypeProto::ValueCase::kTensorType:
+      return type_strs.count(type_proto.tensor_type().elem_type()) > 0;
+    case TypeProto::ValueCase::kSequenceType:
+      return HasDataTypeStrings(type_proto.sequence_type().elem_type());
+    case TypeProto::ValueCase::kMapType:
+      return type_strs.count(type_proto.map_type().key_type()) > 0 &&
+          HasDataTypeStrings(type_proto.map_type().value_type());
+    default:
+      return false;
+  }
+}
+#endif
+
+static DataTypeId ToTensorTypeId(const TypeProto_Tensor& tensor_type) {
+  return TensorProto_DataType_IsValid(tensor_type.elem_type())
+      ? static_cast<DataTypeId>(tensor_type.elem_type())
+      : kUndefinedDataTypeId;
+}
+
+DataTypeId DataTypeUtils::ToTypeId(const DataType& data_type) {
+  std::lock_guard<std::mutex> lock(GetTypeStrLock());
+  auto it = GetTypeToIdMap().find(data_type);
+  if (it != GetTypeToIdMap().end()) {
+    return it->second;
+  }
+  return ToTensorTypeId(GetTypeStrToProtoMap().at(*data_type).tensor_type());
+}
+
+DataTypeId DataTypeUtils::ToTypeId(const TypeProto& type_proto) {
+  switch (type_proto.value_case()) {
+    case TypeProto::ValueCase::kTensorType:
+      return ToTensorTypeId(type_proto.tensor_type());
+#ifdef ONNX_ML
+    case TypeProto::ValueCase::kSequenceType:
+    case TypeProto::ValueCase::kMapType: {
+      if (!HasDataTypeStrings(type_proto)) {
+        return kUndefinedDataTypeId;
+      }
+      auto typeStr = ToString(type_proto);
+      std::lock_guard<std::mutex> lock(GetTypeStrLock());
+      auto it = GetTypeStrToProtoMap().find(typeStr);
+      if (it == GetTypeStrToProtoMap().end()) {
+        return kUndefinedDataTypeId;
+      }
+      return GetTypeToIdMap().at(&it->first);
+    }
+#endif
+    default:
+      return kUndefinedDataTypeId;
+  }
+}
+
 std::string DataTypeUtils::ToString(
     const TypeProto& type_proto,
     const std::string& left,
@@ -4,6 +4,7 @@
 #ifndef ONNX_DATA_TYPE_UTILS_H
 #define ONNX_DATA_TYPE_UTILS_H
 
+#include <bitset>
 #include <mutex>
 #include <string>
 #include <unordered_map>
@@ -14,6 +15,14 @@ namespace ONNX_NAMESPACE {
 // String pointer as unique TypeProto identifier.
 using DataType = const std::string*;
 
+// Small integer as unique TypeProto identifier, so that sets of types are
+// bitsets. The id of tensor(<data_type>) is the value of <data_type> in
+// TensorProto::DataType, and kUndefinedDataTypeId identifies no type.
+using DataTypeId = uint16_t;
+constexpr DataTypeId kUndefinedDataTypeId = 0;
+constexpr size_t kMaxDataTypeIds = 256;
+using DataTypeIdSet = std::bitset<kMaxDataTypeIds>;
+
 namespace Utils {
 
 // Data type utility, which maintains a global type string to TypeProto map.
@@ -40,6 +49,12 @@ class DataTypeUtils final {
 
   static const TypeProto& ToTypeProto(const DataType& data_type);
 
+  static DataTypeId ToTypeId(const DataType& data_type);
+
+  // Returns kUndefinedDataTypeId if type_proto is none of the types of the
+  // registered schemas. Tensor types are identified without taking the lock.
+  static DataTypeId ToTypeId(const TypeProto& type_proto);
+
  private:
   static void FromString(const std::string& type_str, TypeProto& type_proto);
 
@@ -59,6 +74,10 @@ class DataTypeUtils final {
 
   static std::unordered_map<std::string, TypeProto>& GetTypeStrToProtoMap();
 
+  // The ids of the types other than tensor types, in the order they are
+  // first converted.
+  static std::unordered_map<DataType, DataTypeId>& GetTypeToIdMap();
+
   // Returns lock used for concurrent updates to TypeStrToProtoMap.
   static std::mutex& GetTypeStrLock();
 };
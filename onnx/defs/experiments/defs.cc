@@ -374,3 +374,211 @@ Example:
       [3, 3, 4, 4]
   ]]]
 )DOC");
+
+static const char* fused_activation_doc = R"DOC(
+The activation is one of Relu, LeakyRelu, Sigmoid, Tanh, Softsign, Softplus,
+Elu, ThresholdedRelu, HardSigmoid, Affine and Clip. Its
+parameters are given by activation_alpha and activation_beta, which stand for
+the attributes alpha and beta of the activation operator, or min and max for
+Clip. They default to the default values of these attributes.
+)DOC";
+
+static void FusedActivationAttrs(OpSchema& schema) {
+  schema.Attr(
+      "activation",
+      "The name of the activation operator applied to the output.",
+      AttributeProto::STRING);
+  schema.Attr(
+      "activation_alpha",
+      "The first parameter of the activation.",
+      AttributeProto::FLOAT,
+      OPTIONAL);
+  schema.Attr(
+      "activation_beta",
+      "The second parameter of the activation.",
+      AttributeProto::FLOAT,
+      OPTIONAL);
+}
+
+ONNX_OPERATOR_SCHEMA(FusedConv)
+    .SetSupportLevel(SupportType::EXPERIMENTAL)
+    .SetDoc(std::string(R"DOC(
+FusedConv computes a Conv followed by an elementwise activation, so that the
+activation can be applied before the output of the convolution is written.
+The inputs and the other attributes are the ones of Conv.
+)DOC") + fused_activation_doc)
+    .Input(0, "X", "Input data tensor of size (N x C x D1 x D2 ... x Dn).", "T")
+    .Input(1, "W", "The weight tensor of size (M x C x k1 x k2 x ... x kn).", "T")
+    .Input(2, "B", "Optional 1D bias to be added to the convolution, has size of M.", "T",
+        OpSchema::Optional)
+    .Output(0, "Y", "Output data tensor.", "T")
+    .TypeConstraint(
+        "T",
+        {"tensor(float16)", "tensor(float)", "tensor(double)"},
+        "Constrain input and output types to float tensors.")
+    .Attr(
+        "kernel_shape",
+        "The shape of the convolution kernel. If not present, should be inferred from input W.",
+        AttributeProto::INTS,
+        OPTIONAL)
+    .Attr(
+        "dilations",
+        "dilation value along each axis of the filter. If not present, the dilation defaults to 1 along each axis.",
+        AttributeProto::INTS,
+        OPTIONAL)
+    .Attr(
+        "strides",
+        "Stride along each axis. If not present, the stride defaults to 1 along each axis.",
+        AttributeProto::INTS,
+        OPTIONAL)
+    .Attr(
+        "auto_pad",
+        "auto_pad must be either SAME_UPPER, SAME_LOWER or VALID, as for Conv.",
+        AttributeProto::STRING,
+        std::string("NOTSET"))
+    .Attr(
+        "pads",
+        "Padding for the beginning and ending along each axis, as for Conv.",
+        AttributeProto::INTS,
+        OPTIONAL)
+    .Attr(
+        "group",
+        "number of groups input channels and output channels are divided into, default is 1.",
+        AttributeProto::INT,
+        static_cast<int64_t>(1))
+    .FillUsing(FusedActivationAttrs)
+    .TypeAndShapeInferenceFunction([](InferenceContext& ctx) {
+      auto* schema = OpSchemaRegistry::Schema("Conv");
+      if (schema != nullptr) {
+        schema->GetTypeAndShapeInferenceFunction()(ctx);
+      }
+    });
+
+ONNX_OPERATOR_SCHEMA(FusedGemm)
+    .SetSupportLevel(SupportType::EXPERIMENTAL)
+    .SetDoc(std::string(R"DOC(
+FusedGemm computes a Gemm followed by an elementwise activation, so that the
+activation can be applied before the output of the matrix multiplication is
+written. The inputs and the other attributes are the ones of Gemm.
+)DOC") + fused_activation_doc)
+    .Input(0, "A", "Input tensor A", "T")
+    .Input(1, "B", "Input tensor B", "T")
+    .Input(2, "C", "Input tensor C", "T")
+    .Output(0, "Y", "Output tensor.", "T")
+    .TypeConstraint(
+        "T",
+        {"tensor(float16)", "tensor(float)", "tensor(double)"},
+        "Constrain input and output types to float tensors.")
+    .Attr(
+        "transA",
+        "Whether A should be transposed",
+        AttributeProto::INT,
+        static_cast<int64_t>(0))
+    .Attr(
+        "transB",
+        "Whether B should be transposed",
+        AttributeProto::INT,
+        static_cast<int64_t>(0))
+    .Attr(
+        "broadcast",
+        "Whether C should be broadcasted",
+        AttributeProto::INT,
+        static_cast<int64_t>(0))
+    .Attr(
+        "alpha",
+        "Scalar multiplier for the product of input tensors A * B",
+        AttributeProto::FLOAT,
+        1.0f)
+    .Attr(
+        "beta",
+        "Scalar multiplier for input tensor C",
+        AttributeProto::FLOAT,
+        1.0f)
+    .FillUsing(FusedActivationAttrs)
+    .TypeAndShapeInferenceFunction([](InferenceContext& ctx) {
+      auto* schema = OpSchemaRegistry::Schema("Gemm");
+      if (schema != nullptr) {
+        schema->GetTypeAndShapeInferenceFunction()(ctx);
+      }
+    });
+
+ONNX_OPERATOR_SCHEMA(FusedElementwise)
+    .SetSupportLevel(SupportType::EXPERIMENTAL)
+    .SetDoc(R"DOC(
+FusedElementwise computes a connected region of elementwise operators in a
+single pass over its inputs, without writing the intermediate values. The
+region is given by the graph attribute body, whose inputs and outputs are
+bound by position to the inputs and outputs of the node.
+
+The nodes of body are elementwise operators of the default domain whose output
+has the type and the shape of their first input: Abs, Ceil, Clip, Elu, Exp,
+Floor, HardSigmoid, LeakyRelu, Log, Neg, Reciprocal, Relu, Selu, Sigmoid,
+Softplus, Softsign, Sqrt and Tanh, and Add, Sub, Mul, Div and Pow, whose second
+input may be broadcast to the first one with the broadcast and axis
+attributes.
+)DOC")
+    .Attr(
+        "body",
+        "The graph computed by the node. It only refers to its own inputs.",
+        AttributeProto::GRAPH)
+    .Input(0, "inputs", "Inputs of body", "T", OpSchema::Variadic)
+    .Output(0, "outputs", "Outputs of body", "T", OpSchema::Variadic)
+    .TypeConstraint(
+        "T",
+        {"tensor(float16)", "tensor(float)", "tensor(double)"},
+        "Constrain input and output types to float tensors.")
+    .TypeAndShapeInferenceFunction([](InferenceContext& ctx) {
+      auto* body_attr = ctx.getAttribute("body");
+      if (body_attr == nullptr || !body_attr->has_g()) {
+        return;
+      }
+      const GraphProto& body = body_attr->g();
+      if (static_cast<size_t>(body.input_size()) != ctx.getNumInputs() ||
+          static_cast<size_t>(body.output_size()) != ctx.getNumOutputs()) {
+        return;
+      }
+      // every value of body has the type of the first input of its node
+      std::unordered_map<std::string, const TypeProto*> types;
+      for (int i = 0; i < body.input_size(); i++) {
+        const TypeProto* type = ctx.getInputType(static_cast<size_t>(i));
+        types[body.input(i).name()] =
+            type != nullptr ? type : &body.input(i).type();
+      }
+      for (const auto& node : body.node()) {
+        if (node.input_size() == 0) {
+          return;
+        }
+        auto it = types.find(node.input(0));
+        if (it == types.end()) {
+          return;
+        }
+        for (const auto& output : node.output()) {
+          types[output] = it->second;
+        }
+      }
+      for (int i = 0; i < body.output_size(); i++) {
+        auto it = types.find(body.output(i).name());
+        if (it != types.end() && it->second->has_tensor_type()) {
+          *ctx.getOutputType(static_cast<size_t>(i)) = *it->second;
+        }
+      }
+    });
+
+ONNX_OPERATOR_SCHEMA(Partition)
+    .SetSupportLevel(SupportType::EXPERIMENTAL)
+    .SetDoc(R"DOC(
+Partition computes a part of the graph delegated to another backend, such as
+an ONNXIFI backend. The part is given by a model of its own, named by the
+partition attribute, whose graph inputs and outputs are bound by position to
+the inputs and outputs of the node. The inputs may have different types.
+)DOC")
+    .Attr(
+        "partition",
+        "The name of the model computed by the node.",
+        AttributeProto::STRING)
+    .Input(0, "inputs", "Inputs of the partition", "T", OpSchema::Variadic)
+    .Output(0, "outputs", "Outputs of the partition", "T", OpSchema::Variadic)
+    .TypeConstraint(
+        "T",
+        OpSchema::all_tensor_types(),
+        "Allow inputs and outputs to be any kind of tensor.");
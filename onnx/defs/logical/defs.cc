@@ -7,6 +7,16 @@ using namespace ONNX_NAMESPACE;
 
 namespace ONNX_NAMESPACE {
 
+// One operation per element of the first input, whose shape the bool
+// output has.
+static OpCost logicalCost(InferenceContext& ctx) {
+    int64_t n = getNumElements(ctx.getInputType(0));
+    if (n < 0) {
+        return OpCost();
+    }
+    return makeOpCost(ctx, n, {n}, TensorProto::BOOL);
+}
+
 std::function<void(OpSchema&)> BinaryLogicDocGenerator(const char* name) {
     return [=](OpSchema& schema) {
         std::string doc = R"DOC(
@@ -26,6 +36,7 @@ detailed description of the broadcasting rules.
         schema.Input(0, "A", "Left input tensor for the logical operator.", "T");
         schema.Input(1, "B", "Right input tensor for the logical operator.", "T");
         schema.Output(0, "C", "Result tensor.", "T1");
+        schema.SetCostFunction(logicalCost);
     };
 }
 
@@ -78,6 +89,7 @@ Returns the negation of the input tensor element-wise.
     .Input(0, "X", "Input tensor", "T")
     .Output(0, "Y", "Output tensor", "T")
     .TypeConstraint("T", { "tensor(bool)" },
-                    "Constrains input/output to boolean tensors.");
+                    "Constrains input/output to boolean tensors.")
+    .SetCostFunction(logicalCost);
 
 }  // namespace ONNX_NAMESPACE
@@ -1,6 +1,7 @@
 // Copyright (c) Facebook Inc. and Microsoft Corporation.
 // Licensed under the MIT license.
 
+#include <algorithm>
 #include <functional>
 #include "onnx/defs/schema.h"
 
@@ -62,6 +63,7 @@ Performs element-wise binary {name} (with limited broadcast support).
         OpSchema::high_precision_numeric_types(),
         "Constrain input and output types to high-precision numeric tensors.");
     schema.TypeAndShapeInferenceFunction(propagateShapeAndTypeFromFirstInput);
+    schema.SetCostFunction(elementwiseCost);
   };
 }
 
@@ -147,7 +149,8 @@ the tensor elementwise.
          "tensor(int64)",
          "tensor(float16)",
          "tensor(double)"},
-        "Constrain input and output types to signed numeric tensors.");
+        "Constrain input and output types to signed numeric tensors.")
+    .SetCostFunction(elementwiseCost);
 
 ONNX_OPERATOR_SCHEMA(Abs)
     .SinceVersion(6)
@@ -161,7 +164,8 @@ the tensor elementwise.
     .TypeConstraint(
         "T",
         OpSchema::all_numeric_types(),
-        "Constrain input and output types to all numeric tensors.");
+        "Constrain input and output types to all numeric tensors.")
+    .SetCostFunction(elementwiseCost);
 
 ONNX_OPERATOR_SCHEMA(Reciprocal)
     .SinceVersion(6)
@@ -175,7 +179,8 @@ the tensor elementwise.
     .TypeConstraint(
         "T",
         {"tensor(float16)", "tensor(float)", "tensor(double)"},
-        "Constrain input and output types to float tensors.");
+        "Constrain input and output types to float tensors.")
+    .SetCostFunction(elementwiseCost);
 
 ONNX_OPERATOR_SCHEMA(Floor)
     .SinceVersion(6)
@@ -189,7 +194,8 @@ the tensor elementwise.
     .TypeConstraint(
         "T",
         {"tensor(float16)", "tensor(float)", "tensor(double)"},
-        "Constrain input and output types to float tensors.");
+        "Constrain input and output types to float tensors.")
+    .SetCostFunction(elementwiseCost);
 
 ONNX_OPERATOR_SCHEMA(Ceil)
     .SinceVersion(6)
@@ -203,7 +209,8 @@ the tensor elementwise.
     .TypeConstraint(
         "T",
         {"tensor(float16)", "tensor(float)", "tensor(double)"},
-        "Constrain input and output types to float tensors.");
+        "Constrain input and output types to float tensors.")
+    .SetCostFunction(elementwiseCost);
 
 ONNX_OPERATOR_SCHEMA(Sqrt)
     .SinceVersion(6)
@@ -217,7 +224,8 @@ the tensor elementwise. If x is negative, then it will return NaN.
     .TypeConstraint(
         "T",
         {"tensor(float16)", "tensor(float)", "tensor(double)"},
-        "Constrain input and output types to float tensors.");
+        "Constrain input and output types to float tensors.")
+    .SetCostFunction(elementwiseCost);
 
 ONNX_OPERATOR_SCHEMA(Relu)
     .SinceVersion(6)
@@ -232,7 +240,8 @@ the tensor elementwise.
         "T",
         {"tensor(float16)", "tensor(float)", "tensor(double)"},
         "Constrain input and output types to float tensors.")
-    .TypeAndShapeInferenceFunction(propagateShapeAndTypeFromFirstInput);
+    .TypeAndShapeInferenceFunction(propagateShapeAndTypeFromFirstInput)
+    .SetCostFunction(elementwiseCost);
 
 ONNX_OPERATOR_SCHEMA(LeakyRelu)
     .SinceVersion(6)
@@ -251,7 +260,8 @@ output data (Tensor<T>) where the function `f(x) = alpha * x for x < 0`,
     .TypeConstraint(
         "T",
         {"tensor(float16)", "tensor(float)", "tensor(double)"},
-        "Constrain input and output types to float tensors.");
+        "Constrain input and output types to float tensors.")
+    .SetCostFunction(elementwiseCost);
 
 ONNX_OPERATOR_SCHEMA(Selu)
     .SinceVersion(6)
@@ -278,7 +288,8 @@ is applied to the tensor elementwise.
     .TypeConstraint(
         "T",
         {"tensor(float16)", "tensor(float)", "tensor(double)"},
-        "Constrain input and output types to float tensors.");
+        "Constrain input and output types to float tensors.")
+    .SetCostFunction(elementwiseCost);
 
 ONNX_OPERATOR_SCHEMA(Elu)
     .SinceVersion(6)
@@ -298,7 +309,8 @@ Elu takes one input data (Tensor<T>) and produces one output data
     .TypeConstraint(
         "T",
         {"tensor(float16)", "tensor(float)", "tensor(double)"},
-        "Constrain input and output types to float tensors.");
+        "Constrain input and output types to float tensors.")
+    .SetCostFunction(elementwiseCost);
 
 ONNX_OPERATOR_SCHEMA(Exp)
     .SinceVersion(6)
@@ -315,7 +327,8 @@ Calculates the exponential of the given input tensor, element-wise.
     .TypeConstraint(
         "T",
         {"tensor(float16)", "tensor(float)", "tensor(double)"},
-        "Constrain input and output types to float tensors.");
+        "Constrain input and output types to float tensors.")
+    .SetCostFunction(elementwiseCost);
 
 ONNX_OPERATOR_SCHEMA(Log)
     .SinceVersion(6)
@@ -332,7 +345,8 @@ Calculates the natural log of the given input tensor, element-wise.
     .TypeConstraint(
         "T",
         {"tensor(float16)", "tensor(float)", "tensor(double)"},
-        "Constrain input and output types to float tensors.");
+        "Constrain input and output types to float tensors.")
+    .SetCostFunction(elementwiseCost);
 
 ONNX_OPERATOR_SCHEMA(Tanh)
     .SinceVersion(6)
@@ -349,7 +363,8 @@ Calculates the hyperbolic tangent of the given input tensor element-wise.
     .TypeConstraint(
         "T",
         {"tensor(float16)", "tensor(float)", "tensor(double)"},
-        "Constrain input and output types to float tensors.");
+        "Constrain input and output types to float tensors.")
+    .SetCostFunction(elementwiseCost);
 
 ONNX_OPERATOR_SCHEMA(Pow)
     .SetDoc(R"DOC(
@@ -378,7 +393,8 @@ is applied to the data tensor elementwise.
     .TypeConstraint(
         "T",
         {"tensor(float16)", "tensor(float)", "tensor(double)"},
-        "Constrain input and output types to float tensors.");
+        "Constrain input and output types to float tensors.")
+    .SetCostFunction(elementwiseCost);
 
 ONNX_OPERATOR_SCHEMA(PRelu)
     .SinceVersion(6)
@@ -400,7 +416,8 @@ output data (Tensor<T>) where the function `f(x) = slope * x for x < 0`,
     .TypeConstraint(
         "T",
         {"tensor(float16)", "tensor(float)", "tensor(double)"},
-        "Constrain input and output types to float tensors.");
+        "Constrain input and output types to float tensors.")
+    .SetCostFunction(elementwiseCost);
 
 ONNX_OPERATOR_SCHEMA(Sigmoid)
     .SinceVersion(6)
@@ -414,7 +431,8 @@ tensor elementwise.
     .TypeConstraint(
         "T",
         {"tensor(float16)", "tensor(float)", "tensor(double)"},
-        "Constrain input and output types to float tensors.");
+        "Constrain input and output types to float tensors.")
+    .SetCostFunction(elementwiseCost);
 
 ONNX_OPERATOR_SCHEMA(HardSigmoid)
     .SinceVersion(6)
@@ -430,7 +448,8 @@ is applied to the tensor elementwise.
     .TypeConstraint(
         "T",
         {"tensor(float16)", "tensor(float)", "tensor(double)"},
-        "Constrain input and output types to float tensors.");
+        "Constrain input and output types to float tensors.")
+    .SetCostFunction(elementwiseCost);
 
 ONNX_OPERATOR_SCHEMA(Max)
     .SinceVersion(6)
@@ -443,7 +462,8 @@ have the same shape and data type.
     .TypeConstraint(
         "T",
         {"tensor(float16)", "tensor(float)", "tensor(double)"},
-        "Constrain input and output types to float tensors.");
+        "Constrain input and output types to float tensors.")
+    .SetCostFunction(elementwiseCost);
 
 ONNX_OPERATOR_SCHEMA(Min)
     .SinceVersion(6)
@@ -456,7 +476,8 @@ have the same shape and data type.
     .TypeConstraint(
         "T",
         {"tensor(float16)", "tensor(float)", "tensor(double)"},
-        "Constrain input and output types to float tensors.");
+        "Constrain input and output types to float tensors.")
+    .SetCostFunction(elementwiseCost);
 
 ONNX_OPERATOR_SCHEMA(Sum)
     .SinceVersion(6)
@@ -470,7 +491,8 @@ have the same shape and data type.
         "T",
         {"tensor(float16)", "tensor(float)", "tensor(double)"},
         "Constrain input and output types to float tensors.")
-    .TypeAndShapeInferenceFunction(propagateShapeAndTypeFromFirstInput);
+    .TypeAndShapeInferenceFunction(propagateShapeAndTypeFromFirstInput)
+    .SetCostFunction(elementwiseCost);
 
 ONNX_OPERATOR_SCHEMA(Mean)
     .SinceVersion(6)
@@ -483,7 +505,8 @@ have the same shape and data type.
     .TypeConstraint(
         "T",
         {"tensor(float16)", "tensor(float)", "tensor(double)"},
-        "Constrain input and output types to float tensors.");
+        "Constrain input and output types to float tensors.")
+    .SetCostFunction(elementwiseCost);
 
 ONNX_OPERATOR_SCHEMA(Clip)
     .SinceVersion(6)
@@ -507,7 +530,8 @@ numeric_limits::lowest() and numeric_limits::max() respectively.
     .TypeConstraint(
         "T",
         {"tensor(float16)", "tensor(float)", "tensor(double)"},
-        "Constrain input and output types to float tensors.");
+        "Constrain input and output types to float tensors.")
+    .SetCostFunction(elementwiseCost);
 
 ONNX_OPERATOR_SCHEMA(Softmax).FillUsing(
     SoftmaxFamilyDocGenerator("softmax", "normalized exponential"));
@@ -532,7 +556,8 @@ Calculates the softsign (x/(1+|x|)) of the given input tensor element-wise.
     .TypeConstraint(
         "T",
         {"tensor(float16)", "tensor(float)", "tensor(double)"},
-        "Constrain input and output types to float tensors.");
+        "Constrain input and output types to float tensors.")
+    .SetCostFunction(elementwiseCost);
 
 ONNX_OPERATOR_SCHEMA(Softplus)
     .SetDoc(R"DOC(
@@ -545,7 +570,62 @@ the tensor elementwise.
     .TypeConstraint(
         "T",
         {"tensor(float16)", "tensor(float)", "tensor(double)"},
-        "Constrain input and output types to float tensors.");
+        "Constrain input and output types to float tensors.")
+    .SetCostFunction(elementwiseCost);
+
+namespace ONNX_NAMESPACE {
+
+// A dot product of length K for each of the M x N output elements, which
+// are then scaled and added to C.
+static OpCost gemmCost(InferenceContext& ctx) {
+  auto transAAttr = ctx.getAttribute("transA");
+  bool transA = transAAttr ? static_cast<int>(transAAttr->i()) != 0 : false;
+  auto transBAttr = ctx.getAttribute("transB");
+  bool transB = transBAttr ? static_cast<int>(transBAttr->i()) != 0 : false;
+  int64_t m = getDimValue(ctx.getInputType(0), transA ? 1 : 0);
+  int64_t k = getDimValue(ctx.getInputType(0), transA ? 0 : 1);
+  int64_t n = getDimValue(ctx.getInputType(1), transB ? 0 : 1);
+  if (m < 0 || k < 0 || n < 0) {
+    return OpCost();
+  }
+  return makeOpCost(ctx, 2 * m * n * k + 2 * m * n, {m * n});
+}
+
+// A dot product of length K for each output element, where 1-D operands are
+// promoted to matrices and the leading dimensions are broadcast.
+static OpCost matMulCost(InferenceContext& ctx) {
+  if (!hasNInputShapes(ctx, 2)) {
+    return OpCost();
+  }
+  const TypeProto* a = ctx.getInputType(0);
+  const TypeProto* b = ctx.getInputType(1);
+  int rank_a = a->tensor_type().shape().dim_size();
+  int rank_b = b->tensor_type().shape().dim_size();
+  if (rank_a == 0 || rank_b == 0) {
+    return OpCost();
+  }
+  int64_t m = rank_a > 1 ? getDimValue(a, rank_a - 2) : 1;
+  int64_t k = getDimValue(a, rank_a - 1);
+  int64_t n = rank_b > 1 ? getDimValue(b, rank_b - 1) : 1;
+  if (m < 0 || k < 0 || n < 0) {
+    return OpCost();
+  }
+  int batch_a = std::max(rank_a - 2, 0);
+  int batch_b = std::max(rank_b - 2, 0);
+  int batch_rank = std::max(batch_a, batch_b);
+  int64_t batch = 1;
+  for (int i = 0; i < batch_rank; i++) {
+    int64_t da = i >= batch_rank - batch_a ? getDimValue(a, i - batch_rank + batch_a) : 1;
+    int64_t db = i >= batch_rank - batch_b ? getDimValue(b, i - batch_rank + batch_b) : 1;
+    if (da < 0 || db < 0) {
+      return OpCost();
+    }
+    batch *= std::max(da, db);
+  }
+  return makeOpCost(ctx, 2 * batch * m * n * k, {batch * m * n});
+}
+
+} // namespace ONNX_NAMESPACE
 
 ONNX_OPERATOR_SCHEMA(Gemm)
     .SinceVersion(6)
@@ -609,7 +689,8 @@ if attribute transA is non-zero, same for B and transB.
           *ctx.getOutputType(0)->mutable_tensor_type()->mutable_shape() =
             ctx.getInputType(2)->tensor_type().shape();
         }
-      });
+      })
+    .SetCostFunction(gemmCost);
 
 ONNX_OPERATOR_SCHEMA(MatMul)
     .Input(0, "A", "N-dimensional matrix A", "T")
@@ -621,7 +702,8 @@ ONNX_OPERATOR_SCHEMA(MatMul)
         "Constrain input and output types to float tensors.")
     .SetDoc(R"DOC(
 Matrix product that behaves like numpy.matmul: https://docs.scipy.org/doc/numpy-1.13.0/reference/generated/numpy.matmul.html
-)DOC");
+)DOC")
+    .SetCostFunction(matMulCost);
 
 ONNX_OPERATOR_SCHEMA(TopK)
     .SetDoc(R"DOC(
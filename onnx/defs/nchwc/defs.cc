@@ -0,0 +1,326 @@
+// Copyright (c) Facebook Inc. and Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "onnx/defs/schema.h"
+
+namespace ONNX_NAMESPACE {
+
+using SupportType = OpSchema::SupportType;
+
+static const char* blocked_layout_doc = R"DOC(
+The operators of this domain work on the blocked NCHWc layout, where the
+channels are split in blocks of `c` channels that are stored contiguously.
+A tensor of shape (N x C x D1 x ... x Dn) is represented by a tensor of shape
+(N x ceil(C/c) x D1 x ... x Dn x c), with
+
+  Y[n, cb, d1, ..., dn, i] = X[n, cb * c + i, d1, ..., dn]
+
+The channels added to fill the last block are padding: their values are not
+part of the result and are dropped by ReorderOutput.
+)DOC";
+
+// Shape inference for the convolution and pooling operators of this domain.
+// The spatial dimensions of the blocked input X are the dimensions 2 to
+// rank - 2, the last dimension being the channel block.
+static void blockedConvPoolShapeInference(InferenceContext& ctx, bool has_weights) {
+  propagateElemTypeFromInputToOutput(ctx, 0, 0);
+  if (!hasNInputShapes(ctx, has_weights ? 2 : 1)) {
+    return;
+  }
+  const auto& x_shape = ctx.getInputType(0)->tensor_type().shape();
+  if (x_shape.dim_size() < 3) {
+    return;
+  }
+  const size_t n_input_dims = static_cast<size_t>(x_shape.dim_size() - 3);
+
+  std::vector<int64_t> kernel_shape;
+  if (getRepeatedAttribute(ctx, "kernel_shape", kernel_shape)) {
+    if (kernel_shape.size() != n_input_dims) {
+      return;
+    }
+  } else if (!has_weights) {
+    return;
+  } else {
+    const auto& w_shape = ctx.getInputType(1)->tensor_type().shape();
+    if (w_shape.dim_size() != static_cast<int>(n_input_dims + 4)) {
+      return;
+    }
+    for (int i = 2; i < static_cast<int>(n_input_dims + 2); ++i) {
+      if (!w_shape.dim(i).has_dim_value()) {
+        return;
+      }
+      kernel_shape.push_back(w_shape.dim(i).dim_value());
+    }
+  }
+
+  std::vector<int64_t> dilations;
+  if (has_weights && getRepeatedAttribute(ctx, "dilations", dilations)) {
+    if (dilations.size() != n_input_dims) {
+      return;
+    }
+  } else {
+    dilations.assign(n_input_dims, 1);
+  }
+
+  std::vector<int64_t> pads;
+  if (getRepeatedAttribute(ctx, "pads", pads)) {
+    if (pads.size() != n_input_dims * 2) {
+      return;
+    }
+  } else {
+    pads.assign(n_input_dims * 2, 0);
+  }
+
+  std::vector<int64_t> strides;
+  if (getRepeatedAttribute(ctx, "strides", strides)) {
+    if (strides.size() != n_input_dims) {
+      return;
+    }
+  } else {
+    strides.assign(n_input_dims, 1);
+  }
+
+  auto* output_shape = ctx.getOutputType(0)->mutable_tensor_type()->mutable_shape();
+  *output_shape->add_dim() = x_shape.dim(0);
+  *output_shape->add_dim() = has_weights
+    ? ctx.getInputType(1)->tensor_type().shape().dim(0)
+    : x_shape.dim(1);
+  for (size_t i = 0; i < n_input_dims; ++i) {
+    auto* newdim = output_shape->add_dim();
+    const auto& input_dim = x_shape.dim(static_cast<int>(i + 2));
+    if (!input_dim.has_dim_value()) {
+      continue;
+    }
+    int64_t effective_input_size = input_dim.dim_value() + pads[i] + pads[i + n_input_dims];
+    int64_t effective_kernel_size = (kernel_shape[i] - 1) * dilations[i] + 1;
+    newdim->set_dim_value(1 + (effective_input_size - effective_kernel_size) / strides[i]);
+  }
+  *output_shape->add_dim() = x_shape.dim(x_shape.dim_size() - 1);
+}
+
+static std::function<void(OpSchema&)> BlockedPoolOpSchemaGenerator(const char* name) {
+  return [=](OpSchema& schema) {
+    std::string doc = R"DOC(
+{name} on a tensor in the blocked NCHWc layout. The attributes have the same
+meaning as for the {name} operator of the default domain, and the channel
+blocks are pooled independently.
+)DOC";
+    ReplaceAll(doc, "{name}", name);
+    schema.SetDomain(AI_ONNX_NCHWC_DOMAIN);
+    schema.SetSupportLevel(SupportType::EXPERIMENTAL);
+    schema.SetDoc(doc + blocked_layout_doc);
+    schema.Attr(
+        "kernel_shape",
+        "The size of the kernel along each spatial axis.",
+        AttributeProto::INTS);
+    schema.Attr(
+        "strides",
+        "Stride along each spatial axis. If not present, the stride defaults to 1 along each axis.",
+        AttributeProto::INTS,
+        OPTIONAL);
+    schema.Attr(
+        "pads",
+        "Padding for the beginning and ending along each spatial axis, in the "
+        "format [x1_begin, x2_begin...x1_end, x2_end,...]. If not present, the "
+        "padding defaults to 0 along start and end of each axis.",
+        AttributeProto::INTS,
+        OPTIONAL);
+    schema.Input(
+        0,
+        "X",
+        "Input data tensor of size (N x ceil(C/c) x D1 x ... x Dn x c).",
+        "T");
+    schema.Output(
+        0,
+        "Y",
+        "Output data tensor of size (N x ceil(C/c) x O1 x ... x On x c).",
+        "T");
+    schema.TypeConstraint(
+        "T",
+        {"tensor(float16)", "tensor(float)", "tensor(double)"},
+        "Constrain input and output types to float tensors.");
+    schema.TypeAndShapeInferenceFunction([](InferenceContext& ctx) {
+      blockedConvPoolShapeInference(ctx, false);
+    });
+  };
+}
+
+ONNX_OPERATOR_SCHEMA(ReorderInput)
+    .SetDomain(AI_ONNX_NCHWC_DOMAIN)
+    .SetSupportLevel(SupportType::EXPERIMENTAL)
+    .SetDoc(std::string(R"DOC(
+Converts a tensor of size (N x C x D1 x ... x Dn) to the blocked NCHWc layout,
+filling the padding channels with zeros.
+)DOC") + blocked_layout_doc)
+    .Attr(
+        "channels_block",
+        "The number of channels c of a block.",
+        AttributeProto::INT)
+    .Input(0, "X", "Input tensor of size (N x C x D1 x ... x Dn).", "T")
+    .Output(0, "Y", "Output tensor of size (N x ceil(C/c) x D1 x ... x Dn x c).", "T")
+    .TypeConstraint(
+        "T",
+        {"tensor(float16)", "tensor(float)", "tensor(double)"},
+        "Constrain input and output types to float tensors.")
+    .TypeAndShapeInferenceFunction([](InferenceContext& ctx) {
+      propagateElemTypeFromInputToOutput(ctx, 0, 0);
+      if (!hasNInputShapes(ctx, 1)) {
+        return;
+      }
+      auto block_attr = ctx.getAttribute("channels_block");
+      if (block_attr == nullptr || block_attr->i() <= 0) {
+        return;
+      }
+      const auto block = block_attr->i();
+      const auto& input_shape = ctx.getInputType(0)->tensor_type().shape();
+      if (input_shape.dim_size() < 2) {
+        return;
+      }
+      auto* output_shape = ctx.getOutputType(0)->mutable_tensor_type()->mutable_shape();
+      for (int i = 0; i < input_shape.dim_size(); ++i) {
+        auto* dim = output_shape->add_dim();
+        if (i != 1) {
+          *dim = input_shape.dim(i);
+        } else if (input_shape.dim(i).has_dim_value()) {
+          dim->set_dim_value((input_shape.dim(i).dim_value() + block - 1) / block);
+        }
+      }
+      output_shape->add_dim()->set_dim_value(block);
+    });
+
+ONNX_OPERATOR_SCHEMA(ReorderOutput)
+    .SetDomain(AI_ONNX_NCHWC_DOMAIN)
+    .SetSupportLevel(SupportType::EXPERIMENTAL)
+    .SetDoc(std::string(R"DOC(
+Converts a tensor in the blocked NCHWc layout back to a tensor of size
+(N x C x D1 x ... x Dn), dropping the padding channels.
+)DOC") + blocked_layout_doc)
+    .Attr(
+        "channels",
+        "The number of channels C of the output.",
+        AttributeProto::INT)
+    .Input(0, "X", "Input tensor of size (N x ceil(C/c) x D1 x ... x Dn x c).", "T")
+    .Output(0, "Y", "Output tensor of size (N x C x D1 x ... x Dn).", "T")
+    .TypeConstraint(
+        "T",
+        {"tensor(float16)", "tensor(float)", "tensor(double)"},
+        "Constrain input and output types to float tensors.")
+    .TypeAndShapeInferenceFunction([](InferenceContext& ctx) {
+      propagateElemTypeFromInputToOutput(ctx, 0, 0);
+      if (!hasNInputShapes(ctx, 1)) {
+        return;
+      }
+      auto channels_attr = ctx.getAttribute("channels");
+      if (channels_attr == nullptr || channels_attr->i() <= 0) {
+        return;
+      }
+      const auto& input_shape = ctx.getInputType(0)->tensor_type().shape();
+      if (input_shape.dim_size() < 3) {
+        return;
+      }
+      auto* output_shape = ctx.getOutputType(0)->mutable_tensor_type()->mutable_shape();
+      for (int i = 0; i < input_shape.dim_size() - 1; ++i) {
+        auto* dim = output_shape->add_dim();
+        if (i != 1) {
+          *dim = input_shape.dim(i);
+        } else {
+          dim->set_dim_value(channels_attr->i());
+        }
+      }
+    });
+
+ONNX_OPERATOR_SCHEMA(Conv)
+    .SetDomain(AI_ONNX_NCHWC_DOMAIN)
+    .SetSupportLevel(SupportType::EXPERIMENTAL)
+    .SetDoc(std::string(R"DOC(
+Convolution of a tensor in the blocked NCHWc layout with a filter reordered
+for that layout. The attributes have the same meaning as for the Conv operator
+of the default domain; grouped convolutions are not supported.
+)DOC") + blocked_layout_doc)
+    .Attr(
+        "kernel_shape",
+        "The shape of the convolution kernel. If not present, should be inferred from input W.",
+        AttributeProto::INTS,
+        OPTIONAL)
+    .Attr(
+        "dilations",
+        "dilation value along each spatial axis of the filter. If not present, the dilation defaults to 1 along each axis.",
+        AttributeProto::INTS,
+        OPTIONAL)
+    .Attr(
+        "strides",
+        "Stride along each spatial axis. If not present, the stride defaults to 1 along each axis.",
+        AttributeProto::INTS,
+        OPTIONAL)
+    .Attr(
+        "pads",
+        "Padding for the beginning and ending along each spatial axis, in the "
+        "format [x1_begin, x2_begin...x1_end, x2_end,...]. If not present, the "
+        "padding defaults to 0 along start and end of each axis.",
+        AttributeProto::INTS,
+        OPTIONAL)
+    .Input(
+        0,
+        "X",
+        "Input data tensor of size (N x ceil(C/c) x D1 x ... x Dn x c).",
+        "T")
+    .Input(
+        1,
+        "W",
+        "The weight tensor, of size (ceil(M/c) x ceil(C/c) x k1 x ... x kn x c x c). "
+        "W[mb, cb, k1, ..., kn, i, j] is the weight of input channel cb * c + i "
+        "for output channel mb * c + j, and is 0 for padding channels.",
+        "T")
+    .Input(
+        2,
+        "B",
+        "Optional 1D bias of size ceil(M/c) * c, padded with zeros.",
+        "T",
+        OpSchema::Optional)
+    .Output(
+        0,
+        "Y",
+        "Output data tensor of size (N x ceil(M/c) x O1 x ... x On x c).",
+        "T")
+    .TypeConstraint(
+        "T",
+        {"tensor(float16)", "tensor(float)", "tensor(double)"},
+        "Constrain input and output types to float tensors.")
+    .TypeAndShapeInferenceFunction([](InferenceContext& ctx) {
+      blockedConvPoolShapeInference(ctx, true);
+    });
+
+ONNX_OPERATOR_SCHEMA(MaxPool).FillUsing(BlockedPoolOpSchemaGenerator("MaxPool"));
+
+ONNX_OPERATOR_SCHEMA(AveragePool).FillUsing(BlockedPoolOpSchemaGenerator("AveragePool"));
+
+ONNX_OPERATOR_SCHEMA(BatchNormalization)
+    .SetDomain(AI_ONNX_NCHWC_DOMAIN)
+    .SetSupportLevel(SupportType::EXPERIMENTAL)
+    .SetDoc(std::string(R"DOC(
+Batch normalization in test mode of a tensor in the blocked NCHWc layout.
+The parameters are padded to a multiple of the block size; padding channels
+should use a scale of 0 and a variance of 1.
+)DOC") + blocked_layout_doc)
+    .Attr(
+        "epsilon",
+        "The epsilon value to use to avoid division by zero, default is 1e-5f.",
+        AttributeProto::FLOAT,
+        1e-5f)
+    .Input(
+        0,
+        "X",
+        "Input data tensor of size (N x ceil(C/c) x D1 x ... x Dn x c).",
+        "T")
+    .Input(1, "scale", "1D scale of size ceil(C/c) * c.", "T")
+    .Input(2, "B", "1D bias of size ceil(C/c) * c.", "T")
+    .Input(3, "mean", "1D running mean of size ceil(C/c) * c.", "T")
+    .Input(4, "var", "1D running variance of size ceil(C/c) * c.", "T")
+    .Output(0, "Y", "The output tensor of the same shape as X.", "T")
+    .TypeConstraint(
+        "T",
+        {"tensor(float16)", "tensor(float)", "tensor(double)"},
+        "Constrain input and output types to float tensors.")
+    .TypeAndShapeInferenceFunction(propagateShapeAndTypeFromFirstInput);
+
+} // namespace ONNX_NAMESPACE
@@ -27,7 +27,9 @@ namespace ONNX_NAMESPACE {
 void convPoolTypeAndShapeInference(InferenceContext& ctx, bool use_dilation, bool require_kernel_shape) {
   propagateElemTypeFromInputToOutput(ctx, 0, 0);
 
-  if (!hasNInputShapes(ctx, 2)) {
+  // pooling ops have no filter, and keep the channels of their input
+  bool has_filter = ctx.getNumInputs() > 1;
+  if (!hasNInputShapes(ctx, has_filter ? 2 : 1)) {
     return;
   }
 
@@ -86,8 +88,9 @@ void convPoolTypeAndShapeInference(InferenceContext& ctx, bool use_dilation, boo
 
   *ctx.getOutputType(0)->mutable_tensor_type()->mutable_shape()->add_dim() =
     ctx.getInputType(0)->tensor_type().shape().dim(0);
-  *ctx.getOutputType(0)->mutable_tensor_type()->mutable_shape()->add_dim() =
-    ctx.getInputType(1)->tensor_type().shape().dim(0);
+  *ctx.getOutputType(0)->mutable_tensor_type()->mutable_shape()->add_dim() = has_filter
+    ? ctx.getInputType(1)->tensor_type().shape().dim(0)
+    : ctx.getInputType(0)->tensor_type().shape().dim(1);
 
   for (int i = 0; i < static_cast<int>(kernel_shape.size()); ++i) {
     auto newdim = ctx.getOutputType(0)->mutable_tensor_type()->mutable_shape()->add_dim();
@@ -113,6 +116,47 @@ void convPoolTypeAndShapeInference(InferenceContext& ctx, bool use_dilation, boo
   }
 }
 
+// A dot product over the C/group x kernel elements of a filter for each
+// output element, plus the bias.
+static OpCost convCost(InferenceContext& ctx) {
+  int64_t output = getNumElements(ctx.getOutputType(0));
+  int64_t filter = getNumElements(ctx.getInputType(1));
+  int64_t m = getDimValue(ctx.getInputType(1), 0);
+  if (output < 0 || filter < 0 || m <= 0) {
+    return OpCost();
+  }
+  int64_t flops = 2 * output * (filter / m);
+  if (ctx.getNumInputs() > 2 && ctx.getInputType(2) != nullptr) {
+    flops += output;
+  }
+  return makeOpCost(ctx, flops);
+}
+
+// One operation per element of the window of each output element.
+static OpCost poolCost(InferenceContext& ctx) {
+  int64_t output = getNumElements(ctx.getOutputType(0));
+  std::vector<int64_t> kernel_shape;
+  if (output < 0 || !getRepeatedAttribute(ctx, "kernel_shape", kernel_shape)) {
+    return OpCost();
+  }
+  int64_t window = 1;
+  for (auto d : kernel_shape) {
+    window *= d;
+  }
+  return makeOpCost(ctx, output * window);
+}
+
+// One operation per input element, with an N x C x 1 x ... output.
+static OpCost globalPoolCost(InferenceContext& ctx) {
+  int64_t input = getNumElements(ctx.getInputType(0));
+  int64_t n = getDimValue(ctx.getInputType(0), 0);
+  int64_t c = getDimValue(ctx.getInputType(0), 1);
+  if (input < 0 || n < 0 || c < 0) {
+    return OpCost();
+  }
+  return makeOpCost(ctx, input, {n * c});
+}
+
 std::function<void(OpSchema&)> PoolOpSchemaGenerator(
     const char* name,
     const char* opName,
@@ -188,6 +232,7 @@ std::function<void(OpSchema&)> PoolOpSchemaGenerator(
         {"tensor(float16)", "tensor(float)", "tensor(double)"},
         "Constrain input and output types to float tensors.");
     schema.TypeAndShapeInferenceFunction([](InferenceContext& ctx) { convPoolTypeAndShapeInference(ctx, false, true); });
+    schema.SetCostFunction(poolCost);
   };
 }
 
@@ -259,6 +304,7 @@ std::function<void(OpSchema&)> LpPoolOpSchemaGenerator(const char* name) {
         "T",
         {"tensor(float16)", "tensor(float)", "tensor(double)"},
         "Constrain input and output types to float tensors.");
+    schema.SetCostFunction(poolCost);
   };
 }
 
@@ -395,6 +441,7 @@ computes the output.)DOC";
         AttributeProto::INT,
         static_cast<int64_t>(1));
     schema.TypeAndShapeInferenceFunction([](InferenceContext& ctx) { convPoolTypeAndShapeInference(ctx, true, false); });
+    schema.SetCostFunction(convCost);
   };
 }
 
@@ -528,6 +575,7 @@ std::function<void(OpSchema&)> GlobalPoolingOpSchemaGenerator(
         "T",
         {"tensor(float16)", "tensor(float)", "tensor(double)"},
         "Constrain input and output types to float tensors.");
+    schema.SetCostFunction(globalPoolCost);
     schema.SetDoc(doc);
   };
 }
@@ -576,6 +624,7 @@ std::function<void(OpSchema&)> GlobalLpPoolingOpSchemaGenerator(
         "T",
         {"tensor(float16)", "tensor(float)", "tensor(double)"},
         "Constrain input and output types to float tensors.");
+    schema.SetCostFunction(globalPoolCost);
     schema.SetDoc(doc);
   };
 }
@@ -6,6 +6,50 @@
 
 namespace ONNX_NAMESPACE {
 
+// Returns the number of elements of the output of a reduction of input
+// along axes, all of them if empty, or -1 if it is not known.
+static int64_t reducedElements(const TypeProto* input, std::vector<int64_t> axes) {
+  int64_t n = getNumElements(input);
+  if (n < 0) {
+    return -1;
+  }
+  int rank = input->tensor_type().shape().dim_size();
+  if (axes.empty()) {
+    return 1;
+  }
+  for (auto axis : axes) {
+    int64_t d = getDimValue(input, static_cast<int>(axis < 0 ? axis + rank : axis));
+    if (d <= 0) {
+      return d == 0 ? 0 : -1;
+    }
+    n /= d;
+  }
+  return n;
+}
+
+// One operation per input element.
+static OpCost reduceCost(InferenceContext& ctx) {
+  std::vector<int64_t> axes;
+  getRepeatedAttribute(ctx, "axes", axes);
+  int64_t output = reducedElements(ctx.getInputType(0), axes);
+  if (output < 0) {
+    return OpCost();
+  }
+  return makeOpCost(ctx, getNumElements(ctx.getInputType(0)), {output});
+}
+
+// One operation per input element, with int64 indices as output.
+static OpCost argReduceCost(InferenceContext& ctx) {
+  auto axisAttr = ctx.getAttribute("axis");
+  std::vector<int64_t> axes = {axisAttr ? axisAttr->i() : 0};
+  int64_t output = reducedElements(ctx.getInputType(0), axes);
+  if (output < 0) {
+    return OpCost();
+  }
+  return makeOpCost(
+      ctx, getNumElements(ctx.getInputType(0)), {output}, TensorProto::INT64);
+}
+
 std::function<void(OpSchema&)> ReduceDocGenerator(const char* name) {
   return [=](OpSchema& schema) {
     std::string doc = R"DOC(
@@ -34,6 +78,7 @@ False instead of True.)DOC";
         "T",
         OpSchema::high_precision_numeric_types(),
         "Constrain input and output types to high-precision numeric tensors.");
+    schema.SetCostFunction(reduceCost);
   };
 }
 
@@ -92,6 +137,7 @@ The type of the output tensor is integer.)DOC";
         "T",
         OpSchema::all_numeric_types(),
         "Constrain input and output types to all numeric tensors.");
+    schema.SetCostFunction(argReduceCost);
   };
 }
 
@@ -7,6 +7,25 @@ using namespace ONNX_NAMESPACE;
 
 namespace ONNX_NAMESPACE {
 
+// For each step and direction, the products of the input and hidden state
+// with W and R for every gate, plus one operation per gate element.
+static OpCost rnnCost(InferenceContext& ctx) {
+    int64_t seq_length = getDimValue(ctx.getInputType(0), 0);
+    int64_t batch_size = getDimValue(ctx.getInputType(0), 1);
+    int64_t num_directions = getDimValue(ctx.getInputType(1), 0);
+    int64_t gates_size = getDimValue(ctx.getInputType(1), 1);
+    int64_t input_size = getDimValue(ctx.getInputType(1), 2);
+    int64_t hidden_size = getDimValue(ctx.getInputType(2), 2);
+    if (seq_length < 0 || batch_size < 0 || num_directions < 0 ||
+        gates_size < 0 || input_size < 0 || hidden_size < 0) {
+        return OpCost();
+    }
+    int64_t flops = seq_length * num_directions * batch_size * gates_size *
+        (2 * (input_size + hidden_size) + 1);
+    int64_t state = num_directions * batch_size * hidden_size;
+    return makeOpCost(ctx, flops, {seq_length * state, state, state});
+}
+
 // Warning: This function may be shared with old versions in old.cc.
 std::function<void(OpSchema&)> RNNDocGenerator(const char* /*name*/) {
     return [=](OpSchema& schema) {
@@ -57,6 +76,7 @@ std::function<void(OpSchema&)> RNNDocGenerator(const char* /*name*/) {
         schema.TypeConstraint("T", { "tensor(float16)", "tensor(float)", "tensor(double)" },
                               "Constrain input and output types to float tensors.");
         schema.TypeConstraint("T1", { "tensor(int32)" }, "Constrain seq_lens to integer tensor.");
+        schema.SetCostFunction(rnnCost);
     };
 }
 
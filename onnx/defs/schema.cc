@@ -2,6 +2,7 @@
 // Licensed under the MIT license.
 
 #include "onnx/defs/schema.h"
+#include <algorithm>
 #include <stdexcept>
 #include <unordered_set>
 #include "onnx/checker.h"
@@ -39,6 +40,10 @@ const DataTypeSet& OpSchema::FormalParameter::GetTypes() const {
   return type_set_;
 }
 
+const DataTypeIdSet& OpSchema::FormalParameter::GetTypeIds() const {
+  return type_id_set_;
+}
+
 DataTypeSet& OpSchema::FormalParameter::MutableTypes() {
   return type_set_;
 }
@@ -264,6 +269,11 @@ OpSchema& OpSchema::TypeAndShapeInferenceFunction(InferenceFunction inferenceFun
   return *this;
 }
 
+OpSchema& OpSchema::SetCostFunction(CostFunction costFunction) {
+  cost_function_ = costFunction;
+  return *this;
+}
+
 OpSchema& OpSchema::SetSupportLevel(SupportType support) {
   support_ = support;
   return *this;
@@ -424,11 +434,15 @@ OpSchema& OpSchema::TypeConstraint(
     std::string description) {
   assert(type_constraints_.end() == type_constraints_.find(type_str));
   DataTypeSet d;
+  DataTypeIdSet ids;
   for (const auto& t : constraints) {
-    d.insert(Utils::DataTypeUtils::ToType(t));
+    auto data_type = Utils::DataTypeUtils::ToType(t);
+    d.insert(data_type);
+    ids.set(Utils::DataTypeUtils::ToTypeId(data_type));
   }
   type_constraints_.insert(
       std::make_pair(type_str, std::make_pair(d, description)));
+  type_constraint_type_ids_.push_back(ids);
   type_constraint_params_.push_back(
       TypeConstraintParam(std::move(type_str), std::move(constraints), std::move(description)));
   return *this;
@@ -442,14 +456,79 @@ void OpSchema::ParseAndSetTypes(
     auto it = type_constraints_.find(type);
     if (it != type_constraints_.end()) {
       allowed_types = it->second.first;
+      for (size_t i = 0; i < type_constraint_params_.size(); ++i) {
+        if (type_constraint_params_[i].type_param_str == type) {
+          formal_parameter.type_param_index_ = static_cast<int>(i);
+          formal_parameter.type_id_set_ = type_constraint_type_ids_[i];
+        }
+      }
     } else {
-      allowed_types.emplace(Utils::DataTypeUtils::ToType(type));
+      auto data_type = Utils::DataTypeUtils::ToType(type);
+      allowed_types.emplace(data_type);
+      formal_parameter.type_id_set_.set(
+          Utils::DataTypeUtils::ToTypeId(data_type));
     }
 
     formal_parameter.MutableTypes() = allowed_types;
   }
 }
 
+void OpSchema::CheckInputTypes(
+    const std::vector<DataTypeId>& input_types) const {
+  if (inputs_.empty()) {
+    return;
+  }
+  // the type bound to each type constraint by the inputs checked so far
+  DataTypeId bound_types_buffer[4];
+  std::vector<DataTypeId> bound_types_vector;
+  DataTypeId* bound_types = bound_types_buffer;
+  if (type_constraint_params_.size() > 4) {
+    bound_types_vector.resize(type_constraint_params_.size());
+    bound_types = bound_types_vector.data();
+  }
+  std::fill(
+      bound_types,
+      bound_types + type_constraint_params_.size(),
+      kUndefinedDataTypeId);
+
+  for (size_t i = 0; i < input_types.size(); ++i) {
+    const DataTypeId type = input_types[i];
+    if (type == kUndefinedDataTypeId) {
+      continue;
+    }
+    // the inputs after the last formal input are its variadic ones
+    const auto& param = inputs_[std::min(i, inputs_.size() - 1)];
+    if (!param.type_id_set_.test(type)) {
+      fail_check(
+          "Input ",
+          i,
+          " (",
+          param.GetName(),
+          ") of operator ",
+          name_,
+          " has a type which is not allowed by ",
+          param.GetTypeStr());
+    }
+    if (param.type_param_index_ < 0) {
+      continue;
+    }
+    DataTypeId& bound_type = bound_types[param.type_param_index_];
+    if (bound_type == kUndefinedDataTypeId) {
+      bound_type = type;
+    } else if (bound_type != type) {
+      fail_check(
+          "Input ",
+          i,
+          " (",
+          param.GetName(),
+          ") of operator ",
+          name_,
+          " has a different type than the previous inputs of type ",
+          param.GetTypeStr());
+    }
+  }
+}
+
 OpSchema& OpSchema::FillUsing(const std::function<void(OpSchema&)>& populator) {
   if (populator) {
     populator(*this);
@@ -580,6 +659,42 @@ OpName_Domain_Version_Schema_Map& OpSchemaRegistry::map() {
   return map;
 }
 
+OpSchemaTable::OpSchemaTable(
+    const std::unordered_map<std::string, int>& opset_imports) {
+  if (opset_imports.empty()) {
+    return;
+  }
+  for (const auto& import : opset_imports) {
+    if (import.first.empty()) {
+      has_onnx_domain_ = true;
+    } else {
+      domains_[import.first];
+    }
+  }
+  for (const auto& op : OpSchemaRegistry::map()) {
+    for (const auto& domain_versions : op.second) {
+      auto it = opset_imports.find(domain_versions.first);
+      if (it == opset_imports.end()) {
+        continue;
+      }
+      const auto& versions = domain_versions.second;
+      // the schema with the biggest version not greater than the imported one
+      auto pos = versions.upper_bound(it->second);
+      if (pos == versions.begin()) {
+        continue;
+      }
+      --pos;
+      auto& d = it->first.empty() ? onnx_domain_ : domains_[it->first];
+      d.by_name[op.first] = &pos->second;
+      Symbol symbol(op.first);
+      if (symbol >= d.by_symbol.size()) {
+        d.by_symbol.resize(symbol + 1, nullptr);
+      }
+      d.by_symbol[symbol] = &pos->second;
+    }
+  }
+}
+
 size_t ReplaceAll(std::string& s, const char* from, const char* to) {
   size_t numReplaced = 0;
   std::string::size_type lenFrom = std::strlen(from);
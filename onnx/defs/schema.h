@@ -18,6 +18,8 @@
 #include <vector>
 
 #include "data_type_utils.h"
+#include "onnx/common/interned_strings.h"
+#include "onnx/defs/cost.h"
 #include "onnx/defs/shape_inference.h"
 
 namespace ONNX_NAMESPACE {
@@ -25,6 +27,8 @@ namespace ONNX_NAMESPACE {
 using OperatorSetVersion = int;
 
 constexpr const char* ONNX_DOMAIN = "";
+// Experimental operators working on the blocked NCHWc layout.
+constexpr const char* AI_ONNX_NCHWC_DOMAIN = "ai.onnx.nchwc";
 constexpr bool OPTIONAL = false;
 
 using DataTypeSet = std::unordered_set<DataType>;
@@ -88,6 +92,9 @@ class OpSchema final {
     // Get allowed data types.
     const DataTypeSet& GetTypes() const;
 
+    // Get the ids of the allowed data types.
+    const DataTypeIdSet& GetTypeIds() const;
+
     // Get formal parameter type string.
     const std::string& GetTypeStr() const;
 
@@ -109,6 +116,13 @@ class OpSchema final {
     // It should contain at least one element if this formal parameter is good.
     DataTypeSet type_set_;
 
+    // The ids of the data types of type_set_.
+    DataTypeIdSet type_id_set_;
+
+    // The index of the type constraint of type_str_ in the type constraints
+    // of the op, or -1 if type_str_ is a data type.
+    int type_param_index_ = -1;
+
     // The <parameter type> string specified when registring an op.
     // It could be a supported data type or a type constraint key, which
     // maps to a set of supported data types.
@@ -168,6 +182,12 @@ class OpSchema final {
    */
   void Verify(const NodeProto& node) const;
 
+  // Checks that the types of the inputs of a node, given by their ids, are
+  // allowed by the formal inputs of this op, and that the inputs of the
+  // same type constraint have the same type. The inputs of unknown type,
+  // whose id is kUndefinedDataTypeId, are not checked.
+  void CheckInputTypes(const std::vector<DataTypeId>& input_types) const;
+
   // Functions to set the property of the operator schemas.
   // Sets the number of inputs, either a fixed number or a min and a max.
 
@@ -205,6 +225,13 @@ class OpSchema final {
     return tensor_inference_function_;
   }
 
+  // Cost estimation, given the types inferred for the inputs and outputs.
+  // Ops without a cost function have an unknown cost.
+  OpSchema& SetCostFunction(CostFunction costFunction);
+  CostFunction GetCostFunction() const {
+    return cost_function_;
+  }
+
   // Set the support level for the op schema.
   OpSchema& SetSupportLevel(SupportType supportType);
 
@@ -457,6 +484,8 @@ class OpSchema final {
   std::vector<FormalParameter> outputs_;
   std::vector<TypeConstraintParam> type_constraint_params_;
   TypeConstraintMap type_constraints_;
+  // the ids of the allowed data types of each of type_constraint_params_
+  std::vector<DataTypeIdSet> type_constraint_type_ids_;
   int line_ = 0;
   SupportType support_;
   int min_input_ = 0;
@@ -468,6 +497,7 @@ class OpSchema final {
   std::function<bool(int)> num_inputs_allowed_ = [](int) { return true; };
   std::function<bool(int)> num_outputs_allowed_ = [](int) { return true; };
   InferenceFunction tensor_inference_function_ = [](InferenceContext&) {};
+  CostFunction cost_function_ = nullptr;
 };
 
 // Map type to store operator schemas. The format is,
@@ -480,6 +510,8 @@ using OpName_Domain_Version_Schema_Map = std::unordered_map<
  * @brief A registry to hold all the operator schemas.
  */
 class OpSchemaRegistry final {
+  friend class OpSchemaTable;
+
  public:
   // A singleton class to store domain to min/max op_set version map.
   class DomainToVersionRange final {
@@ -490,6 +522,7 @@ class OpSchemaRegistry final {
       // determined to remove too old version history.
       map_[ONNX_DOMAIN] = std::make_pair(1, 6);
       map_["ai.onnx.ml"] = std::make_pair(1, 1);
+      map_[AI_ONNX_NCHWC_DOMAIN] = std::make_pair(1, 1);
     }
 
     const std::unordered_map<std::string, std::pair<int, int>>& Map() const {
@@ -520,22 +553,31 @@ class OpSchemaRegistry final {
     std::mutex mutex_;
   };
 
+  // Gives back as an rvalue the schema built by ONNX_OPERATOR_SCHEMA, which
+  // the builder methods return by lvalue reference. It is the temporary
+  // the macro creates, so it may be moved from.
+  struct BuiltSchema final {
+    OpSchema&& operator<<(OpSchema& op_schema) const {
+      return std::move(op_schema);
+    }
+  };
+
   class OpSchemaRegisterOnce final {
    public:
-    OpSchemaRegisterOnce(OpSchema& op_schema) {
+    OpSchemaRegisterOnce(OpSchema&& op_schema) {
       // TODO: when we fix all issues - we can add abort() here
       try {
         op_schema.Finalize();
       } catch (const std::exception& e) {
         std::cerr << "Schema error: " << e.what() << std::endl;
       }
-      auto& m = map();
       auto& op_name = op_schema.Name();
       auto& op_domain = op_schema.domain();
       auto ver = op_schema.SinceVersion();
+      auto& versions = map()[op_name][op_domain];
 
-      if (m[op_name][op_domain].count(ver)) {
-        const auto& schema = m[op_name][op_domain][ver];
+      if (versions.count(ver)) {
+        const auto& schema = versions[ver];
         std::cerr << "Trying to register schema with name " << op_name
                   << " (domain: " << op_domain << " version: " << ver
                   << ") from file " << op_schema.file() << " line "
@@ -545,7 +587,7 @@ class OpSchemaRegistry final {
         abort();
       }
 
-      auto ver_range_map = DomainToVersionRange::Instance().Map();
+      const auto& ver_range_map = DomainToVersionRange::Instance().Map();
       auto ver_range_it = ver_range_map.find(op_domain);
       if (ver_range_it == ver_range_map.end()) {
         std::cerr << "Trying to register schema with name " << op_name
@@ -570,21 +612,22 @@ class OpSchemaRegistry final {
             << "in onnx/defs/schema.h)." << std::endl;
         abort();
       }
-      m[op_name][op_domain].emplace(std::make_pair(ver, op_schema));
+      versions.emplace(ver, std::move(op_schema));
     }
   };
 
   // Return the latest schema for an operator in specified domain.
   // Domain with default value ONNX_DOMAIN means ONNX.
+  // Schemas are only registered during static initialization, and lookups
+  // do not modify the registry, so they may run concurrently.
   static const OpSchema* Schema(
       const std::string& key,
       const std::string& domain = ONNX_DOMAIN) {
-    auto& m = map();
-    if (m.count(key) && m[key].count(domain)) {
-      return &m[key][domain].rbegin()->second;
-    } else {
+    const auto* versions = find(key, domain);
+    if (versions == nullptr) {
       return nullptr;
     }
+    return &versions->rbegin()->second;
   }
 
   // Return the schema with biggest version, which is not greater than specified
@@ -594,24 +637,18 @@ class OpSchemaRegistry final {
       const std::string& key,
       const int maxInclusiveVersion,
       const std::string& domain = ONNX_DOMAIN) {
-    auto& m = map();
-    if (m.count(key) && m[key].count(domain)) {
-      auto pos = m[key][domain].lower_bound(maxInclusiveVersion);
-      if (m[key][domain].begin() == pos && pos->first > maxInclusiveVersion) {
-        // All versions are greater than specified version.
-        return nullptr;
-      }
-      if (m[key][domain].end() == pos || pos->first > maxInclusiveVersion) {
-        // All versions are less than specified version, or,
-        // The <pos> version is greater than specified version.
-        pos--;
-        return &(pos->second);
-      }
-      // Schema with exact version as specified one exists.
-      return &(pos->second);
-    } else {
+    const auto* versions = find(key, domain);
+    if (versions == nullptr) {
       return nullptr;
     }
+    // the first schema with a greater version
+    auto pos = versions->upper_bound(maxInclusiveVersion);
+    if (pos == versions->begin()) {
+      // All versions are greater than specified version.
+      return nullptr;
+    }
+    pos--;
+    return &(pos->second);
   }
 
  private:
@@ -630,6 +667,23 @@ class OpSchemaRegistry final {
    */
   static OpName_Domain_Version_Schema_Map& map();
 
+  // Returns the schemas of an operator by version, or nullptr if it has none
+  // in domain.
+  static const std::map<OperatorSetVersion, OpSchema>* find(
+      const std::string& key,
+      const std::string& domain) {
+    const auto& m = map();
+    auto it = m.find(key);
+    if (it == m.end()) {
+      return nullptr;
+    }
+    auto dit = it->second.find(domain);
+    if (dit == it->second.end()) {
+      return nullptr;
+    }
+    return &dit->second;
+  }
+
  public:
   static const std::vector<OpSchema> get_all_schemas_with_history() {
     std::vector<OpSchema> r;
@@ -655,6 +709,58 @@ class OpSchemaRegistry final {
   }
 };
 
+// The schemas of the operators of a set of operator set versions, e.g. the
+// opset_import of a model, resolved once so that looking one up is a single
+// hash of the operator name, or a single index by the Symbol of the name.
+class OpSchemaTable final {
+ public:
+  // opset_imports maps each domain to its version.
+  explicit OpSchemaTable(
+      const std::unordered_map<std::string, int>& opset_imports);
+
+  // Return the schema OpSchemaRegistry::Schema returns for an operator at
+  // the version of its domain, or nullptr if the domain is not imported.
+  const OpSchema* Find(
+      const std::string& key,
+      const std::string& domain = ONNX_DOMAIN) const {
+    const auto* d = find(domain);
+    if (d == nullptr) {
+      return nullptr;
+    }
+    auto it = d->by_name.find(key);
+    return it == d->by_name.end() ? nullptr : it->second;
+  }
+
+  const OpSchema* Find(
+      Symbol key,
+      const std::string& domain = ONNX_DOMAIN) const {
+    const auto* d = find(domain);
+    if (d == nullptr || key >= d->by_symbol.size()) {
+      return nullptr;
+    }
+    return d->by_symbol[key];
+  }
+
+ private:
+  struct Domain {
+    std::unordered_map<std::string, const OpSchema*> by_name;
+    std::vector<const OpSchema*> by_symbol;
+  };
+
+  const Domain* find(const std::string& domain) const {
+    // most nodes are in the ONNX domain
+    if (domain.empty()) {
+      return has_onnx_domain_ ? &onnx_domain_ : nullptr;
+    }
+    auto it = domains_.find(domain);
+    return it == domains_.end() ? nullptr : &it->second;
+  }
+
+  Domain onnx_domain_;
+  bool has_onnx_domain_ = false;
+  std::unordered_map<std::string, Domain> domains_;
+};
+
 #define ONNX_OPERATOR_SCHEMA(name) \
   ONNX_OPERATOR_SCHEMA_UNIQ_HELPER(__COUNTER__, name)
 #define ONNX_OPERATOR_SCHEMA_UNIQ_HELPER(Counter, name) \
@@ -662,6 +768,7 @@ class OpSchemaRegistry final {
 #define ONNX_OPERATOR_SCHEMA_UNIQ(Counter, name)                 \
   static ONNX_NAMESPACE::OpSchemaRegistry::OpSchemaRegisterOnce( \
       op_schema_register_once##name##Counter) =                  \
+      ONNX_NAMESPACE::OpSchemaRegistry::BuiltSchema() <<         \
       OpSchema(#name, __FILE__, __LINE__)
 
 // Helper function
@@ -0,0 +1,115 @@
+# A reference evaluator for the experimental FusedElementwise operator, which
+# the fuse_elementwise optimization pass produces.
+#
+# It computes the body of a FusedElementwise node with numpy, so that the
+# results of a graph of elementwise operators can be compared before and
+# after the fusion:
+#
+#   outputs = run_graph(model.graph, {'X': x, 'B': b})
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+from __future__ import unicode_literals
+
+import numpy as np  # type: ignore
+
+from onnx import helper
+
+
+def _broadcast(a, b, attrs):
+    # limited broadcast: b is broadcast to a, starting at axis if given,
+    # otherwise aligned to the trailing dimensions of a
+    if not attrs.get('broadcast', 0) or 'axis' not in attrs:
+        return b
+    axis = attrs['axis']
+    if axis < 0:
+        axis += a.ndim
+    shape = [1] * axis + list(b.shape) + [1] * (a.ndim - axis - b.ndim)
+    return b.reshape(shape)
+
+
+def _elu(x, attrs):
+    alpha = attrs.get('alpha', 1.0)
+    return np.where(x > 0, x, alpha * (np.exp(x) - 1))
+
+
+def _selu(x, attrs):
+    alpha = attrs.get('alpha', 1.67326319217681884765625)
+    gamma = attrs.get('gamma', 1.05070102214813232421875)
+    return gamma * np.where(x > 0, x, alpha * (np.exp(x) - 1))
+
+
+def _clip(x, attrs):
+    info = np.finfo(x.dtype)
+    return np.clip(x, attrs.get('min', info.min), attrs.get('max', info.max))
+
+
+def _hard_sigmoid(x, attrs):
+    alpha = attrs.get('alpha', 0.2)
+    beta = attrs.get('beta', 0.5)
+    return np.clip(alpha * x + beta, 0, 1)
+
+
+def _leaky_relu(x, attrs):
+    return np.where(x > 0, x, attrs.get('alpha', 0.01) * x)
+
+
+_UNARY_OPS = {
+    'Abs': lambda x, attrs: np.abs(x),
+    'Ceil': lambda x, attrs: np.ceil(x),
+    'Clip': _clip,
+    'Elu': _elu,
+    'Exp': lambda x, attrs: np.exp(x),
+    'Floor': lambda x, attrs: np.floor(x),
+    'HardSigmoid': _hard_sigmoid,
+    'LeakyRelu': _leaky_relu,
+    'Log': lambda x, attrs: np.log(x),
+    'Neg': lambda x, attrs: np.negative(x),
+    'Reciprocal': lambda x, attrs: np.reciprocal(x),
+    'Relu': lambda x, attrs: np.maximum(x, 0),
+    'Selu': _selu,
+    'Sigmoid': lambda x, attrs: 1 / (1 + np.exp(-x)),
+    'Softplus': lambda x, attrs: np.log(np.exp(x) + 1),
+    'Softsign': lambda x, attrs: x / (1 + np.abs(x)),
+    'Sqrt': lambda x, attrs: np.sqrt(x),
+    'Tanh': lambda x, attrs: np.tanh(x),
+}
+
+_BINARY_OPS = {
+    'Add': np.add,
+    'Sub': np.subtract,
+    'Mul': np.multiply,
+    'Div': np.divide,
+    'Pow': np.power,
+}
+
+
+def run_node(node, inputs):
+    '''Computes the outputs of node from the list of its input arrays.
+    '''
+    attrs = {attr.name: helper.get_attribute_value(attr) for attr in node.attribute}
+    if node.domain != '':
+        raise ValueError('Unsupported domain: {}'.format(node.domain))
+    if node.op_type == 'FusedElementwise':
+        body = attrs['body']
+        values = run_graph(body, {vi.name: x for vi, x in zip(body.input, inputs)})
+        return [values[vi.name] for vi in body.output]
+    if node.op_type in _UNARY_OPS:
+        x = inputs[0]
+        return [_UNARY_OPS[node.op_type](x, attrs).astype(x.dtype)]
+    if node.op_type in _BINARY_OPS:
+        a, b = inputs
+        return [_BINARY_OPS[node.op_type](a, _broadcast(a, b, attrs)).astype(a.dtype)]
+    raise ValueError('Unsupported operator: {}'.format(node.op_type))
+
+
+def run_graph(graph, inputs):
+    '''Computes the outputs of graph, a graph of the operators allowed in the
+    body of FusedElementwise and of FusedElementwise nodes, from a dict of
+    input arrays. Returns a dict of all the values of the graph.
+    '''
+    values = dict(inputs)
+    for node in graph.node:
+        outputs = run_node(node, [values[name] for name in node.input])
+        values.update(zip(node.output, outputs))
+    return values
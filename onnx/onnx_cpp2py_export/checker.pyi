@@ -12,6 +12,8 @@ class ValidationError(object):
 
 def check_value_info(bytes: bytes, checker_context: CheckerContext) -> None: ...
 def check_tensor(bytes: bytes, checker_context: CheckerContext) -> None: ...
+def check_tensor_metadata(bytes: bytes, raw_data_size: int, checker_context: CheckerContext) -> None: ...
+def check_tensor_finite(bytes: bytes, raw_data: bytes, ctx: CheckerContext, chunk_size: int = ..., num_threads: int = ...) -> None: ...
 def check_attribute(bytes: bytes, checker_context: CheckerContext) -> None: ...
 def check_node(bytes: bytes, checker_context: CheckerContext) -> None: ...
 def check_graph(bytes: bytes, checker_context: CheckerContext) -> None: ...
@@ -1 +1,17 @@
-def infer_shapes(b: bytes) -> bytes: ...
+from typing import Dict, Optional, Text
+
+
+class InferenceCache(object):
+    hits: int = ...
+    misses: int = ...
+    hit_rate: float = ...
+    saved_seconds: float = ...
+
+
+class IncrementalInference(object):
+    def __init__(self, b: bytes) -> None: ...
+    def update_input_types(self, input_types: Dict[Text, bytes]) -> int: ...
+    def model(self) -> bytes: ...
+
+
+def infer_shapes(b: bytes, cache: Optional[InferenceCache] = None) -> bytes: ...
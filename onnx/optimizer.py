@@ -27,9 +27,23 @@ Supported pass names:
     -- nop
     -- eliminate_identity
     -- eliminate_nop_transpose
+    -- eliminate_broadcast_tile
     -- fuse_consecutive_transposes
+    -- fuse_consecutive_reshapes
     -- fuse_add_bias_into_conv
     -- fuse_transpose_into_gemm
+    -- fuse_matmul_add_bias_into_gemm
+    -- fuse_activation_into_conv_and_gemm
+    -- fuse_elementwise
+    -- fold_transpose_into_weights
+    -- sink_transposes
+    -- inference_mode
+    -- hoist_loop_invariants
+    -- inline_constant_control_flow
+    -- reorder_for_peak_memory
+    -- plan_memory
+    -- convert_to_nchw8c
+    -- convert_to_nchw16c
 """
 
 
@@ -44,3 +58,33 @@ def optimize(model, passes=None):
     model_str = model.SerializeToString()
     optimized_model_str = C.optimize(model_str, passes)
     return onnx.load_from_string(optimized_model_str)
+
+
+"""Apply the optimization on each of the provided ModelProtos.
+
+The models are optimized concurrently, as are the subgraphs of their If and
+Loop nodes, and the result is the same as applying optimize to each model.
+
+Arguments:
+    input (list of ModelProto): models
+    names (list of string): list of optimization names, see optimize
+    num_threads (int): number of threads, or 0 to use all the hardware
+        threads
+
+Return:
+    return (list of ModelProto) optimized models, in the same order
+"""
+
+
+def optimize_batch(models, passes=None, num_threads=0):
+    if passes is None or len(passes) == 0:
+        passes = ['eliminate_nop_transpose',
+                  'fuse_consecutive_transposes',
+                  'fuse_transpose_into_gemm']
+    for model in models:
+        if not isinstance(model, ModelProto):
+            raise ValueError('Optimizer only accepts ModelProto, incorrect type: {}'.format(type(model)))
+
+    model_strs = [model.SerializeToString() for model in models]
+    optimized_model_strs = C.optimize_batch(model_strs, passes, num_threads)
+    return [onnx.load_from_string(s) for s in optimized_model_strs]
@@ -0,0 +1,209 @@
+// ATTENTION: The code in this file is highly EXPERIMENTAL.
+// Adventurous users should note that the APIs will probably change.
+
+#include "onnx/optimizer/memory_plan.h"
+
+#include <algorithm>
+#include <set>
+#include <sstream>
+#include <unordered_map>
+
+#include "onnx/common/tensor.h"
+#include "onnx/optimizer/passes/optimize_pass.h"
+
+namespace ONNX_NAMESPACE { namespace optimization {
+
+namespace {
+
+// Returns true for ops computing each element of their output from the
+// element at the same position in their inputs.
+bool IsElementwise(Node* n) {
+  static const std::set<NodeKind> unary_kinds = {
+    Symbol("Abs"), Symbol("Ceil"), Symbol("Clip"), Symbol("Elu"), Symbol("Exp"),
+    Symbol("Floor"), Symbol("HardSigmoid"), Symbol("LeakyRelu"), Symbol("Log"),
+    kNeg, Symbol("Not"), Symbol("Reciprocal"), Symbol("Relu"), Symbol("Selu"),
+    kSigmoid, Symbol("Softplus"), Symbol("Softsign"), Symbol("Sqrt"), kTanh};
+  return n->domain().empty() && n->outputs().size() == 1 &&
+    (unary_kinds.count(n->kind()) > 0 || IsBroadcastElementwise(n->kind()));
+}
+
+int64_t AlignUp(int64_t x, int64_t alignment) {
+  return (x + alignment - 1) / alignment * alignment;
+}
+
+// A buffer shared by a value and the values computed in place of it.
+struct Buffer {
+  size_t first;
+  size_t last;
+  int64_t bytes;
+  int64_t offset;
+};
+
+bool Overlap(const Buffer& a, const Buffer& b) {
+  return a.first <= b.last && b.first <= a.last;
+}
+
+} // namespace
+
+int64_t ValueBytes(const Value* v) {
+  // the IR does not tell an unknown shape from a scalar
+  if (v->sizes().empty()) {
+    return 0;
+  }
+  int64_t bytes = static_cast<int64_t>(elementByteSize(v->elemType()));
+  for (const auto& d : v->sizes()) {
+    if (!d.is_int || d.dim < 0) {
+      return 0;
+    }
+    bytes *= d.dim;
+  }
+  return bytes;
+}
+
+std::vector<ValueLifetime> ComputeLifetimes(Graph& graph) {
+  std::vector<Node*> nodes;
+  std::unordered_map<Node*, size_t> index;
+  for (auto* n : graph.nodes()) {
+    if (n->kind() != kCaptured && n->kind() != kUndefined) {
+      index[n] = nodes.size();
+      nodes.push_back(n);
+    }
+  }
+  std::vector<ValueLifetime> lifetimes;
+  std::unordered_map<Value*, size_t> position;
+  std::unordered_map<std::string, Value*> values;
+  for (auto* n : nodes) {
+    for (auto* v : n->outputs()) {
+      if (!IsGraphOutput(v)) {
+        position[v] = lifetimes.size();
+        lifetimes.push_back({v, index[n], index[n]});
+        values[v->uniqueName()] = v;
+      }
+    }
+  }
+  for (auto* n : nodes) {
+    auto read = [&](Value* v) {
+      auto it = position.find(v);
+      if (it != position.end()) {
+        auto& lifetime = lifetimes[it->second];
+        lifetime.last = std::max(lifetime.last, index[n]);
+      }
+    };
+    for (auto* v : n->inputs()) {
+      read(v);
+    }
+    std::set<std::string> captured;
+    for (auto name : n->attributeNames()) {
+      if (n->kindOf(name) == AttributeKind::g) {
+        CollectCapturedNames(*n->g(name), &captured);
+      } else if (n->kindOf(name) == AttributeKind::gs) {
+        for (auto& g : n->gs(name)) {
+          CollectCapturedNames(*g, &captured);
+        }
+      }
+    }
+    for (const auto& name : captured) {
+      auto it = values.find(name);
+      if (it != values.end()) {
+        read(it->second);
+      }
+    }
+  }
+  return lifetimes;
+}
+
+std::string MemoryPlan::serialize() const {
+  std::ostringstream ss;
+  ss << "arena " << arena_bytes << "\n";
+  for (const auto& buffer : buffers) {
+    ss << buffer.offset << " " << buffer.bytes << " " << buffer.name << "\n";
+  }
+  return ss.str();
+}
+
+MemoryPlan PlanMemory(Graph& graph, int64_t alignment) {
+  auto lifetimes = ComputeLifetimes(graph);
+  std::unordered_map<Value*, size_t> position;
+  for (size_t i = 0; i < lifetimes.size(); i++) {
+    position[lifetimes[i].value] = i;
+  }
+
+  // values without a known size are not planned
+  const size_t none = lifetimes.size();
+  std::vector<size_t> buffer_of(lifetimes.size(), none);
+  std::vector<std::string> inplace_of(lifetimes.size());
+  std::vector<Buffer> buffers;
+  for (size_t i = 0; i < lifetimes.size(); i++) {
+    const auto& lifetime = lifetimes[i];
+    Value* y = lifetime.value;
+    int64_t bytes = ValueBytes(y);
+    if (bytes == 0) {
+      continue;
+    }
+    Node* n = y->node();
+    if (IsElementwise(n)) {
+      for (auto* x : n->inputs()) {
+        auto it = position.find(x);
+        if (it == position.end() || buffer_of[it->second] == none) {
+          continue;
+        }
+        auto& buffer = buffers[buffer_of[it->second]];
+        if (buffer.last == lifetime.first && buffer.bytes == bytes &&
+            x->elemType() == y->elemType()) {
+          buffer.last = lifetime.last;
+          buffer_of[i] = buffer_of[it->second];
+          inplace_of[i] = x->uniqueName();
+          break;
+        }
+      }
+    }
+    if (buffer_of[i] == none) {
+      buffer_of[i] = buffers.size();
+      buffers.push_back({lifetime.first, lifetime.last, bytes, 0});
+    }
+  }
+
+  std::vector<size_t> order(buffers.size());
+  for (size_t i = 0; i < order.size(); i++) {
+    order[i] = i;
+  }
+  std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+    return buffers[a].bytes > buffers[b].bytes;
+  });
+  MemoryPlan plan;
+  std::vector<size_t> placed;
+  for (auto i : order) {
+    auto& buffer = buffers[i];
+    std::vector<const Buffer*> live;
+    for (auto j : placed) {
+      if (Overlap(buffer, buffers[j])) {
+        live.push_back(&buffers[j]);
+      }
+    }
+    std::sort(live.begin(), live.end(), [](const Buffer* a, const Buffer* b) {
+      return a->offset < b->offset;
+    });
+    int64_t offset = 0;
+    for (const auto* other : live) {
+      if (offset + buffer.bytes <= other->offset) {
+        break;
+      }
+      offset = std::max(offset, AlignUp(other->offset + other->bytes, alignment));
+    }
+    buffer.offset = offset;
+    plan.arena_bytes = std::max(plan.arena_bytes, offset + buffer.bytes);
+    placed.push_back(i);
+  }
+
+  for (size_t i = 0; i < lifetimes.size(); i++) {
+    if (buffer_of[i] != none) {
+      plan.buffers.push_back({lifetimes[i].value->uniqueName(),
+                              buffers[buffer_of[i]].offset,
+                              ValueBytes(lifetimes[i].value),
+                              inplace_of[i]});
+    }
+  }
+  return plan;
+}
+
+}} // namespace ONNX_NAMESPACE::optimization
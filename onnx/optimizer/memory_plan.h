@@ -0,0 +1,63 @@
+// ATTENTION: The code in this file is highly EXPERIMENTAL.
+// Adventurous users should note that the APIs will probably change.
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "onnx/common/ir.h"
+
+namespace ONNX_NAMESPACE { namespace optimization {
+
+// Static memory planning for the values computed by the nodes of a graph,
+// when the nodes run in list order. The plan places every value of known
+// size in a single arena, so that a backend can allocate one buffer per
+// run instead of one per value.
+
+// Estimated size of v in bytes from its element type and sizes, or 0 if
+// they are not known. Empty sizes are taken as not known.
+int64_t ValueBytes(const Value* v);
+
+// The interval of nodes during which a value is live. Nodes are numbered
+// in list order, skipping the nodes that are not run.
+struct ValueLifetime {
+  Value* value;
+  // index of the node computing the value
+  size_t first;
+  // index of the last node reading the value, directly or from a nested
+  // graph, or of the node computing it if none does
+  size_t last;
+};
+
+// Returns the lifetimes of the values computed by the nodes of graph,
+// except graph outputs, in the order of their definition.
+std::vector<ValueLifetime> ComputeLifetimes(Graph& graph);
+
+struct BufferAssignment {
+  std::string name;
+  int64_t offset;
+  int64_t bytes;
+  // the input of the node computing the value whose buffer it reuses, or
+  // empty if the buffer is not reused
+  std::string inplace_of;
+};
+
+struct MemoryPlan {
+  int64_t arena_bytes = 0;
+  std::vector<BufferAssignment> buffers;
+
+  // One line "arena <arena_bytes>", followed by one line
+  // "<offset> <bytes> <name>" per buffer.
+  std::string serialize() const;
+};
+
+// Plans the values of graph with a known size that are not graph outputs.
+// Buffers are packed greedily by decreasing size at the lowest offset
+// that does not overlap a buffer of a value live at the same time, and
+// offsets are multiples of alignment. The output of an elementwise node
+// takes the buffer of an input of the same size whose lifetime ends at
+// the node.
+MemoryPlan PlanMemory(Graph& graph, int64_t alignment = 64);
+
+}} // namespace ONNX_NAMESPACE::optimization
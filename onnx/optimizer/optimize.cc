@@ -59,4 +59,17 @@ ONNX_NAMESPACE::ModelProto Optimize(
 
 }
 
+std::vector<ONNX_NAMESPACE::ModelProto> OptimizeBatch(
+    const std::vector<ONNX_NAMESPACE::ModelProto>& mps_in,
+    const std::vector<std::string>& names,
+    size_t num_threads) {
+  ThreadPool pool(num_threads);
+  Optimizer optimizer(&pool);
+  std::vector<ONNX_NAMESPACE::ModelProto> mps_out(mps_in.size());
+  pool.ParallelFor(mps_in.size(), [&](size_t i) {
+    mps_out[i] = optimizer.optimize(mps_in[i], names);
+  });
+  return mps_out;
+}
+
 }}
@@ -6,13 +6,27 @@
 #include "onnx/common/ir.h"
 #include "onnx/common/ir_pb_converter.h"
 #include "onnx/common/stl_backports.h"
+#include "onnx/common/thread_pool.h"
+#include "onnx/optimizer/passes/convert_to_nchwc.h"
+#include "onnx/optimizer/passes/eliminate_broadcast_tile.h"
 #include "onnx/optimizer/passes/eliminate_identity.h"
 #include "onnx/optimizer/passes/eliminate_nop_transpose.h"
+#include "onnx/optimizer/passes/fold_transpose_into_weights.h"
 #include "onnx/optimizer/passes/fuse_consecutive_transposes.h"
+#include "onnx/optimizer/passes/fuse_activation_into_conv_and_gemm.h"
 #include "onnx/optimizer/passes/fuse_add_bias_into_conv.h"
+#include "onnx/optimizer/passes/fuse_consecutive_reshapes.h"
+#include "onnx/optimizer/passes/fuse_elementwise.h"
+#include "onnx/optimizer/passes/fuse_matmul_add_bias_into_gemm.h"
 #include "onnx/optimizer/passes/fuse_transpose_into_gemm.h"
+#include "onnx/optimizer/passes/hoist_loop_invariants.h"
+#include "onnx/optimizer/passes/inline_constant_control_flow.h"
+#include "onnx/optimizer/passes/inference_mode.h"
 #include "onnx/optimizer/passes/lift_lexical_references.h"
 #include "onnx/optimizer/passes/nop.h"
+#include "onnx/optimizer/passes/plan_memory.h"
+#include "onnx/optimizer/passes/reorder_for_peak_memory.h"
+#include "onnx/optimizer/passes/sink_transposes.h"
 #include "onnx/optimizer/passes/split.h"
 #include "onnx/proto_utils.h"
 
@@ -22,14 +36,32 @@ ONNX_NAMESPACE::ModelProto PrepareOutput(const ONNX_NAMESPACE::ModelProto& mp_in
 
 struct Optimizer {
   std::map<std::string, std::unique_ptr<OptimizePass>> passes;
+  // Runs the nested graphs of a node concurrently when set.
+  ThreadPool* pool;
 
-  Optimizer() {
+  // Passes keep no state between calls, so an optimizer can optimize several
+  // models concurrently.
+  explicit Optimizer(ThreadPool* pool = nullptr) : pool(pool) {
     // Register the optimization passes to the optimizer.
     _registerOptimizer<EliminateIdentity>();
     _registerOptimizer<EliminateNopTranspose>();
     _registerOptimizer<FuseConsecutiveTransposes>();
+    _registerOptimizer<FuseConsecutiveReshapes>();
     _registerOptimizer<FuseTransposeIntoGemm>();
     _registerOptimizer<FuseAddBiasIntoConv>();
+    _registerOptimizer<FuseMatMulAddBiasIntoGemm>();
+    _registerOptimizer<FuseActivationIntoConvAndGemm>();
+    _registerOptimizer<FuseElementwise>();
+    _registerOptimizer<FoldTransposeIntoWeights>();
+    _registerOptimizer<SinkTransposes>();
+    _registerOptimizer<EliminateBroadcastTile>();
+    _registerOptimizer<InferenceMode>();
+    _registerOptimizer<HoistLoopInvariants>();
+    _registerOptimizer<InlineConstantControlFlow>();
+    _registerOptimizer<ReorderForPeakMemory>();
+    _registerOptimizer<PlanMemoryPass>();
+    _registerOptimizer<ConvertToNchwc>(8);
+    _registerOptimizer<ConvertToNchwc>(16);
     _registerOptimizer<Nop>();
     _registerOptimizer<SplitInit>();
     _registerOptimizer<SplitPredict>();
@@ -40,7 +72,7 @@ struct Optimizer {
 
   ONNX_NAMESPACE::ModelProto optimize(
       const ONNX_NAMESPACE::ModelProto& mp_in,
-      const std::vector<std::string>& names) {
+      const std::vector<std::string>& names) const {
     std::shared_ptr<ONNX_NAMESPACE::Graph> g(ONNX_NAMESPACE::ImportModelProto(mp_in));
 
     if (g.get() == nullptr) {
@@ -77,6 +109,7 @@ struct Optimizer {
 private:
   template<class Optimizer, class... Args> void _registerOptimizer(Args&& ...args) {
     auto optimizer = make_unique<Optimizer>(std::forward<Args>(args)...);
+    optimizer->pool = pool;
     passes[optimizer->name] = std::move(optimizer);
   }
 };
@@ -84,4 +117,12 @@ private:
 ONNX_NAMESPACE::ModelProto Optimize(
     const ONNX_NAMESPACE::ModelProto& mp_in,
     const std::vector<std::string>& names);
+
+// Applies the passes to each model, optimizing the models and the nested
+// graphs of their nodes concurrently on num_threads threads, or on all the
+// hardware threads if num_threads is 0.
+std::vector<ONNX_NAMESPACE::ModelProto> OptimizeBatch(
+    const std::vector<ONNX_NAMESPACE::ModelProto>& mps_in,
+    const std::vector<std::string>& names,
+    size_t num_threads = 0);
 }}
@@ -0,0 +1,374 @@
+// ATTENTION: The code in this file is highly EXPERIMENTAL.
+// Adventurous users should note that the APIs will probably change.
+
+#include "onnx/optimizer/partition.h"
+
+#include <algorithm>
+#include <map>
+#include <unordered_map>
+
+#include "onnx/common/ir_pb_converter.h"
+#include "onnx/optimizer/passes/optimize_pass.h"
+#include "onnx/string_utils.h"
+
+namespace ONNX_NAMESPACE { namespace optimization {
+
+namespace {
+
+// The nodes of a graph which are run, and the values each of them reads,
+// including the values captured by name by its nested graphs.
+struct Dependencies {
+  std::vector<Node*> nodes;
+  std::unordered_map<Node*, size_t> index;
+  std::unordered_map<Node*, std::vector<Value*>> reads;
+
+  explicit Dependencies(Graph& graph) {
+    std::unordered_map<std::string, Value*> values;
+    for (auto* v : graph.inputs()) {
+      values[v->uniqueName()] = v;
+    }
+    for (auto* n : graph.nodes()) {
+      if (n->kind() == kCaptured || n->kind() == kUndefined) {
+        continue;
+      }
+      index[n] = nodes.size();
+      nodes.push_back(n);
+      for (auto* v : n->outputs()) {
+        values[v->uniqueName()] = v;
+      }
+    }
+    for (auto* n : nodes) {
+      std::set<Value*> seen;
+      auto& read = reads[n];
+      for (auto* v : n->inputs()) {
+        if (v->node()->kind() != kUndefined && seen.insert(v).second) {
+          read.push_back(v);
+        }
+      }
+      std::set<std::string> captured;
+      for (auto name : n->attributeNames()) {
+        if (n->kindOf(name) == AttributeKind::g) {
+          CollectCapturedNames(*n->g(name), &captured);
+        } else if (n->kindOf(name) == AttributeKind::gs) {
+          for (auto& g : n->gs(name)) {
+            CollectCapturedNames(*g, &captured);
+          }
+        }
+      }
+      for (const auto& name : captured) {
+        auto it = values.find(name);
+        if (it != values.end() && seen.insert(it->second).second) {
+          read.push_back(it->second);
+        }
+      }
+    }
+  }
+
+  // Returns the index of the node computing v, or nodes.size() if v is an
+  // input of the graph.
+  size_t producer(Value* v) const {
+    auto it = index.find(v->node());
+    return it == index.end() ? nodes.size() : it->second;
+  }
+};
+
+// Adds to *closure the partitions of roots and all the partitions with a
+// path to them, given the partitions feeding each partition directly.
+void Upstream(
+    const std::vector<std::set<size_t>>& feeding,
+    const std::set<size_t>& roots,
+    std::set<size_t>* closure) {
+  std::vector<size_t> stack(roots.begin(), roots.end());
+  while (!stack.empty()) {
+    size_t p = stack.back();
+    stack.pop_back();
+    if (closure->insert(p).second) {
+      stack.insert(stack.end(), feeding[p].begin(), feeding[p].end());
+    }
+  }
+}
+
+// Sorts the nodes of graph so that every node follows the nodes it reads,
+// keeping the current order when possible.
+void SortNodes(Graph& graph) {
+  Dependencies deps(graph);
+  std::vector<size_t> pending(deps.nodes.size(), 0);
+  std::vector<std::vector<size_t>> readers(deps.nodes.size());
+  std::set<size_t> ready;
+  for (size_t i = 0; i < deps.nodes.size(); i++) {
+    for (auto* v : deps.reads[deps.nodes[i]]) {
+      size_t j = deps.producer(v);
+      if (j < deps.nodes.size()) {
+        pending[i]++;
+        readers[j].push_back(i);
+      }
+    }
+    if (pending[i] == 0) {
+      ready.insert(i);
+    }
+  }
+  size_t sorted = 0;
+  while (!ready.empty()) {
+    size_t i = *ready.begin();
+    ready.erase(ready.begin());
+    deps.nodes[i]->moveBefore(graph.return_node());
+    sorted++;
+    for (auto j : readers[i]) {
+      if (--pending[j] == 0) {
+        ready.insert(j);
+      }
+    }
+  }
+  ONNX_ASSERT(sorted == deps.nodes.size());
+}
+
+std::function<bool(Node*)> SupportedOps(
+    const std::set<std::string>& supported_ops) {
+  return [&supported_ops](Node* n) {
+    return n->domain().empty() && supported_ops.count(n->kind().toString()) > 0;
+  };
+}
+
+} // namespace
+
+std::vector<Partition> PartitionGraph(
+    Graph& graph,
+    const std::function<bool(Node*)>& supported) {
+  Dependencies deps(graph);
+  const size_t none = deps.nodes.size();
+  std::vector<size_t> partition_of(deps.nodes.size(), none);
+  // the partitions feeding each partition directly, or through nodes which
+  // are in no partition
+  std::vector<std::set<size_t>> feeding;
+  // the partitions feeding each node which is in no partition directly, or
+  // through nodes which are in no partition
+  std::vector<std::set<size_t>> reached(deps.nodes.size());
+  std::vector<std::vector<size_t>> members;
+  std::vector<std::set<Value*>> values_read;
+
+  for (size_t i = 0; i < deps.nodes.size(); i++) {
+    Node* n = deps.nodes[i];
+    std::set<size_t> sources;
+    std::map<size_t, size_t> reads_from;
+    std::set<size_t> roots;
+    for (auto* v : deps.reads[n]) {
+      size_t j = deps.producer(v);
+      if (j == none) {
+        continue;
+      }
+      size_t p = partition_of[j];
+      if (p == none) {
+        sources.insert(reached[j].begin(), reached[j].end());
+        roots.insert(reached[j].begin(), reached[j].end());
+      } else {
+        sources.insert(p);
+        reads_from[p]++;
+        roots.insert(feeding[p].begin(), feeding[p].end());
+      }
+    }
+    if (!supported(n)) {
+      reached[i] = std::move(sources);
+      continue;
+    }
+    // joining a partition with a path to n through other nodes would create
+    // a cycle between partitions
+    std::set<size_t> blocked;
+    Upstream(feeding, roots, &blocked);
+    // otherwise prefer the partition n reads the most values from, then the
+    // one sharing the most inputs with n
+    size_t best = none;
+    std::pair<size_t, size_t> best_score;
+    for (size_t p = 0; p < members.size(); p++) {
+      if (blocked.count(p) > 0) {
+        continue;
+      }
+      std::pair<size_t, size_t> score(reads_from[p], 0);
+      for (auto* v : deps.reads[n]) {
+        score.second += values_read[p].count(v);
+      }
+      if (best == none || score > best_score) {
+        best = p;
+        best_score = score;
+      }
+    }
+    if (best == none) {
+      best = members.size();
+      members.emplace_back();
+      feeding.emplace_back();
+      values_read.emplace_back();
+    }
+    values_read[best].insert(deps.reads[n].begin(), deps.reads[n].end());
+    partition_of[i] = best;
+    members[best].push_back(i);
+    sources.erase(best);
+    feeding[best].insert(sources.begin(), sources.end());
+  }
+
+  // the partitions reading each value, including none for the nodes which
+  // are in no partition
+  std::unordered_map<Value*, std::set<size_t>> read_by;
+  for (size_t j = 0; j < deps.nodes.size(); j++) {
+    for (auto* v : deps.reads[deps.nodes[j]]) {
+      read_by[v].insert(partition_of[j]);
+    }
+  }
+
+  std::vector<Partition> partitions(members.size());
+  for (size_t p = 0; p < members.size(); p++) {
+    auto& partition = partitions[p];
+    std::set<Value*> inputs;
+    for (auto i : members[p]) {
+      Node* n = deps.nodes[i];
+      partition.nodes.push_back(n);
+      for (auto* v : deps.reads[n]) {
+        size_t j = deps.producer(v);
+        if ((j == none || partition_of[j] != p) && inputs.insert(v).second) {
+          partition.inputs.push_back(v);
+        }
+      }
+    }
+    for (auto i : members[p]) {
+      for (auto* v : deps.nodes[i]->outputs()) {
+        auto it = read_by.find(v);
+        bool used_outside = IsGraphOutput(v) ||
+          (it != read_by.end() &&
+           (it->second.size() > 1 || *it->second.begin() != p));
+        if (used_outside) {
+          partition.outputs.push_back(v);
+        }
+      }
+    }
+  }
+
+  // A Partition node has at least one input and one output. Leaving such a
+  // partition out cannot create a cycle, as no other partition reads it or
+  // feeds it.
+  partitions.erase(
+      std::remove_if(
+          partitions.begin(),
+          partitions.end(),
+          [](const Partition& partition) {
+            return partition.inputs.empty() || partition.outputs.empty();
+          }),
+      partitions.end());
+  return partitions;
+}
+
+std::vector<Partition> PartitionGraph(
+    Graph& graph,
+    const std::set<std::string>& supported_ops) {
+  return PartitionGraph(graph, SupportedOps(supported_ops));
+}
+
+ModelProto ExportPartition(
+    Graph& graph,
+    const Partition& partition,
+    const std::string& name) {
+  std::shared_ptr<Graph> g(new Graph());
+  g->setName(name);
+  g->opset_versions_mutable() = graph.opset_versions();
+  std::unordered_map<Value*, Value*> env;
+  for (auto* v : partition.inputs) {
+    env[v] = g->addInput()->copyMetadata(v);
+    const auto& names = graph.initializer_names();
+    for (size_t i = 0; i < names.size(); i++) {
+      if (names[i] == v->uniqueName()) {
+        g->addInitializer(graph.initializers()[i], names[i]);
+      }
+    }
+  }
+  Value* undefined = nullptr;
+  for (auto* n : partition.nodes) {
+    Node* c = g->create(n->kind(), n->outputs().size());
+    for (auto* v : n->inputs()) {
+      if (v->node()->kind() == kUndefined) {
+        if (undefined == nullptr) {
+          undefined = g->appendNode(g->create(kUndefined))->output();
+        }
+        c->addInput(undefined);
+      } else {
+        c->addInput(env.at(v));
+      }
+    }
+    c->copyAttributes(*n);
+    if (n->has_name()) {
+      c->setName(n->name());
+    }
+    if (!n->domain().empty()) {
+      c->setDomain(n->domain());
+    }
+    g->appendNode(c);
+    for (size_t i = 0; i < n->outputs().size(); i++) {
+      env[n->outputs()[i]] = c->outputs()[i]->copyMetadata(n->outputs()[i]);
+    }
+  }
+  for (auto* v : partition.outputs) {
+    g->registerOutput(env.at(v));
+  }
+  ModelProto mp;
+  mp.set_ir_version(IR_VERSION);
+  ExportModelProto(&mp, g);
+  return mp;
+}
+
+std::vector<Node*> ReplacePartitions(
+    Graph& graph,
+    const std::vector<Partition>& partitions,
+    const std::string& prefix) {
+  // outputs of the partitions replaced so far, by the outputs of their
+  // Partition node
+  std::unordered_map<Value*, Value*> replaced;
+  std::vector<Node*> calls;
+  for (size_t k = 0; k < partitions.size(); k++) {
+    const auto& partition = partitions[k];
+    Node* call = graph.create(Symbol("Partition"), partition.outputs.size());
+    for (auto* v : partition.inputs) {
+      auto it = replaced.find(v);
+      call->addInput(it == replaced.end() ? v : it->second);
+    }
+    call->s_(Symbol("partition"), prefix + ONNX_NAMESPACE::to_string(k));
+    call->insertBefore(partition.nodes.front());
+    for (size_t i = 0; i < partition.outputs.size(); i++) {
+      Value* v = partition.outputs[i];
+      Value* y = call->outputs()[i]->copyMetadata(v);
+      v->replaceAllUsesWith(y);
+      replaced[v] = y;
+    }
+    for (auto it = partition.nodes.rbegin(); it != partition.nodes.rend(); ++it) {
+      (*it)->destroy();
+    }
+    calls.push_back(call);
+  }
+  SortNodes(graph);
+  return calls;
+}
+
+ModelProto PartitionModel(
+    const ModelProto& mp,
+    const std::function<bool(Node*)>& supported,
+    std::vector<ModelProto>* partitions) {
+  std::shared_ptr<Graph> graph(ImportModelProto(mp));
+  ModelProto result = mp;
+  if (graph == nullptr) {
+    return result;
+  }
+  const std::string prefix = "partition_";
+  auto found = PartitionGraph(*graph, supported);
+  for (size_t k = 0; k < found.size(); k++) {
+    partitions->push_back(
+        ExportPartition(*graph, found[k], prefix + ONNX_NAMESPACE::to_string(k)));
+    partitions->back().set_ir_version(mp.ir_version());
+  }
+  ReplacePartitions(*graph, found, prefix);
+  ExportModelProto(&result, graph);
+  return result;
+}
+
+ModelProto PartitionModel(
+    const ModelProto& mp,
+    const std::set<std::string>& supported_ops,
+    std::vector<ModelProto>* partitions) {
+  return PartitionModel(mp, SupportedOps(supported_ops), partitions);
+}
+
+}} // namespace ONNX_NAMESPACE::optimization
@@ -0,0 +1,83 @@
+// ATTENTION: The code in this file is highly EXPERIMENTAL.
+// Adventurous users should note that the APIs will probably change.
+
+#pragma once
+
+#include <functional>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "onnx/common/ir.h"
+#include "onnx/onnx_pb.h"
+
+namespace ONNX_NAMESPACE { namespace optimization {
+
+// Partitioning of the main graph of a model between a backend supporting
+// some of its ops, such as an ONNXIFI backend, and the runtime running the
+// others. Each partition is exported as a model of its own, and replaced in
+// the graph by a Partition node referring to that model by name.
+
+struct Partition {
+  // in graph order
+  std::vector<Node*> nodes;
+  // the values read by the nodes, or captured by their nested graphs, which
+  // are not computed by the partition, in order of first use
+  std::vector<Value*> inputs;
+  // the values computed by the partition which are read outside of it or
+  // are outputs of the graph, in order of definition
+  std::vector<Value*> outputs;
+};
+
+// Groups the nodes of graph for which supported returns true into
+// partitions. Every path between two nodes of a partition stays in the
+// partition, and replacing each partition by a single node keeps the graph
+// acyclic. Nodes are visited in graph order, and a supported node joins a
+// partition when that keeps these properties, preferring the one it reads
+// the most values from, then the one sharing the most inputs with it, so
+// that few values cross partitions. Partitions without inputs, which only
+// compute constants, or without outputs, which compute nothing used, are
+// left out. Partitions are returned in the order of their first node.
+std::vector<Partition> PartitionGraph(
+    Graph& graph,
+    const std::function<bool(Node*)>& supported);
+
+// Same, for the nodes of the default domain whose op type is in
+// supported_ops.
+std::vector<Partition> PartitionGraph(
+    Graph& graph,
+    const std::set<std::string>& supported_ops);
+
+// Returns a model computing partition, named name, whose inputs and outputs
+// are those of the partition. Inputs that are initializers of graph are also
+// initializers of the model.
+ModelProto ExportPartition(
+    Graph& graph,
+    const Partition& partition,
+    const std::string& name);
+
+// Replaces the nodes of each partition i by a Partition node whose
+// partition attribute is prefix followed by i, and whose inputs and outputs
+// are those of the partition. The nodes of graph are then sorted so that
+// every node follows the nodes it reads. Returns the Partition nodes.
+std::vector<Node*> ReplacePartitions(
+    Graph& graph,
+    const std::vector<Partition>& partitions,
+    const std::string& prefix);
+
+// Partitions the main graph of mp, appends the model of each partition to
+// *partitions, named "partition_<i>", and returns mp with the partitions
+// replaced by Partition nodes.
+ModelProto PartitionModel(
+    const ModelProto& mp,
+    const std::function<bool(Node*)>& supported,
+    std::vector<ModelProto>* partitions);
+
+// Same, for the nodes of the default domain whose op type is in
+// supported_ops.
+ModelProto PartitionModel(
+    const ModelProto& mp,
+    const std::set<std::string>& supported_ops,
+    std::vector<ModelProto>* partitions);
+
+}} // namespace ONNX_NAMESPACE::optimization
@@ -0,0 +1,108 @@
+// ATTENTION: The code in this file is highly EXPERIMENTAL.
+// Adventurous users should note that the APIs will probably change.
+
+#pragma once
+
+#include <algorithm>
+
+#include "onnx/common/ir.h"
+
+namespace ONNX_NAMESPACE { namespace optimization {
+
+// Helpers for passes that inspect or rewrite constant values, i.e. outputs
+// of Constant nodes or graph inputs backed by an initializer.
+
+// Returns the tensor holding the value of v, or nullptr if v is not a
+// constant. The pointer is invalidated by any change to the initializers
+// of the owning graph.
+inline const Tensor* getConstantTensor(Value* v) {
+  if (v->node()->kind() == kConstant) {
+    return &v->node()->t(kvalue);
+  }
+  if (v->node()->kind() == kParam) {
+    Graph* graph = v->owningGraph();
+    const auto& names = graph->initializer_names();
+    auto pos = std::find(names.begin(), names.end(), v->uniqueName());
+    if (pos != names.end()) {
+      return &graph->initializers()[static_cast<size_t>(pos - names.begin())];
+    }
+  }
+  return nullptr;
+}
+
+// Replaces the value of the constant v with t, updating the sizes of v.
+// v must be a constant as defined by getConstantTensor.
+inline void setConstantTensor(Value* v, Tensor t) {
+  std::vector<Dimension> sizes;
+  for (auto d : t.sizes()) {
+    sizes.push_back(Dimension(static_cast<int>(d)));
+  }
+  if (v->node()->kind() == kConstant) {
+    v->node()->t_(kvalue, std::move(t));
+  } else {
+    Graph* graph = v->owningGraph();
+    graph->eraseInitializer(v->uniqueName());
+    graph->addInitializer(std::move(t), v->uniqueName());
+  }
+  v->setSizes(sizes);
+}
+
+inline int64_t numElements(const Tensor& t) {
+  int64_t n = 1;
+  for (auto d : t.sizes()) {
+    n *= d;
+  }
+  return n;
+}
+
+// Reads the value of an int64 constant into *values. Returns false if v is
+// not an int64 constant.
+inline bool getConstantInt64s(Value* v, std::vector<int64_t>* values) {
+  const Tensor* t = getConstantTensor(v);
+  if (t == nullptr || t->elem_type() != TensorProto_DataType_INT64 || t->is_segment()) {
+    return false;
+  }
+  if (t->raw().empty()) {
+    *values = t->int64s();
+  } else {
+    values->resize(t->raw().size() / sizeof(int64_t));
+    t->raw().copy(reinterpret_cast<char*>(values->data()), values->size() * sizeof(int64_t));
+  }
+  return true;
+}
+
+// Reads the value of a float constant into *values. Returns false if v is
+// not a float constant.
+inline bool getConstantFloats(Value* v, std::vector<float>* values) {
+  const Tensor* t = getConstantTensor(v);
+  if (t == nullptr || t->elem_type() != TensorProto_DataType_FLOAT || t->is_segment()) {
+    return false;
+  }
+  if (t->raw().empty()) {
+    *values = t->floats();
+  } else {
+    values->resize(t->raw().size() / sizeof(float));
+    t->raw().copy(reinterpret_cast<char*>(values->data()), values->size() * sizeof(float));
+  }
+  return true;
+}
+
+// Physically transposes the data of the constant v with the given
+// permutation. Only constants with a single use are rewritten, since the
+// new value replaces the old one in place. Returns false if v could not be
+// rewritten.
+inline bool transposeConstant(Value* v, const std::vector<int64_t>& perm) {
+  if (v->uses().size() != 1) {
+    return false;
+  }
+  const Tensor* orig = getConstantTensor(v);
+  if (orig == nullptr || orig->is_segment() || orig->sizes().size() != perm.size()) {
+    return false;
+  }
+  Tensor t = *orig;
+  t.transpose(perm);
+  setConstantTensor(v, std::move(t));
+  return true;
+}
+
+}} // namespace ONNX_NAMESPACE::optimization
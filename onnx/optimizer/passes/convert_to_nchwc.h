@@ -0,0 +1,370 @@
+// ATTENTION: The code in this file is highly EXPERIMENTAL.
+// Adventurous users should note that the APIs will probably change.
+
+#pragma once
+
+// Before:
+//   Y = Relu(MaxPool(Conv(X, W, B)))
+// After:
+//   Xc = ai.onnx.nchwc.ReorderInput(X, channels_block=8)
+//   Yc = Relu(ai.onnx.nchwc.MaxPool(ai.onnx.nchwc.Conv(Xc, W', B')))
+//   Y = ai.onnx.nchwc.ReorderOutput(Yc, channels=M)
+//
+// Rewrites regions of Conv, MaxPool, AveragePool, BatchNormalization and
+// elementwise ops into the blocked NCHWc layout of the ai.onnx.nchwc domain,
+// where the channels are stored in blocks of 8 or 16 to match the vector
+// width of the target. Reorder nodes are only inserted at the boundaries of
+// the regions:
+//   - a region starts at a Conv, which has its input reordered if needed;
+//   - pooling, BatchNormalization (in test mode) and elementwise ops join
+//     the region of their blocked inputs, elementwise ops keeping their
+//     domain since they do not depend on the layout;
+//   - values used outside of the region are reordered back, and keep their
+//     name.
+// Weights and other parameters are reordered and padded ahead of time, so
+// only Conv ops with float constant weights and a single group are
+// converted. The padding channels of blocked values always hold finite
+// values, which are multiplied by zero weights in the next Conv, so only
+// elementwise ops mapping finite values to finite values are converted.
+
+#include <atomic>
+#include <set>
+#include <unordered_map>
+
+#include "onnx/defs/schema.h"
+#include "onnx/optimizer/passes/constant_util.h"
+#include "onnx/optimizer/passes/optimize_pass.h"
+
+namespace ONNX_NAMESPACE { namespace optimization {
+
+struct ConvertToNchwc final : public OptimizePass {
+  explicit ConvertToNchwc(int64_t block)
+    : OptimizePass("convert_to_nchw" + ONNX_NAMESPACE::to_string(block) + "c", API_TYPE::IR),
+      block_(block) {
+  }
+
+  // A value in the blocked layout, standing for a value with `channels`
+  // channels in the NCHW layout.
+  struct Blocked {
+    Value* value;
+    int64_t channels;
+  };
+
+  // State of the conversion of a graph.
+  struct Conversion {
+    // values of the graph and their blocked counterparts
+    std::unordered_map<Value*, Blocked> blocked;
+    // filters and their reordered copies, shared by the Conv ops using them
+    std::unordered_map<Value*, Value*> filters;
+    // parameters that could not be rewritten in place
+    std::vector<Value*> replaced;
+  };
+
+  static bool is_elementwise(Node* n) {
+    static const std::set<NodeKind> unary_kinds = {
+      Symbol("Abs"), Symbol("Clip"), Symbol("Elu"), Symbol("HardSigmoid"),
+      Symbol("LeakyRelu"), kNeg, Symbol("Relu"), Symbol("Selu"), kSigmoid,
+      Symbol("Softsign"), kTanh};
+    // binary ops are only converted without broadcasting
+    static const std::set<NodeKind> nary_kinds = {
+      kAdd, Symbol("Max"), Symbol("Mean"), Symbol("Min"), kMul, kSub,
+      Symbol("Sum")};
+    if (n->outputs().size() != 1) {
+      return false;
+    }
+    if (unary_kinds.count(n->kind()) > 0) {
+      return true;
+    }
+    return nary_kinds.count(n->kind()) > 0 &&
+      !(n->hasAttribute(kbroadcast) && n->i(kbroadcast) != 0);
+  }
+
+  static bool has_default_auto_pad(Node* n) {
+    return !n->hasAttribute(Symbol("auto_pad")) || n->s(Symbol("auto_pad")) == "NOTSET";
+  }
+
+  // Sizes of the blocked value standing for a value of sizes `sizes`.
+  std::vector<Dimension> blocked_sizes(const std::vector<Dimension>& sizes) const {
+    if (sizes.size() < 2 || !sizes[1].is_int) {
+      return {};
+    }
+    std::vector<Dimension> result = sizes;
+    result[1] = Dimension(static_cast<int>((sizes[1].dim + block_ - 1) / block_));
+    result.push_back(Dimension(static_cast<int>(block_)));
+    return result;
+  }
+
+  // Returns a value holding the float tensor t, replacing the constant v in
+  // place when n is its only user. Otherwise v is recorded as replaced, to
+  // be removed if it ends up unused.
+  static Value* replace_constant(Graph& graph, Node* n, Value* v, Tensor t,
+      Conversion* conversion) {
+    if (v->uses().size() == 1) {
+      setConstantTensor(v, std::move(t));
+      return v;
+    }
+    conversion->replaced.push_back(v);
+    Node* constant = graph.create(kConstant, 1);
+    std::vector<Dimension> sizes;
+    for (auto d : t.sizes()) {
+      sizes.push_back(Dimension(static_cast<int>(d)));
+    }
+    constant->t_(kvalue, std::move(t));
+    constant->output()->setSizes(sizes);
+    constant->output()->setElemType(TensorProto_DataType_FLOAT);
+    constant->insertBefore(n);
+    return constant->output();
+  }
+
+  // Pads the 1D parameter `values` of `channels` elements to a multiple of
+  // the block size with `fill`.
+  Tensor padded_parameter(std::vector<float> values, int64_t channels, float fill) const {
+    const int64_t padded = (channels + block_ - 1) / block_ * block_;
+    values.resize(static_cast<size_t>(padded), fill);
+    Tensor t;
+    t.elem_type() = TensorProto_DataType_FLOAT;
+    t.sizes().push_back(padded);
+    t.floats() = std::move(values);
+    return t;
+  }
+
+  // Reorders the filter w of sizes (M x C x k1 x ... x kn) to
+  // (ceil(M/c) x ceil(C/c) x k1 x ... x kn x c x c), the last two dimensions
+  // being the input and output channels of a block.
+  Tensor blocked_weights(const std::vector<float>& w, const std::vector<int64_t>& sizes) const {
+    const int64_t m = sizes[0], c = sizes[1];
+    const int64_t m_blocks = (m + block_ - 1) / block_;
+    const int64_t c_blocks = (c + block_ - 1) / block_;
+    int64_t kernel_size = 1;
+    for (size_t i = 2; i < sizes.size(); i++) {
+      kernel_size *= sizes[i];
+    }
+    std::vector<float> data(static_cast<size_t>(m_blocks * c_blocks * kernel_size * block_ * block_), 0.0f);
+    for (int64_t oc = 0; oc < m; oc++) {
+      for (int64_t ic = 0; ic < c; ic++) {
+        for (int64_t k = 0; k < kernel_size; k++) {
+          int64_t dst = (((oc / block_) * c_blocks + ic / block_) * kernel_size + k) * block_ * block_ +
+            (ic % block_) * block_ + oc % block_;
+          data[static_cast<size_t>(dst)] = w[static_cast<size_t>((oc * c + ic) * kernel_size + k)];
+        }
+      }
+    }
+    Tensor t;
+    t.elem_type() = TensorProto_DataType_FLOAT;
+    t.sizes() = {m_blocks, c_blocks};
+    for (size_t i = 2; i < sizes.size(); i++) {
+      t.sizes().push_back(sizes[i]);
+    }
+    t.sizes().push_back(block_);
+    t.sizes().push_back(block_);
+    t.floats() = std::move(data);
+    return t;
+  }
+
+  // Creates the node of the blocked domain replacing n, or returns nullptr
+  // if n cannot be converted. *channels is set to the number of channels of
+  // the output.
+  Node* convert(Graph& graph, Node* n, Conversion* conversion, int64_t* channels) {
+    auto& blocked = conversion->blocked;
+    auto find_blocked = [&blocked](Value* v) -> const Blocked* {
+      auto it = blocked.find(v);
+      return it == blocked.end() ? nullptr : &it->second;
+    };
+
+    if (n->kind() == kConv) {
+      if (n->inputs().size() < 2 || n->inputs().size() > 3 || !has_default_auto_pad(n) ||
+          (n->hasAttribute(kgroup) && n->i(kgroup) != 1)) {
+        return nullptr;
+      }
+      const Tensor* w = getConstantTensor(n->inputs()[1]);
+      std::vector<float> w_data, b_data;
+      if (w == nullptr || w->sizes().size() < 3 ||
+          !getConstantFloats(n->inputs()[1], &w_data) ||
+          static_cast<int64_t>(w_data.size()) != numElements(*w)) {
+        return nullptr;
+      }
+      const auto w_sizes = w->sizes();
+      const int64_t m = w_sizes[0], c = w_sizes[1];
+      if (n->inputs().size() == 3 &&
+          (!getConstantFloats(n->inputs()[2], &b_data) || static_cast<int64_t>(b_data.size()) != m)) {
+        return nullptr;
+      }
+      auto x = n->inputs()[0];
+      const Blocked* bx = find_blocked(x);
+      if (bx != nullptr && bx->channels != c) {
+        return nullptr;
+      }
+      if (bx == nullptr) {
+        Node* reorder = graph.create(Symbol("ReorderInput"), 1);
+        reorder->setDomain(AI_ONNX_NCHWC_DOMAIN);
+        reorder->i_(Symbol("channels_block"), block_);
+        reorder->addInput(x);
+        reorder->insertBefore(n);
+        reorder->output()->setSizes(blocked_sizes(x->sizes()));
+        reorder->output()->setElemType(x->elemType());
+        bx = &(blocked[x] = Blocked{reorder->output(), c});
+      }
+      Node* conv = graph.create(kConv, 1);
+      conv->setDomain(AI_ONNX_NCHWC_DOMAIN);
+      conv->copyAttributes(*n);
+      if (conv->hasAttribute(kgroup)) {
+        conv->removeAttribute(kgroup);
+      }
+      if (conv->hasAttribute(Symbol("auto_pad"))) {
+        conv->removeAttribute(Symbol("auto_pad"));
+      }
+      conv->addInput(bx->value);
+      auto filter = conversion->filters.find(n->inputs()[1]);
+      if (filter == conversion->filters.end()) {
+        Value* reordered = replace_constant(
+            graph, n, n->inputs()[1], blocked_weights(w_data, w_sizes), conversion);
+        filter = conversion->filters.emplace(n->inputs()[1], reordered).first;
+      }
+      conv->addInput(filter->second);
+      if (n->inputs().size() == 3) {
+        conv->addInput(replace_constant(graph, n, n->inputs()[2], padded_parameter(b_data, m, 0.0f), conversion));
+      }
+      *channels = m;
+      return conv;
+    }
+
+    if (n->inputs().empty() || find_blocked(n->inputs()[0]) == nullptr) {
+      return nullptr;
+    }
+    const Blocked bx = *find_blocked(n->inputs()[0]);
+    *channels = bx.channels;
+
+    if (n->kind() == Symbol("MaxPool") || n->kind() == Symbol("AveragePool")) {
+      if (n->outputs().size() != 1 || !has_default_auto_pad(n)) {
+        return nullptr;
+      }
+      Node* pool = graph.create(n->kind(), 1);
+      pool->setDomain(AI_ONNX_NCHWC_DOMAIN);
+      pool->copyAttributes(*n);
+      if (pool->hasAttribute(Symbol("auto_pad"))) {
+        pool->removeAttribute(Symbol("auto_pad"));
+      }
+      pool->addInput(bx.value);
+      return pool;
+    }
+
+    if (n->kind() == kBatchNormalization) {
+      // only the test mode computes a single output
+      if (n->outputs().size() != 1 || n->inputs().size() != 5 ||
+          (n->hasAttribute(Symbol("spatial")) && n->i(Symbol("spatial")) != 1)) {
+        return nullptr;
+      }
+      // scale, B, mean and var, and the values of their padding
+      std::vector<std::vector<float>> params(4);
+      const float fill[] = {0.0f, 0.0f, 0.0f, 1.0f};
+      for (size_t i = 0; i < params.size(); i++) {
+        if (!getConstantFloats(n->inputs()[i + 1], &params[i]) ||
+            static_cast<int64_t>(params[i].size()) != bx.channels) {
+          return nullptr;
+        }
+      }
+      Node* bn = graph.create(kBatchNormalization, 1);
+      bn->setDomain(AI_ONNX_NCHWC_DOMAIN);
+      if (n->hasAttribute(kepsilon)) {
+        bn->f_(kepsilon, n->f(kepsilon));
+      }
+      bn->addInput(bx.value);
+      for (size_t i = 0; i < params.size(); i++) {
+        bn->addInput(replace_constant(graph, n, n->inputs()[i + 1],
+              padded_parameter(std::move(params[i]), bx.channels, fill[i]), conversion));
+      }
+      return bn;
+    }
+
+    if (is_elementwise(n)) {
+      // all inputs must have the same shape in the blocked layout
+      for (auto v : n->inputs()) {
+        const Blocked* bv = find_blocked(v);
+        if (bv == nullptr || bv->channels != bx.channels ||
+            bv->value->sizes().empty() || bv->value->sizes().size() != bx.value->sizes().size()) {
+          return nullptr;
+        }
+        for (size_t i = 0; i < bv->value->sizes().size(); i++) {
+          const auto& a = bv->value->sizes()[i];
+          const auto& b = bx.value->sizes()[i];
+          if (!a.is_int || !b.is_int || a.dim != b.dim) {
+            return nullptr;
+          }
+        }
+      }
+      Node* elementwise = graph.create(n->kind(), 1);
+      elementwise->copyAttributes(*n);
+      for (auto v : n->inputs()) {
+        elementwise->addInput(blocked[v].value);
+      }
+      return elementwise;
+    }
+    return nullptr;
+  }
+
+  // Converts the regions of graph, returning true if any node was converted.
+  bool convert_to_nchwc(Graph& graph) {
+    // nested graphs may be converted concurrently
+    std::atomic<bool> changed(false);
+    for (auto* n : graph.nodes()) {
+      DescendOnGraphAttributes(n, [this, &changed](Graph& g){
+        if (convert_to_nchwc(g)) {
+          changed = true;
+        }
+      });
+    }
+    std::set<std::string> captured;
+    CollectCapturedNames(graph, &captured);
+
+    Conversion conversion;
+    std::vector<Node*> reorders;
+    for (auto it = graph.begin(); it != graph.end(); ++it) {
+      auto* n = *it;
+      int64_t channels = 0;
+      Node* converted = convert(graph, n, &conversion, &channels);
+      if (converted == nullptr) {
+        continue;
+      }
+      auto y = n->output();
+      converted->insertBefore(n);
+      converted->output()->setSizes(blocked_sizes(y->sizes()));
+      converted->output()->setElemType(y->elemType());
+      // The uses of y are moved to a ReorderOutput, which is removed at the
+      // end if the value is only used in the blocked layout.
+      Node* reorder = graph.create(Symbol("ReorderOutput"), 1);
+      reorder->setDomain(AI_ONNX_NCHWC_DOMAIN);
+      reorder->i_(Symbol("channels"), channels);
+      reorder->addInput(converted->output());
+      reorder->insertBefore(n);
+      reorder->output()->copyMetadata(y);
+      y->replaceAllUsesWith(reorder->output());
+      conversion.blocked[reorder->output()] = Blocked{converted->output(), channels};
+      reorders.push_back(reorder);
+      it.destroyCurrent();
+      changed = true;
+    }
+    for (auto* reorder : reorders) {
+      if (reorder->output()->uses().empty() && captured.count(reorder->output()->uniqueName()) == 0) {
+        reorder->destroy();
+      }
+    }
+    for (auto* v : conversion.replaced) {
+      if (v->node()->kind() == kConstant && v->uses().empty() &&
+          captured.count(v->uniqueName()) == 0) {
+        v->node()->destroy();
+      }
+    }
+    return changed;
+  }
+
+  void optimize(Graph& graph) override {
+    if (convert_to_nchwc(graph)) {
+      graph.addOpSetImport(AI_ONNX_NCHWC_DOMAIN, 1);
+    }
+  }
+
+private:
+  const int64_t block_;
+};
+
+}} // namespace ONNX_NAMESPACE::optimization
@@ -0,0 +1,154 @@
+// ATTENTION: The code in this file is highly EXPERIMENTAL.
+// Adventurous users should note that the APIs will probably change.
+
+#pragma once
+
+// Before:
+//   T = Tile(X, repeats)       with shape(X) = (1, 3, 1), repeats = (2, 1, 4)
+//   Y = Add(A, T)              with shape(A) = (2, 3, 4)
+// After:
+//   Y = Add(A, Squeeze(X, axes=[0, 2]), broadcast=1, axis=1)
+//
+// A Tile that only repeats dimensions of size 1 and whose only consumers
+// are elementwise ops with limited broadcast support is removed, and the
+// consumers broadcast the original tensor instead, so the full-size tensor
+// is never materialized. The tiled dimensions have to be leading or
+// trailing ones, since the broadcast operand has to match a contiguous
+// range of dimensions of the other operand.
+
+#include <set>
+
+#include "onnx/optimizer/passes/constant_util.h"
+#include "onnx/optimizer/passes/optimize_pass.h"
+
+namespace ONNX_NAMESPACE { namespace optimization {
+
+struct EliminateBroadcastTile final : public OptimizePass {
+  explicit EliminateBroadcastTile()
+    : OptimizePass("eliminate_broadcast_tile", API_TYPE::IR) {
+  }
+
+  static bool is_commutative(NodeKind kind) {
+    static const std::set<NodeKind> kinds = {
+      kAdd, Symbol("And"), Symbol("Equal"), kMul, Symbol("Or"), Symbol("Xor")};
+    return kinds.count(kind) > 0;
+  }
+
+  static bool has_sizes(Value* v, const std::vector<int64_t>& sizes) {
+    if (v->sizes().size() != sizes.size()) {
+      return false;
+    }
+    for (size_t i = 0; i < sizes.size(); i++) {
+      if (!v->sizes()[i].is_int || v->sizes()[i].dim != sizes[i]) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  void eliminate_broadcast_tile(Graph& graph) {
+    for (auto it = graph.begin(); it != graph.end(); ++it) {
+      auto* n = *it;
+      DescendOnGraphAttributes(n, [this](Graph& g){eliminate_broadcast_tile(g);});
+      if (n->kind() != kTile || n->inputs().size() != 2 || IsGraphOutput(n->output())) {
+        continue;
+      }
+      auto x = n->inputs()[0];
+      std::vector<int64_t> repeats;
+      if (!getConstantInt64s(n->inputs()[1], &repeats) || x->sizes().size() != repeats.size()) {
+        continue;
+      }
+      const size_t rank = repeats.size();
+      std::vector<int64_t> x_sizes, tiled_sizes;
+      bool able_to_optimize = true;
+      for (size_t i = 0; i < rank; i++) {
+        const auto& d = x->sizes()[i];
+        // only dimensions of size 1 can be broadcast
+        able_to_optimize &= d.is_int && (repeats[i] == 1 || d.dim == 1);
+        x_sizes.push_back(d.dim);
+        tiled_sizes.push_back(d.dim * repeats[i]);
+      }
+      // the broadcast operand covers dimensions [lo, hi) of the tiled shape
+      size_t lo = 0, hi = rank;
+      while (lo < rank && repeats[lo] != 1) {
+        lo++;
+      }
+      while (hi > lo && repeats[hi - 1] != 1) {
+        hi--;
+      }
+      for (size_t i = lo; i < hi; i++) {
+        able_to_optimize &= repeats[i] == 1;
+      }
+      int64_t num_elements = 1;
+      for (auto d : x_sizes) {
+        num_elements *= d;
+      }
+      // every consumer must broadcast its second input against a first
+      // input of the tiled shape
+      for (auto use : n->output()->uses()) {
+        auto* u = use.user;
+        if (!able_to_optimize) {
+          break;
+        }
+        able_to_optimize = IsBroadcastElementwise(u->kind()) &&
+          u->inputs().size() == 2 && u->inputs()[0] != u->inputs()[1] &&
+          (use.offset == 1 || is_commutative(u->kind())) &&
+          has_sizes(u->inputs()[1 - use.offset], tiled_sizes);
+      }
+      if (!able_to_optimize) {
+        continue;
+      }
+
+      Value* operand = x;
+      if (num_elements != 1 && hi - lo < rank) {
+        Node* squeeze = graph.create(kSqueeze, 1);
+        std::vector<int64_t> axes;
+        std::vector<Dimension> squeezed_sizes;
+        for (size_t i = 0; i < rank; i++) {
+          if (i < lo || i >= hi) {
+            axes.push_back(static_cast<int64_t>(i));
+          } else {
+            squeezed_sizes.push_back(x->sizes()[i]);
+          }
+        }
+        squeeze->is_(kaxes, std::move(axes));
+        squeeze->addInput(x);
+        squeeze->insertBefore(n);
+        squeeze->output()->setSizes(squeezed_sizes);
+        squeeze->output()->setElemType(x->elemType());
+        operand = squeeze->output();
+      }
+      while (n->output()->uses().size() > 0) {
+        auto use = n->output()->uses()[0];
+        auto* u = use.user;
+        if (use.offset == 0) {
+          u->replaceInput(0, u->inputs()[1]);
+        }
+        u->replaceInput(1, operand);
+        u->i_(kbroadcast, 1);
+        if (num_elements == 1) {
+          if (u->hasAttribute(kaxis)) {
+            u->removeAttribute(kaxis);
+          }
+        } else {
+          u->i_(kaxis, static_cast<int64_t>(lo));
+        }
+      }
+      auto repeats_node = n->inputs()[1]->node();
+      it.destroyCurrent();
+      if (repeats_node->kind() == kConstant && repeats_node->output()->uses().size() == 0) {
+        if (*it == repeats_node) {
+          it.destroyCurrent();
+        } else {
+          repeats_node->destroy();
+        }
+      }
+    }
+  }
+
+  void optimize(Graph& graph) override {
+    eliminate_broadcast_tile(graph);
+  }
+};
+
+}} // namespace ONNX_NAMESPACE::optimization
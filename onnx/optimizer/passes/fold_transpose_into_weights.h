@@ -0,0 +1,64 @@
+// ATTENTION: The code in this file is highly EXPERIMENTAL.
+// Adventurous users should note that the APIs will probably change.
+
+#pragma once
+
+// Before:
+//   Z = Gemm(X, Y, C, transB=1)       or   Z = MatMul(X, Transpose(Y))
+// After:
+//   Z = Gemm(X, Y', C)                     Z = MatMul(X, Y')
+//
+// where Y is a constant (Constant node or initializer) only used by
+// this node, and Y' is Y with its data physically transposed, so that
+// the transposition does not have to be performed at runtime.
+
+#include "onnx/optimizer/passes/constant_util.h"
+#include "onnx/optimizer/passes/optimize_pass.h"
+
+namespace ONNX_NAMESPACE { namespace optimization {
+
+struct FoldTransposeIntoWeights final : public OptimizePass {
+  explicit FoldTransposeIntoWeights()
+    : OptimizePass("fold_transpose_into_weights", API_TYPE::IR) {
+  }
+
+  void fold_transpose_into_weights(Graph& graph) {
+    static const std::vector<int64_t> simple_trans_perm({1,0});
+
+    for (auto it = graph.begin(); it != graph.end(); ++it) {
+      auto* n = *it;
+      DescendOnGraphAttributes(n, [this](Graph& g){fold_transpose_into_weights(g);});
+
+      if (n->kind() != kGemm && n->kind() != kMatMul) {
+        continue;
+      }
+      for (size_t i : {0,1}) {
+        auto inp = n->inputs()[i];
+        if (inp->node()->kind() == kTranspose && inp->uses().size() == 1 &&
+            inp->node()->hasAttribute(kperm)) {
+          auto perm = inp->node()->is(kperm);
+          if (n->kind() == kGemm && perm != simple_trans_perm) {
+            continue;
+          }
+          auto weight = inp->node()->input();
+          if (transposeConstant(weight, perm)) {
+            n->replaceInput(i, weight);
+            inp->node()->destroy();
+          }
+        } else if (n->kind() == kGemm) {
+          auto trans = i == 0 ? ktransA : ktransB;
+          if (n->hasAttribute(trans) && n->i(trans) &&
+              transposeConstant(inp, simple_trans_perm)) {
+            n->removeAttribute(trans);
+          }
+        }
+      }
+    }
+  }
+
+  void optimize(Graph& graph) override {
+    fold_transpose_into_weights(graph);
+  }
+};
+
+}} // namespace ONNX_NAMESPACE::optimization
@@ -0,0 +1,97 @@
+// ATTENTION: The code in this file is highly EXPERIMENTAL.
+// Adventurous users should note that the APIs will probably change.
+
+#pragma once
+
+// Before:
+//   Z = Conv(X, W, B)
+//   Y = LeakyRelu(Z, alpha=0.1)
+// After:
+//   Y = FusedConv(X, W, B, activation="LeakyRelu", activation_alpha=0.1)
+//
+// An activation whose input is the output of a Conv or Gemm, used by no
+// other node, is fused into it, so that backends can apply the activation
+// before the output is written. The parameters of the activation are
+// always set on the fused op, with the default values of the activation
+// when they are not specified.
+
+#include <limits>
+#include <map>
+
+#include "onnx/optimizer/passes/optimize_pass.h"
+
+namespace ONNX_NAMESPACE { namespace optimization {
+
+struct FuseActivationIntoConvAndGemm final : public OptimizePass {
+  explicit FuseActivationIntoConvAndGemm()
+    : OptimizePass("fuse_activation_into_conv_and_gemm", API_TYPE::IR) {
+  }
+
+  // An attribute of an activation mapped to activation_alpha or
+  // activation_beta, and its default value.
+  struct Parameter {
+    const char* name;
+    float default_value;
+  };
+
+  struct Activation {
+    std::vector<Parameter> parameters;
+  };
+
+  static const Activation* find_activation(NodeKind kind) {
+    static const std::map<NodeKind, Activation> activations = {
+      {Symbol("Relu"), {{}}},
+      {kSigmoid, {{}}},
+      {kTanh, {{}}},
+      {Symbol("Softsign"), {{}}},
+      {Symbol("Softplus"), {{}}},
+      {Symbol("LeakyRelu"), {{{"alpha", 0.01f}}}},
+      {Symbol("Elu"), {{{"alpha", 1.0f}}}},
+      {Symbol("ThresholdedRelu"), {{{"alpha", 1.0f}}}},
+      {Symbol("HardSigmoid"), {{{"alpha", 0.2f}, {"beta", 0.5f}}}},
+      {Symbol("Affine"), {{{"alpha", 1.0f}, {"beta", 0.0f}}}},
+      {Symbol("Clip"), {{{"min", std::numeric_limits<float>::lowest()},
+                         {"max", std::numeric_limits<float>::max()}}}}};
+    auto it = activations.find(kind);
+    return it == activations.end() ? nullptr : &it->second;
+  }
+
+  void fuse_activation_into_conv_and_gemm(Graph& graph) {
+    for (auto it = graph.begin(); it != graph.end(); ++it) {
+      auto* n = *it;
+      DescendOnGraphAttributes(n, [this](Graph& g){fuse_activation_into_conv_and_gemm(g);});
+      const Activation* activation = find_activation(n->kind());
+      if (activation == nullptr || n->inputs().size() != 1 || !n->domain().empty()) {
+        continue;
+      }
+      auto z = n->input();
+      auto* orig = z->node();
+      if ((orig->kind() != kConv && orig->kind() != kGemm) || !orig->domain().empty() ||
+          orig->outputs().size() != 1 || z->uses().size() != 1 || IsGraphOutput(z)) {
+        continue;
+      }
+      Node* fused = graph.create(
+          Symbol(orig->kind() == kConv ? "FusedConv" : "FusedGemm"), orig->inputs(), 1);
+      fused->copyAttributes(*orig);
+      fused->s_(Symbol("activation"), n->kind().toString());
+      static const char* fused_names[] = {"activation_alpha", "activation_beta"};
+      for (size_t i = 0; i < activation->parameters.size(); i++) {
+        const auto& p = activation->parameters[i];
+        Symbol name(p.name);
+        fused->f_(Symbol(fused_names[i]),
+                  n->hasAttribute(name) ? static_cast<float>(n->f(name)) : p.default_value);
+      }
+      fused->insertBefore(n);
+      fused->output()->copyMetadata(n->output());
+      n->output()->replaceAllUsesWith(fused->output());
+      it.destroyCurrent();
+      orig->destroy();
+    }
+  }
+
+  void optimize(Graph& graph) override {
+    fuse_activation_into_conv_and_gemm(graph);
+  }
+};
+
+}} // namespace ONNX_NAMESPACE::optimization
@@ -0,0 +1,166 @@
+// ATTENTION: The code in this file is highly EXPERIMENTAL.
+// Adventurous users should note that the APIs will probably change.
+
+#pragma once
+
+// Before:
+//   Y = Reshape(Unsqueeze(Flatten(X)), shape)
+// After:
+//   Y = Reshape(X, shape')
+//
+// A chain of shape-only ops (Reshape, Flatten, Squeeze, Unsqueeze), where
+// every intermediate result is only used by the next op of the chain, is
+// collapsed into a single Reshape. The target shape is taken from the
+// static sizes of Y, or from the shape input of the last op when it is a
+// Reshape whose shape is computed by a Shape op (or is a constant that
+// does not refer to the dimensions of its input). When Y is known to have
+// the same static shape as X, the chain is removed altogether. Models of
+// operator sets older than 5 get a Reshape with a shape attribute.
+
+#include "onnx/optimizer/passes/constant_util.h"
+#include "onnx/optimizer/passes/optimize_pass.h"
+
+namespace ONNX_NAMESPACE { namespace optimization {
+
+struct FuseConsecutiveReshapes final : public OptimizePass {
+  explicit FuseConsecutiveReshapes()
+    : OptimizePass("fuse_consecutive_reshapes", API_TYPE::IR) {
+  }
+
+  static bool is_shape_op(Node* n) {
+    return n->kind() == kReshape || n->kind() == kFlatten ||
+      n->kind() == kSqueeze || n->kind() == kUnsqueeze;
+  }
+
+  static bool static_sizes(const std::vector<Dimension>& sizes, std::vector<int64_t>* shape) {
+    for (const auto& d : sizes) {
+      if (!d.is_int) {
+        return false;
+      }
+      shape->push_back(d.dim);
+    }
+    return !sizes.empty();
+  }
+
+  // Returns the shape input of the Reshape n if it does not depend on the
+  // shape of the data input, and nullptr otherwise.
+  static Value* reusable_shape_input(Node* n) {
+    if (n->kind() != kReshape || n->inputs().size() != 2) {
+      return nullptr;
+    }
+    auto shape = n->inputs()[1];
+    if (shape->node()->kind() == kShape) {
+      return shape;
+    }
+    const Tensor* t = getConstantTensor(shape);
+    if (t == nullptr || !t->raw().empty() || t->elem_type() != TensorProto_DataType_INT64) {
+      return nullptr;
+    }
+    for (auto d : t->int64s()) {
+      // 0 copies the corresponding dimension of the data input
+      if (d == 0) {
+        return nullptr;
+      }
+    }
+    return shape;
+  }
+
+  // Returns true if graph imports a version of the ONNX operator set older
+  // than 5, whose Reshape takes the shape as an attribute.
+  static bool imports_legacy_reshape(const Graph& graph) {
+    for (const auto& opset : graph.opset_versions()) {
+      if (opset.domain() == "" || opset.domain() == "ai.onnx") {
+        return opset.version() < 5;
+      }
+    }
+    return false;
+  }
+
+  void fuse_consecutive_reshapes(Graph& graph, bool legacy_opset) {
+    for (auto it = graph.begin(); it != graph.end(); ++it) {
+      auto* n = *it;
+      DescendOnGraphAttributes(n, [this, legacy_opset](Graph& g) {
+        fuse_consecutive_reshapes(g, legacy_opset);
+      });
+      if (!is_shape_op(n)) {
+        continue;
+      }
+      // chain[0] is n, followed by its predecessors in the chain
+      std::vector<Node*> chain = {n};
+      bool legacy_reshape = legacy_opset ||
+        (n->kind() == kReshape && n->hasAttribute(kshape));
+      while (is_shape_op(chain.back()->inputs()[0]->node()) &&
+             chain.back()->inputs()[0]->uses().size() == 1) {
+        chain.push_back(chain.back()->inputs()[0]->node());
+        legacy_reshape |= chain.back()->kind() == kReshape && chain.back()->hasAttribute(kshape);
+      }
+      auto x = chain.back()->inputs()[0];
+      auto y = n->output();
+
+      // The chain can only be removed when x and y are known to have the
+      // same shape. Graph outputs keep their name, so it also has to be an
+      // intermediate value that can be renamed.
+      std::vector<int64_t> x_shape, y_shape;
+      bool removable = static_sizes(x->sizes(), &x_shape) &&
+        static_sizes(y->sizes(), &y_shape) && x_shape == y_shape &&
+        (!IsGraphOutput(y) || (x->node()->kind() != kParam &&
+                               x->node()->kind() != kCaptured && !IsGraphOutput(x)));
+      if (removable) {
+        if (IsGraphOutput(y)) {
+          x->copyMetadata(y);
+        }
+        y->replaceAllUsesWith(x);
+      } else {
+        if (chain.size() == 1) {
+          continue;
+        }
+        std::vector<int64_t> shape;
+        Value* shape_input = nullptr;
+        if (!static_sizes(y->sizes(), &shape)) {
+          shape_input = legacy_reshape ? nullptr : reusable_shape_input(n);
+          if (shape_input == nullptr) {
+            continue;
+          }
+        }
+        Node* reshape = graph.create(kReshape, 1);
+        reshape->addInput(x);
+        if (shape_input != nullptr) {
+          reshape->addInput(shape_input);
+        } else if (legacy_reshape) {
+          reshape->is_(kshape, std::move(shape));
+        } else {
+          Node* constant = graph.create(kConstant, 1);
+          Tensor t;
+          t.sizes().push_back(static_cast<int64_t>(shape.size()));
+          t.int64s() = shape;
+          t.elem_type() = TensorProto_DataType_INT64;
+          constant->t_(kvalue, t);
+          std::vector<Dimension> s = {static_cast<int>(shape.size())};
+          constant->output()->setSizes(s);
+          constant->output()->setElemType(TensorProto_DataType_INT64);
+          constant->insertBefore(n);
+          reshape->addInput(constant->output());
+        }
+        reshape->insertBefore(n);
+        reshape->output()->copyMetadata(y);
+        y->replaceAllUsesWith(reshape->output());
+      }
+      // Destroy the chain from its end. Nodes of the chain that the
+      // iterator ends up pointing to have to be destroyed through it.
+      it.destroyCurrent();
+      for (size_t i = 1; i < chain.size(); i++) {
+        if (*it == chain[i]) {
+          it.destroyCurrent();
+        } else {
+          chain[i]->destroy();
+        }
+      }
+    }
+  }
+
+  void optimize(Graph& graph) override {
+    fuse_consecutive_reshapes(graph, imports_legacy_reshape(graph));
+  }
+};
+
+}} // namespace ONNX_NAMESPACE::optimization
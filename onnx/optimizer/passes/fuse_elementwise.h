@@ -0,0 +1,220 @@
+// ATTENTION: The code in this file is highly EXPERIMENTAL.
+// Adventurous users should note that the APIs will probably change.
+
+#pragma once
+
+// Before:
+//   A = Add(X, B, broadcast=1)
+//   C = Relu(A)
+//   Y = Mul(C, S, broadcast=1)
+// After:
+//   Y = FusedElementwise(X, B, S, body=graph(X, B, S) {
+//     A = Add(X, B, broadcast=1)
+//     C = Relu(A)
+//     Y = Mul(C, S, broadcast=1)
+//     return Y
+//   })
+//
+// Connected regions of elementwise nodes computing values of the same shape
+// are replaced by a single FusedElementwise node, so that backends can
+// compute the region in one pass over its inputs. A node joins the region of
+// one of its inputs when:
+//   - the shape of its output, i.e. of its first input, is known to be the
+//     shape of the region; the other inputs may be broadcast to it;
+//   - its inputs from outside of the region are computed before the region;
+//   - no value of the region is used outside of it before the node.
+// The fused node is placed at the last node of the region. Its outputs are
+// the values of the region used outside of it, which keep their names, and
+// its inputs are the values used by the region computed outside of it.
+// Values captured by nested graphs are not fused, since their definition
+// must not move.
+
+#include <memory>
+#include <unordered_map>
+
+#include "onnx/optimizer/passes/optimize_pass.h"
+
+namespace ONNX_NAMESPACE { namespace optimization {
+
+struct FuseElementwise final : public OptimizePass {
+  explicit FuseElementwise()
+    : OptimizePass("fuse_elementwise", API_TYPE::IR) {
+  }
+
+  struct Region {
+    std::vector<Node*> nodes;
+    size_t first;
+    std::vector<Dimension> sizes;
+  };
+
+  static bool is_fusable(Node* n) {
+    static const std::set<NodeKind> unary_kinds = {
+      Symbol("Abs"), Symbol("Ceil"), Symbol("Clip"), Symbol("Elu"), Symbol("Exp"),
+      Symbol("Floor"), Symbol("HardSigmoid"), Symbol("LeakyRelu"), Symbol("Log"),
+      kNeg, Symbol("Reciprocal"), Symbol("Relu"), Symbol("Selu"), kSigmoid,
+      Symbol("Softplus"), Symbol("Softsign"), Symbol("Sqrt"), kTanh};
+    static const std::set<NodeKind> binary_kinds = {kAdd, kSub, kMul, kDiv, kPow};
+    if (!n->domain().empty() || n->outputs().size() != 1) {
+      return false;
+    }
+    return (unary_kinds.count(n->kind()) > 0 && n->inputs().size() == 1) ||
+      (binary_kinds.count(n->kind()) > 0 && n->inputs().size() == 2);
+  }
+
+  static bool same_sizes(const std::vector<Dimension>& a, const std::vector<Dimension>& b) {
+    if (a.empty() || a.size() != b.size()) {
+      return false;
+    }
+    for (size_t i = 0; i < a.size(); i++) {
+      if (a[i].is_int != b[i].is_int) {
+        return false;
+      }
+      if (a[i].is_int ? a[i].dim != b[i].dim : (a[i].param.empty() || a[i].param != b[i].param)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  static void copy_type(Value* to, const Value* from) {
+    to->setElemType(from->elemType());
+    to->setSizes(from->sizes());
+    to->setUniqueName(from->uniqueName());
+  }
+
+  struct Fusion {
+    std::unordered_map<Node*, size_t> index;
+    std::unordered_map<Node*, Region*> region_of;
+    std::vector<std::unique_ptr<Region>> regions;
+
+    // Index of the producer of v, 0 for the inputs of the graph.
+    size_t producer_index(Value* v) const {
+      auto it = index.find(v->node());
+      return it == index.end() ? 0 : it->second;
+    }
+
+    bool in_region(Node* n, const Region* r) const {
+      auto it = region_of.find(n);
+      return it != region_of.end() && it->second == r;
+    }
+
+    bool can_join(Region* r, Node* n) const {
+      if (!in_region(n->inputs()[0]->node(), r) && !same_sizes(n->inputs()[0]->sizes(), r->sizes)) {
+        return false;
+      }
+      for (auto* input : n->inputs()) {
+        if (!in_region(input->node(), r) && producer_index(input) >= r->first) {
+          return false;
+        }
+      }
+      size_t n_index = index.at(n);
+      for (auto* m : r->nodes) {
+        for (auto use : m->output()->uses()) {
+          if (use.user == n || in_region(use.user, r)) {
+            continue;
+          }
+          auto it = index.find(use.user);
+          if (it != index.end() && it->second < n_index) {
+            return false;
+          }
+        }
+      }
+      return true;
+    }
+  };
+
+  static void fuse_region(Graph& graph, const Region& r) {
+    std::shared_ptr<Graph> body(new Graph());
+    body->setName("fused_elementwise");
+    std::unordered_map<Value*, Value*> env;
+    std::vector<Value*> inputs;
+    std::vector<Value*> outputs;
+    std::set<Node*> members(r.nodes.begin(), r.nodes.end());
+    for (auto* m : r.nodes) {
+      // the output has the type of the first input
+      auto* y = m->output();
+      if (y->elemType() == TensorProto_DataType_UNDEFINED && y->sizes().empty()) {
+        y->setElemType(m->inputs()[0]->elemType());
+        y->setSizes(m->inputs()[0]->sizes());
+      }
+      std::vector<Value*> body_inputs;
+      for (auto* input : m->inputs()) {
+        if (env.count(input) == 0) {
+          Value* v = body->addInput();
+          copy_type(v, input);
+          env[input] = v;
+          inputs.push_back(input);
+        }
+        body_inputs.push_back(env[input]);
+      }
+      Node* body_node = body->create(m->kind(), body_inputs, 1);
+      body_node->copyAttributes(*m);
+      body->appendNode(body_node);
+      copy_type(body_node->output(), m->output());
+      env[m->output()] = body_node->output();
+      for (auto use : m->output()->uses()) {
+        if (members.count(use.user) == 0) {
+          outputs.push_back(m->output());
+          body->registerOutput(body_node->output());
+          break;
+        }
+      }
+    }
+    Node* fused = graph.create(Symbol("FusedElementwise"), inputs, outputs.size());
+    fused->g_(Symbol("body"), body);
+    fused->insertBefore(r.nodes.back());
+    for (size_t i = 0; i < outputs.size(); i++) {
+      fused->outputs()[i]->copyMetadata(outputs[i]);
+      outputs[i]->replaceAllUsesWith(fused->outputs()[i]);
+    }
+    for (auto it = r.nodes.rbegin(); it != r.nodes.rend(); ++it) {
+      (*it)->destroy();
+    }
+  }
+
+  void fuse_elementwise(Graph& graph) {
+    for (auto* n : graph.nodes()) {
+      // the bodies of fused nodes are already fused
+      if (n->kind() != Symbol("FusedElementwise")) {
+        DescendOnGraphAttributes(n, [this](Graph& g){fuse_elementwise(g);});
+      }
+    }
+    std::set<std::string> captured;
+    CollectCapturedNames(graph, &captured);
+    Fusion fusion;
+    size_t i = 1;
+    for (auto* n : graph.nodes()) {
+      fusion.index[n] = i++;
+    }
+    for (auto* n : graph.nodes()) {
+      if (!is_fusable(n) || captured.count(n->output()->uniqueName()) > 0) {
+        continue;
+      }
+      Region* region = nullptr;
+      for (auto* input : n->inputs()) {
+        auto it = fusion.region_of.find(input->node());
+        if (it != fusion.region_of.end() && fusion.can_join(it->second, n)) {
+          region = it->second;
+          break;
+        }
+      }
+      if (region == nullptr) {
+        fusion.regions.emplace_back(new Region{{}, fusion.index[n], n->inputs()[0]->sizes()});
+        region = fusion.regions.back().get();
+      }
+      region->nodes.push_back(n);
+      fusion.region_of[n] = region;
+    }
+    for (const auto& r : fusion.regions) {
+      if (r->nodes.size() > 1) {
+        fuse_region(graph, *r);
+      }
+    }
+  }
+
+  void optimize(Graph& graph) override {
+    fuse_elementwise(graph);
+  }
+};
+
+}} // namespace ONNX_NAMESPACE::optimization
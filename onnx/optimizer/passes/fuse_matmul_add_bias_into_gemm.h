@@ -0,0 +1,88 @@
+// ATTENTION: The code in this file is highly EXPERIMENTAL.
+// Adventurous users should note that the APIs will probably change.
+
+#pragma once
+
+// Before:
+//   Z = MatMul(X, Y)
+//   B = Z + A
+// After:
+//   B = Gemm(X, Y, A)
+//
+// the pass can handle the following cases:
+//   case 1: X and Y are 2D tensors and A has the same shape as Z
+//   case 2: A is broadcast (broadcast=1) and is a 1D tensor with
+//           A.dim[0] == Z.dim[1] or A.dim[0] == 1
+
+#include "onnx/optimizer/passes/optimize_pass.h"
+
+namespace ONNX_NAMESPACE { namespace optimization {
+
+struct FuseMatMulAddBiasIntoGemm final : public OptimizePass {
+  explicit FuseMatMulAddBiasIntoGemm()
+    : OptimizePass("fuse_matmul_add_bias_into_gemm", API_TYPE::IR) {
+  }
+
+  static bool same_dim(const Dimension& a, const Dimension& b) {
+    if (a.is_int != b.is_int) {
+      return false;
+    }
+    return a.is_int ? a.dim == b.dim : !a.param.empty() && a.param == b.param;
+  }
+
+  void fuse_matmul_add_bias_into_gemm(Graph& graph) {
+    for (auto it = graph.begin(); it != graph.end(); ++it) {
+      auto* n = *it;
+      DescendOnGraphAttributes(n, [this](Graph& g){fuse_matmul_add_bias_into_gemm(g);});
+      if (n->kind() != kAdd || n->inputs()[0]->node()->kind() != kMatMul) {
+        continue;
+      }
+      // due to current broadcasting's constraint, MatMul has to be the first oprand
+      auto orig_matmul = n->inputs()[0];
+      auto orig_bias = n->inputs()[1];
+      // check if MatMul is only used by Add
+      if (orig_matmul->uses().size() > 1) {
+        continue;
+      }
+      auto a_shape = orig_matmul->node()->inputs()[0]->sizes();
+      auto b_shape = orig_matmul->node()->inputs()[1]->sizes();
+      auto bias_shape = orig_bias->sizes();
+      // Gemm only handles the 2D case of MatMul
+      if (a_shape.size() != 2 || b_shape.size() != 2 || !b_shape[1].is_int) {
+        continue;
+      }
+      int64_t N = b_shape[1].dim;
+      bool broadcast = n->hasAttribute(kbroadcast) && n->i(kbroadcast) == 1;
+      bool able_to_optimize = false;
+      if (bias_shape.size() == 2) {
+        able_to_optimize = same_dim(bias_shape[0], a_shape[0]) &&
+          same_dim(bias_shape[1], b_shape[1]) &&
+          (!broadcast || !n->hasAttribute(kaxis) || n->i(kaxis) == 0);
+      } else if (bias_shape.size() == 1 && broadcast && bias_shape[0].is_int) {
+        able_to_optimize = bias_shape[0].dim == 1 ||
+          (bias_shape[0].dim == N && (!n->hasAttribute(kaxis) || n->i(kaxis) == 1));
+      }
+      if (!able_to_optimize) {
+        continue;
+      }
+      Node* gemm = graph.create(kGemm, 1);
+      gemm->addInput(orig_matmul->node()->inputs()[0]);
+      gemm->addInput(orig_matmul->node()->inputs()[1]);
+      gemm->addInput(orig_bias);
+      if (bias_shape.size() == 1) {
+        gemm->i_(kbroadcast, 1);
+      }
+      gemm->insertBefore(n);
+      gemm->output()->copyMetadata(n->output());
+      n->output()->replaceAllUsesWith(gemm->output());
+      it.destroyCurrent();
+      orig_matmul->node()->destroy();
+    }
+  }
+
+  void optimize(Graph& graph) override {
+    fuse_matmul_add_bias_into_gemm(graph);
+  }
+};
+
+}} // namespace ONNX_NAMESPACE::optimization
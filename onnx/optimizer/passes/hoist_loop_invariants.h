@@ -0,0 +1,153 @@
+// ATTENTION: The code in this file is highly EXPERIMENTAL.
+// Adventurous users should note that the APIs will probably change.
+
+#pragma once
+
+// Before:
+//   Y = Loop(M, cond, X, body=graph(i, c, x) {
+//     W2 = Mul(W, W)
+//     y = Add(x, W2)
+//     return c, y
+//   })
+// After:
+//   W2 = Mul(W, W)
+//   Y = Loop(M, cond, X, body=graph(i, c, x) {
+//     y = Add(x, W2)
+//     return c, y
+//   })
+//
+// Nodes of a Loop body whose inputs are all defined outside of the body, or
+// computed by other such nodes, compute the same values on every iteration.
+// They are moved before the Loop, and the body refers to their outputs as
+// captured values. Nested loops are processed first, so that invariants
+// of an inner loop can be moved out of the outer loop as well.
+//
+// Only deterministic nodes of the default domain without graph attributes
+// are moved, and not the ones computing outputs of the body. Moved nodes are
+// computed even if the loop runs no iteration. Moved values keep their
+// names, unless the name is also used in another graph of the model.
+
+#include <unordered_map>
+
+#include "onnx/optimizer/passes/scope_util.h"
+
+namespace ONNX_NAMESPACE { namespace optimization {
+
+struct HoistLoopInvariants final : public OptimizePass {
+  explicit HoistLoopInvariants()
+    : OptimizePass("hoist_loop_invariants", API_TYPE::IR) {
+  }
+
+  static bool is_hoistable(Node* n) {
+    static const std::set<NodeKind> random_kinds = {
+      Symbol("RandomNormal"), Symbol("RandomNormalLike"), Symbol("RandomUniform"),
+      Symbol("RandomUniformLike"), Symbol("Multinomial")};
+    if (n->kind() == kCaptured || n->kind() == kUndefined || !n->domain().empty() ||
+        random_kinds.count(n->kind()) > 0) {
+      return false;
+    }
+    for (auto name : n->attributeNames()) {
+      auto kind = n->kindOf(name);
+      if (kind == AttributeKind::g || kind == AttributeKind::gs) {
+        return false;
+      }
+    }
+    for (auto* v : n->outputs()) {
+      if (IsGraphOutput(v)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // Moves the invariant nodes of the body of loop before it.
+  void hoist(Scope& scope, ValueNames& names, Node* loop) {
+    Graph& body = *loop->g(kbody);
+    std::set<std::string> captured;
+    CollectCapturedNames(body, &captured);
+    // values of the body defined outside of it, by their outer value
+    std::unordered_map<Value*, Value*> outer;
+    for (auto* n : body.nodes()) {
+      if (n->kind() == kCaptured) {
+        outer[n->output()] = nullptr;
+      }
+    }
+    for (auto it = body.begin(); it != body.end(); ++it) {
+      auto* n = *it;
+      if (!is_hoistable(n)) {
+        continue;
+      }
+      bool invariant = true;
+      for (auto* v : n->inputs()) {
+        invariant = invariant && (v->node()->kind() == kUndefined || outer.count(v) > 0);
+      }
+      for (auto* v : n->outputs()) {
+        invariant = invariant &&
+          (names.unique(v->uniqueName()) || captured.count(v->uniqueName()) == 0);
+      }
+      if (!invariant) {
+        continue;
+      }
+      std::vector<Value*> inputs;
+      for (auto* v : n->inputs()) {
+        if (v->node()->kind() == kUndefined) {
+          Node* undef = scope.graph.create(kUndefined, 1);
+          undef->insertBefore(loop);
+          inputs.push_back(undef->output());
+          continue;
+        }
+        if (outer[v] == nullptr) {
+          outer[v] = scope.find(v->uniqueName());
+        }
+        if (outer[v] == nullptr) {
+          invariant = false;
+          break;
+        }
+        inputs.push_back(outer[v]);
+      }
+      if (!invariant) {
+        continue;
+      }
+      Node* hoisted = scope.graph.create(n->kind(), inputs, n->outputs().size());
+      hoisted->copyAttributes(*n);
+      if (n->has_name()) {
+        hoisted->setName(n->name());
+      }
+      hoisted->insertBefore(loop);
+      for (size_t i = 0; i < n->outputs().size(); i++) {
+        auto* v = n->outputs()[i];
+        auto* y = hoisted->outputs()[i];
+        y->copyMetadata(v);
+        if (!names.unique(v->uniqueName())) {
+          y->setUniqueName(names.fresh(v->uniqueName()));
+        }
+        scope.values[y->uniqueName()] = y;
+        Node* capture = body.create(kCaptured, 1);
+        body.appendNode(capture);
+        capture->output()->setUniqueName(y->uniqueName());
+        v->replaceAllUsesWith(capture->output());
+        outer[capture->output()] = y;
+      }
+      it.destroyCurrent();
+    }
+  }
+
+  void hoist_loop_invariants(Graph& graph, ValueNames& names, bool nested) {
+    Scope scope(graph, nested);
+    for (auto* n : graph.nodes()) {
+      // fresh names depend on the order the graphs are visited in
+      DescendOnGraphAttributesSerially(n, [this, &names](Graph& g){hoist_loop_invariants(g, names, true);});
+      if (n->kind() == kLoop) {
+        hoist(scope, names, n);
+      }
+    }
+  }
+
+  void optimize(Graph& graph) override {
+    ValueNames names;
+    names.add(graph);
+    hoist_loop_invariants(graph, names, false);
+  }
+};
+
+}} // namespace ONNX_NAMESPACE::optimization
@@ -0,0 +1,83 @@
+// ATTENTION: The code in this file is highly EXPERIMENTAL.
+// Adventurous users should note that the APIs will probably change.
+
+#pragma once
+
+// Canonicalizes a graph exported from training for inference:
+//   - Dropout is a plain copy of its input in test mode, so it is bypassed
+//     when its mask output is unused;
+//   - BatchNormalization is switched to test mode (is_test=1), which only
+//     produces Y, when its running and saved statistics are unused;
+//   - Identity nodes are bypassed, in nested graphs as well.
+// Graph outputs keep their names, so a node is kept (in test mode) when
+// its output is a graph output and its input cannot be renamed.
+
+#include "onnx/optimizer/passes/optimize_pass.h"
+
+namespace ONNX_NAMESPACE { namespace optimization {
+
+struct InferenceMode final : public OptimizePass {
+  explicit InferenceMode()
+    : OptimizePass("inference_mode", API_TYPE::IR) {
+  }
+
+  // Replaces all uses of `from` by `to`, returning false if this is not
+  // possible without renaming a graph output.
+  static bool bypass(Value* from, Value* to) {
+    if (IsGraphOutput(from)) {
+      auto kind = to->node()->kind();
+      if (kind == kParam || kind == kCaptured || kind == kUndefined || IsGraphOutput(to)) {
+        return false;
+      }
+      to->copyMetadata(from);
+    }
+    from->replaceAllUsesWith(to);
+    return true;
+  }
+
+  // Erases the outputs of n from index `first` on, if none of them is used.
+  static bool erase_trailing_outputs(Node* n, size_t first) {
+    for (size_t i = first; i < n->outputs().size(); i++) {
+      if (n->outputs()[i]->uses().size() > 0) {
+        return false;
+      }
+    }
+    while (n->outputs().size() > first) {
+      n->eraseOutput(n->outputs().size() - 1);
+    }
+    return true;
+  }
+
+  void inference_mode(Graph& graph) {
+    for (auto it = graph.begin(); it != graph.end(); ++it) {
+      auto* n = *it;
+      DescendOnGraphAttributes(n, [this](Graph& g){inference_mode(g);});
+      if (n->kind() == kIdentity) {
+        if (bypass(n->output(), n->input())) {
+          it.destroyCurrent();
+        }
+      } else if (n->kind() == kDropout) {
+        // the mask is not filled in test mode
+        if (!erase_trailing_outputs(n, 1)) {
+          continue;
+        }
+        if (bypass(n->output(), n->input())) {
+          it.destroyCurrent();
+        } else {
+          n->i_(kis_test, 1);
+        }
+      } else if (n->kind() == kBatchNormalization) {
+        // test mode only produces Y
+        if (erase_trailing_outputs(n, 1)) {
+          n->i_(kis_test, 1);
+        }
+      }
+    }
+  }
+
+  void optimize(Graph& graph) override {
+    inference_mode(graph);
+  }
+};
+
+}} // namespace ONNX_NAMESPACE::optimization
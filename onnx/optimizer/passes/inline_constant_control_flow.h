@@ -0,0 +1,358 @@
+// ATTENTION: The code in this file is highly EXPERIMENTAL.
+// Adventurous users should note that the APIs will probably change.
+
+#pragma once
+
+// Before:
+//   c = Constant(value=true)
+//   Y = If(c, then_branch=graph() { T = Relu(X); return T },
+//             else_branch=graph() { E = Neg(X); return E })
+// After:
+//   c = Constant(value=true)
+//   Y = Relu(X)
+//
+// Before:
+//   M = Constant(value=2)
+//   Y, S = Loop(M, , X, body=graph(i, c, x) {
+//     y = Add(x, W)
+//     return c, y, y
+//   })
+// After:
+//   M = Constant(value=2)
+//   y_1 = Add(X, W)
+//   Y = Add(y_1, W)
+//   s_1 = Unsqueeze(y_1, axes=[0])
+//   s_2 = Unsqueeze(Y, axes=[0])
+//   S = Concat(s_1, s_2, axis=0)
+//
+// An If whose condition is a constant is replaced by the nodes of the taken
+// branch. A Loop whose trip count is a constant of at most max_trip_count,
+// and which cannot stop early, is replaced by a copy of the nodes of its
+// body for each iteration; loops whose body has nested graphs are kept.
+// The loop cannot stop early if its condition is empty or constant true,
+// and the condition computed by the body is its condition input or
+// constant true. Scan outputs are concatenated along a new first axis,
+// which Unsqueeze and Concat only do for floating point tensors, so loops
+// with other scan outputs are kept.
+//
+// The outputs of the If or Loop keep their names. Copied values keep their
+// names if they are not used anywhere else in the model, and get new names
+// otherwise.
+
+#include <unordered_map>
+
+#include "onnx/optimizer/passes/constant_util.h"
+#include "onnx/optimizer/passes/scope_util.h"
+
+namespace ONNX_NAMESPACE { namespace optimization {
+
+struct InlineConstantControlFlow final : public OptimizePass {
+  explicit InlineConstantControlFlow(int64_t max_trip_count = 8)
+    : OptimizePass("inline_constant_control_flow", API_TYPE::IR),
+      max_trip_count(max_trip_count) {
+  }
+
+  int64_t max_trip_count;
+
+  // Reads the value of a scalar bool constant into *value.
+  static bool getConstantBool(Value* v, bool* value) {
+    const Tensor* t = getConstantTensor(v);
+    if (t == nullptr || t->elem_type() != TensorProto_DataType_BOOL ||
+        t->is_segment() || numElements(*t) != 1) {
+      return false;
+    }
+    if (!t->raw().empty()) {
+      *value = t->raw()[0] != 0;
+    } else if (!t->int32s().empty()) {
+      *value = t->int32s()[0] != 0;
+    } else {
+      return false;
+    }
+    return true;
+  }
+
+  static bool has_graph_attributes(Graph& graph) {
+    for (auto* n : graph.nodes()) {
+      for (auto name : n->attributeNames()) {
+        auto kind = n->kindOf(name);
+        if (kind == AttributeKind::g || kind == AttributeKind::gs) {
+          return true;
+        }
+      }
+    }
+    return false;
+  }
+
+  // Copies nodes of nested graphs before the node `before` of the graph of
+  // scope.
+  struct Rewrite {
+    Scope& scope;
+    ValueNames& names;
+    Node* before;
+    // values of the nested graph copied last, by their copy
+    std::unordered_map<Value*, Value*> env;
+    // names of the copied values in their nested graph
+    std::unordered_map<Value*, std::string> original_names;
+    std::set<Value*> bound;
+    std::vector<Node*> copies;
+    Value* undefined = nullptr;
+
+    Rewrite(Scope& scope, ValueNames& names, Node* before)
+      : scope(scope), names(names), before(before) {
+    }
+
+    Value* lookup(Value* v) {
+      auto it = env.find(v);
+      if (it != env.end()) {
+        return it->second;
+      }
+      if (v->node()->kind() == kUndefined) {
+        if (undefined == nullptr) {
+          Node* undef = scope.graph.create(kUndefined, 1);
+          undef->insertBefore(before);
+          undefined = undef->output();
+        }
+        return undefined;
+      }
+      Value* outer = scope.find(v->uniqueName());
+      ONNX_ASSERT(outer != nullptr);
+      return outer;
+    }
+
+    // Copies the nodes of graph. Copied values get new names if
+    // rename_all is true or if their names are used elsewhere.
+    void copy(Graph& graph, bool rename_all) {
+      for (auto* n : graph.nodes()) {
+        if (n->kind() == kCaptured || n->kind() == kUndefined) {
+          continue;
+        }
+        std::vector<Value*> inputs;
+        for (auto* v : n->inputs()) {
+          inputs.push_back(lookup(v));
+        }
+        Node* c = scope.graph.create(n->kind(), inputs, n->outputs().size());
+        c->copyAttributes(*n);
+        if (n->has_name()) {
+          c->setName(n->name());
+        }
+        if (!n->domain().empty()) {
+          c->setDomain(n->domain());
+        }
+        c->insertBefore(before);
+        copies.push_back(c);
+        for (size_t i = 0; i < n->outputs().size(); i++) {
+          auto* v = n->outputs()[i];
+          auto* y = c->outputs()[i];
+          y->copyMetadata(v);
+          if (rename_all || !names.unique(v->uniqueName())) {
+            y->setUniqueName(names.fresh(v->uniqueName()));
+          }
+          original_names[y] = v->uniqueName();
+          env[v] = y;
+          scope.values[y->uniqueName()] = y;
+        }
+      }
+    }
+
+    Value* constant(Tensor t) {
+      Node* c = scope.graph.create(kConstant, 1);
+      std::vector<Dimension> sizes;
+      for (auto d : t.sizes()) {
+        sizes.push_back(Dimension(static_cast<int>(d)));
+      }
+      c->output()->setSizes(sizes);
+      c->output()->setElemType(t.elem_type());
+      c->t_(kvalue, std::move(t));
+      c->insertBefore(before);
+      return c->output();
+    }
+
+    // Replaces the output `out` of the rewritten node by v. v takes the
+    // name of out if it is a copied value not bound to another output.
+    void bind(Value* out, Value* v) {
+      if (original_names.count(v) > 0 && bound.count(v) == 0) {
+        if (v->elemType() == TensorProto_DataType_UNDEFINED) {
+          v->setElemType(out->elemType());
+          v->setSizes(out->sizes());
+        }
+        v->setUniqueName(out->uniqueName());
+        bound.insert(v);
+      } else {
+        Node* identity = scope.graph.create(kIdentity, 1);
+        identity->addInput(v);
+        identity->insertBefore(before);
+        identity->output()->copyMetadata(out);
+        v = identity->output();
+      }
+      out->replaceAllUsesWith(v);
+      scope.values[v->uniqueName()] = v;
+    }
+
+    // Updates the names captured by the nested graphs of the copies.
+    void rename_captured() {
+      std::unordered_map<std::string, std::string> renames;
+      for (const auto& p : original_names) {
+        if (p.first->uniqueName() != p.second) {
+          renames[p.second] = p.first->uniqueName();
+        }
+      }
+      if (renames.empty()) {
+        return;
+      }
+      for (auto* c : copies) {
+        for (auto name : c->attributeNames()) {
+          if (c->kindOf(name) == AttributeKind::g) {
+            RenameCaptured(*c->g(name), renames);
+          } else if (c->kindOf(name) == AttributeKind::gs) {
+            for (auto& g : c->gs(name)) {
+              RenameCaptured(*g, renames);
+            }
+          }
+        }
+      }
+    }
+  };
+
+  bool inline_if(Scope& scope, ValueNames& names, Node* n) {
+    bool cond;
+    if (!getConstantBool(n->input(), &cond)) {
+      return false;
+    }
+    Graph& branch = *n->g(cond ? kthen_branch : kelse_branch);
+    if (branch.outputs().size() != n->outputs().size()) {
+      return false;
+    }
+    Rewrite rewrite(scope, names, n);
+    rewrite.copy(branch, false);
+    for (size_t i = 0; i < n->outputs().size(); i++) {
+      rewrite.bind(n->outputs()[i], rewrite.lookup(branch.outputs()[i]));
+    }
+    rewrite.rename_captured();
+    return true;
+  }
+
+  static bool used_in_body(Value* v) {
+    for (auto use : v->uses()) {
+      if (use.user->kind() != kReturn) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  bool unroll_loop(Scope& scope, ValueNames& names, Node* n) {
+    Graph& body = *n->g(kbody);
+    std::vector<int64_t> trip_count;
+    if (n->inputs().size() < 2 || n->inputs()[0]->node()->kind() == kUndefined ||
+        !getConstantInt64s(n->inputs()[0], &trip_count) || trip_count.size() != 1 ||
+        trip_count[0] < 1 || trip_count[0] > max_trip_count) {
+      return false;
+    }
+    bool cond = true;
+    Value* cond_input = n->inputs()[1];
+    if (cond_input->node()->kind() != kUndefined && !(getConstantBool(cond_input, &cond) && cond)) {
+      return false;
+    }
+    if (body.outputs()[0] != body.inputs()[1] &&
+        !(getConstantBool(body.outputs()[0], &cond) && cond)) {
+      return false;
+    }
+    size_t num_carried = n->inputs().size() - 2;
+    if (body.inputs().size() != num_carried + 2 ||
+        body.outputs().size() != n->outputs().size() + 1 ||
+        body.outputs().size() < num_carried + 1 || has_graph_attributes(body)) {
+      return false;
+    }
+    size_t num_scans = body.outputs().size() - 1 - num_carried;
+    for (size_t j = 0; j < num_scans; j++) {
+      auto elem_type = body.outputs()[j + 1 + num_carried]->elemType();
+      if (elem_type != TensorProto_DataType_FLOAT16 &&
+          elem_type != TensorProto_DataType_FLOAT &&
+          elem_type != TensorProto_DataType_DOUBLE) {
+        return false;
+      }
+    }
+
+    Rewrite rewrite(scope, names, n);
+    std::vector<Value*> carried(n->inputs().begin() + 2, n->inputs().end());
+    std::vector<std::vector<Value*>> scans(num_scans);
+    for (int64_t i = 0; i < trip_count[0]; i++) {
+      rewrite.env.clear();
+      if (used_in_body(body.inputs()[0])) {
+        Tensor t;
+        t.elem_type() = TensorProto_DataType_INT64;
+        t.int64s().push_back(i);
+        rewrite.env[body.inputs()[0]] = rewrite.constant(std::move(t));
+      }
+      if (used_in_body(body.inputs()[1])) {
+        if (cond_input->node()->kind() == kUndefined) {
+          Tensor t;
+          t.elem_type() = TensorProto_DataType_BOOL;
+          t.int32s().push_back(1);
+          cond_input = rewrite.constant(std::move(t));
+        }
+        rewrite.env[body.inputs()[1]] = cond_input;
+      }
+      for (size_t j = 0; j < num_carried; j++) {
+        rewrite.env[body.inputs()[j + 2]] = carried[j];
+      }
+      rewrite.copy(body, true);
+      for (size_t j = 0; j < num_carried; j++) {
+        carried[j] = rewrite.lookup(body.outputs()[j + 1]);
+      }
+      for (size_t j = 0; j < num_scans; j++) {
+        scans[j].push_back(rewrite.lookup(body.outputs()[j + 1 + num_carried]));
+      }
+    }
+    for (size_t j = 0; j < num_carried; j++) {
+      rewrite.bind(n->outputs()[j], carried[j]);
+    }
+    for (size_t j = 0; j < num_scans; j++) {
+      Value* out = n->outputs()[j + num_carried];
+      std::vector<Value*> slices;
+      for (auto* v : scans[j]) {
+        Node* unsqueeze = scope.graph.create(kUnsqueeze, 1);
+        unsqueeze->addInput(v);
+        unsqueeze->is_(kaxes, {0});
+        unsqueeze->insertBefore(n);
+        slices.push_back(unsqueeze->output());
+      }
+      Value* y = slices[0];
+      if (slices.size() > 1) {
+        Node* concat = scope.graph.create(Symbol("Concat"), slices, 1);
+        concat->i_(kaxis, 0);
+        concat->insertBefore(n);
+        y = concat->output();
+      }
+      y->copyMetadata(out);
+      out->replaceAllUsesWith(y);
+      scope.values[y->uniqueName()] = y;
+    }
+    return true;
+  }
+
+  void inline_constant_control_flow(Graph& graph, ValueNames& names, bool nested) {
+    Scope scope(graph, nested);
+    for (Node* n = *graph.begin(); n != graph.return_node();) {
+      // fresh names depend on the order the graphs are visited in
+      DescendOnGraphAttributesSerially(n, [this, &names](Graph& g){inline_constant_control_flow(g, names, true);});
+      Node* prev = *++n->reverseIterator();
+      if ((n->kind() == kIf && inline_if(scope, names, n)) ||
+          (n->kind() == kLoop && unroll_loop(scope, names, n))) {
+        // visit the copies, whose conditions may now be constants
+        n->destroy();
+        n = *++prev->iterator();
+      } else {
+        n = *++n->iterator();
+      }
+    }
+  }
+
+  void optimize(Graph& graph) override {
+    ValueNames names;
+    names.add(graph);
+    inline_constant_control_flow(graph, names, false);
+  }
+};
+
+}} // namespace ONNX_NAMESPACE::optimization
@@ -3,7 +3,10 @@
 
 #pragma once
 
+#include <set>
+
 #include "onnx/common/ir.h"
+#include "onnx/common/thread_pool.h"
 #include "onnx/onnx_pb.h"
 
 namespace ONNX_NAMESPACE { namespace optimization {
@@ -12,6 +15,58 @@ enum class API_TYPE : uint8_t {
   PROTO, IR
 };
 
+// Returns true for binary elementwise ops using the limited broadcast
+// semantics (`broadcast` and `axis` attributes).
+inline bool IsBroadcastElementwise(NodeKind kind) {
+  static const std::set<NodeKind> kinds = {
+    kAdd, Symbol("And"), kDiv, Symbol("Equal"), Symbol("Greater"),
+    Symbol("Less"), kMul, Symbol("Or"), kPow, kSub, Symbol("Xor")};
+  return kinds.count(kind) > 0;
+}
+
+// Returns true if v is one of the outputs of its graph.
+inline bool IsGraphOutput(const Value* v) {
+  for (auto use : v->uses()) {
+    if (use.user->kind() == kReturn) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Collects the names of the outer values captured by the nested graphs of
+// graph, which must keep their names and stay defined.
+inline void CollectCapturedNames(Graph& graph, std::set<std::string>* names) {
+  for (auto* n : graph.nodes()) {
+    if (n->kind() == kCaptured) {
+      names->insert(n->output()->uniqueName());
+    }
+    for (auto name : n->attributeNames()) {
+      if (n->kindOf(name) == AttributeKind::g) {
+        CollectCapturedNames(*n->g(name), names);
+      } else if (n->kindOf(name) == AttributeKind::gs) {
+        for (auto& g : n->gs(name)) {
+          CollectCapturedNames(*g, names);
+        }
+      }
+    }
+  }
+}
+
+// Sets the metadata_props entry key of mp to value, replacing the value of
+// an existing entry.
+inline void SetMetadataProp(ModelProto& mp, const std::string& key, const std::string& value) {
+  for (auto& prop : *mp.mutable_metadata_props()) {
+    if (prop.key() == key) {
+      prop.set_value(value);
+      return;
+    }
+  }
+  auto* prop = mp.add_metadata_props();
+  prop->set_key(key);
+  prop->set_value(value);
+}
+
 struct OptimizePass {
 
   virtual ~OptimizePass() noexcept = 0;
@@ -27,18 +82,44 @@ struct OptimizePass {
 
   virtual void optimize(Graph& /*graph*/) {}
 
+  // Runs nested graphs of a node concurrently when set. The pass must then
+  // only modify the graph it is given, and read shared state.
+  ThreadPool* pool = nullptr;
+
+  // Calls fn on each nested graph of n, concurrently if the pass has a pool.
   void DescendOnGraphAttributes(Node * n, std::function<void(Graph&)> fn) {
+    auto graphs = nested_graphs(n);
+    if (pool == nullptr || graphs.size() < 2) {
+      for (auto* g : graphs) {
+        fn(*g);
+      }
+      return;
+    }
+    pool->ParallelFor(graphs.size(), [&graphs, &fn](size_t i){fn(*graphs[i]);});
+  }
+
+  // Same, always in order, for passes sharing state between the graphs.
+  void DescendOnGraphAttributesSerially(Node * n, std::function<void(Graph&)> fn) {
+    for (auto* g : nested_graphs(n)) {
+      fn(*g);
+    }
+  }
+
+private:
+  static std::vector<Graph*> nested_graphs(Node * n) {
+    std::vector<Graph*> graphs;
     for (auto name : n->attributeNames()) {
       auto kind = n->kindOf(name);
       if (kind == AttributeKind::g) {
-        fn(*n->g(name));
+        graphs.push_back(n->g(name).get());
       }
       if (kind == AttributeKind::gs) {
         for (auto & g  : n->gs(name)) {
-          fn(*g);
+          graphs.push_back(g.get());
         }
       }
     }
+    return graphs;
   }
 
 };
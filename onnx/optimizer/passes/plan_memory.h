@@ -0,0 +1,45 @@
+// ATTENTION: The code in this file is highly EXPERIMENTAL.
+// Adventurous users should note that the APIs will probably change.
+
+#pragma once
+
+// Before:
+//   A = Conv(X, W)        A and B have 1024 bytes, C has 16 bytes
+//   B = Relu(A)
+//   C = GlobalAveragePool(B)
+//   Y = Flatten(C)
+// After:
+//   metadata_props["memory_plan"] = "arena 1040\n"
+//                                   "0 1024 A\n"
+//                                   "0 1024 B\n"
+//                                   "1024 16 C\n"
+//
+// Computes a static memory plan for the values of the main graph (see
+// memory_plan.h), and stores it in the metadata_props of the model as
+// memory_plan. The nodes are not changed. Sizes are only known for values
+// with a static shape, so shape inference should be run first.
+
+#include "onnx/common/ir_pb_converter.h"
+#include "onnx/optimizer/memory_plan.h"
+#include "onnx/optimizer/passes/optimize_pass.h"
+
+namespace ONNX_NAMESPACE { namespace optimization {
+
+struct PlanMemoryPass final : public OptimizePass {
+  explicit PlanMemoryPass(int64_t alignment = 64)
+    : OptimizePass("plan_memory", API_TYPE::PROTO), alignment(alignment) {
+  }
+
+  int64_t alignment;
+
+  void optimize(ModelProto& mp) override {
+    std::shared_ptr<Graph> graph(ImportModelProto(mp));
+    if (graph == nullptr) {
+      return;
+    }
+    auto plan = PlanMemory(*graph, alignment);
+    SetMetadataProp(mp, "memory_plan", plan.serialize());
+  }
+};
+
+}} // namespace ONNX_NAMESPACE::optimization
@@ -0,0 +1,251 @@
+// ATTENTION: The code in this file is highly EXPERIMENTAL.
+// Adventurous users should note that the APIs will probably change.
+
+#pragma once
+
+// Before:
+//   A1 = Conv(X, W1)      A1, B1 and C1 are large
+//   B1 = Conv(X, W2)
+//   C1 = Conv(X, W3)
+//   A2 = GlobalAveragePool(A1)
+//   B2 = GlobalAveragePool(B1)
+//   C2 = GlobalAveragePool(C1)
+// After:
+//   A1 = Conv(X, W1)
+//   A2 = GlobalAveragePool(A1)
+//   B1 = Conv(X, W2)
+//   B2 = GlobalAveragePool(B1)
+//   C1 = Conv(X, W3)
+//   C2 = GlobalAveragePool(C1)
+//
+// Reorders the nodes of the graph to reduce the peak of the bytes held by
+// the values computed by nodes, when the nodes run in list order and each
+// value is freed after its last use. Nested graphs are reordered on their
+// own.
+//
+// The size of a value is estimated from its element type and sizes, and is
+// 0 when they are not known or the sizes are empty, so shape inference
+// should be run first. The
+// order is built greedily: among the nodes whose inputs are computed, the
+// one that increases the live bytes the least runs first, the earliest one
+// in the current order on ties. The new order is kept only if its peak is
+// lower.
+//
+// The peaks of the main graph before and after the pass are reported in
+// the metadata_props of the model as peak_memory_bytes_before and
+// peak_memory_bytes_after.
+
+#include <algorithm>
+#include <unordered_map>
+
+#include "onnx/common/ir_pb_converter.h"
+#include "onnx/optimizer/memory_plan.h"
+#include "onnx/optimizer/passes/optimize_pass.h"
+#include "onnx/string_utils.h"
+
+namespace ONNX_NAMESPACE { namespace optimization {
+
+struct ReorderForPeakMemory final : public OptimizePass {
+  explicit ReorderForPeakMemory()
+    : OptimizePass("reorder_for_peak_memory", API_TYPE::PROTO) {
+  }
+
+  // The values read by the nodes of a graph, including the values captured
+  // by name by their nested graphs.
+  struct Analysis {
+    std::vector<Node*> nodes;
+    std::unordered_map<Node*, size_t> index;
+    std::unordered_map<Node*, std::vector<Value*>> reads;
+    std::unordered_map<Value*, std::vector<Node*>> readers;
+
+    explicit Analysis(Graph& graph) {
+      std::unordered_map<std::string, Value*> values;
+      for (auto* n : graph.nodes()) {
+        if (n->kind() == kCaptured || n->kind() == kUndefined) {
+          continue;
+        }
+        index[n] = nodes.size();
+        nodes.push_back(n);
+        for (auto* v : n->outputs()) {
+          values[v->uniqueName()] = v;
+        }
+      }
+      for (auto* n : nodes) {
+        std::set<Value*> read;
+        for (auto* v : n->inputs()) {
+          read.insert(v);
+        }
+        std::set<std::string> captured;
+        for (auto name : n->attributeNames()) {
+          if (n->kindOf(name) == AttributeKind::g) {
+            CollectCapturedNames(*n->g(name), &captured);
+          } else if (n->kindOf(name) == AttributeKind::gs) {
+            for (auto& g : n->gs(name)) {
+              CollectCapturedNames(*g, &captured);
+            }
+          }
+        }
+        for (const auto& name : captured) {
+          auto it = values.find(name);
+          if (it != values.end() && is_computed(it->second) &&
+              index.at(it->second->node()) < index.at(n)) {
+            read.insert(it->second);
+          }
+        }
+        for (auto* v : read) {
+          reads[n].push_back(v);
+          readers[v].push_back(n);
+        }
+      }
+    }
+
+    bool is_computed(Value* v) const {
+      return index.count(v->node()) > 0;
+    }
+
+    size_t num_readers(Value* v) const {
+      auto it = readers.find(v);
+      return it == readers.end() ? 0 : it->second.size();
+    }
+
+    // Bytes allocated and freed when running n, given the number of
+    // readers of each value not run yet.
+    std::pair<int64_t, int64_t> step(
+        Node* n, const std::unordered_map<Value*, size_t>& remaining) const {
+      int64_t allocated = 0;
+      int64_t freed = 0;
+      for (auto* v : n->outputs()) {
+        allocated += ValueBytes(v);
+        if (num_readers(v) == 0 && !IsGraphOutput(v)) {
+          freed += ValueBytes(v);
+        }
+      }
+      auto it = reads.find(n);
+      if (it != reads.end()) {
+        for (auto* v : it->second) {
+          if (is_computed(v) && remaining.at(v) == 1 && !IsGraphOutput(v)) {
+            freed += ValueBytes(v);
+          }
+        }
+      }
+      return {allocated, freed};
+    }
+
+    std::unordered_map<Value*, size_t> initial_remaining() const {
+      std::unordered_map<Value*, size_t> remaining;
+      for (const auto& p : readers) {
+        remaining[p.first] = p.second.size();
+      }
+      return remaining;
+    }
+
+    void run(Node* n, std::unordered_map<Value*, size_t>* remaining) const {
+      auto it = reads.find(n);
+      if (it != reads.end()) {
+        for (auto* v : it->second) {
+          (*remaining)[v]--;
+        }
+      }
+    }
+
+    int64_t peak_bytes(const std::vector<Node*>& order) const {
+      auto remaining = initial_remaining();
+      int64_t live = 0;
+      int64_t peak = 0;
+      for (auto* n : order) {
+        auto bytes = step(n, remaining);
+        live += bytes.first;
+        peak = std::max(peak, live);
+        live -= bytes.second;
+        run(n, &remaining);
+      }
+      return peak;
+    }
+
+    // Returns an order of the nodes built greedily, or an empty order if
+    // the dependencies have a cycle.
+    std::vector<Node*> schedule() const {
+      auto remaining = initial_remaining();
+      std::unordered_map<Node*, size_t> pending;
+      std::set<size_t> ready;
+      for (auto* n : nodes) {
+        size_t count = 0;
+        auto it = reads.find(n);
+        if (it != reads.end()) {
+          for (auto* v : it->second) {
+            count += is_computed(v) ? 1 : 0;
+          }
+        }
+        pending[n] = count;
+        if (count == 0) {
+          ready.insert(index.at(n));
+        }
+      }
+      std::vector<Node*> order;
+      while (!ready.empty()) {
+        Node* best = nullptr;
+        int64_t best_delta = 0;
+        for (auto i : ready) {
+          auto bytes = step(nodes[i], remaining);
+          if (best == nullptr || bytes.first - bytes.second < best_delta) {
+            best = nodes[i];
+            best_delta = bytes.first - bytes.second;
+          }
+        }
+        ready.erase(index.at(best));
+        order.push_back(best);
+        run(best, &remaining);
+        for (auto* v : best->outputs()) {
+          auto it = readers.find(v);
+          if (it == readers.end()) {
+            continue;
+          }
+          for (auto* m : it->second) {
+            if (--pending[m] == 0) {
+              ready.insert(index.at(m));
+            }
+          }
+        }
+      }
+      if (order.size() != nodes.size()) {
+        order.clear();
+      }
+      return order;
+    }
+  };
+
+  // Reorders the nodes of graph and of its nested graphs. Returns the peak
+  // live bytes of graph before and after.
+  std::pair<int64_t, int64_t> reorder(Graph& graph) {
+    for (auto* n : graph.nodes()) {
+      DescendOnGraphAttributes(n, [this](Graph& g){reorder(g);});
+    }
+    Analysis analysis(graph);
+    int64_t before = analysis.peak_bytes(analysis.nodes);
+    auto order = analysis.schedule();
+    if (order.empty()) {
+      return {before, before};
+    }
+    int64_t after = analysis.peak_bytes(order);
+    if (after >= before) {
+      return {before, before};
+    }
+    for (auto* n : order) {
+      n->moveBefore(graph.return_node());
+    }
+    return {before, after};
+  }
+
+  void optimize(ModelProto& mp) override {
+    std::shared_ptr<Graph> graph(ImportModelProto(mp));
+    if (graph == nullptr) {
+      return;
+    }
+    auto peaks = reorder(*graph);
+    ExportModelProto(&mp, graph);
+    SetMetadataProp(mp, "peak_memory_bytes_before", ONNX_NAMESPACE::to_string(peaks.first));
+    SetMetadataProp(mp, "peak_memory_bytes_after", ONNX_NAMESPACE::to_string(peaks.second));
+  }
+};
+
+}} // namespace ONNX_NAMESPACE::optimization
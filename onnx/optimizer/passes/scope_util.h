@@ -0,0 +1,120 @@
+// ATTENTION: The code in this file is highly EXPERIMENTAL.
+// Adventurous users should note that the APIs will probably change.
+
+#pragma once
+
+#include <unordered_map>
+
+#include "onnx/optimizer/passes/optimize_pass.h"
+#include "onnx/string_utils.h"
+
+namespace ONNX_NAMESPACE { namespace optimization {
+
+// Helpers for passes that move nodes between a graph and its nested graphs.
+// Nested graphs refer to the values of the enclosing graphs by name, and no
+// nested graph may define a name visible from its enclosing graphs, so moved
+// values must keep unique names.
+
+// The number of definitions of each value name in a model, used to generate
+// names that are not used anywhere in the model.
+struct ValueNames {
+  std::unordered_map<std::string, size_t> counts;
+
+  void add(Graph& graph) {
+    for (auto* v : graph.inputs()) {
+      counts[v->uniqueName()]++;
+    }
+    for (auto* n : graph.nodes()) {
+      if (n->kind() != kCaptured && n->kind() != kUndefined) {
+        for (auto* v : n->outputs()) {
+          counts[v->uniqueName()]++;
+        }
+      }
+      for (auto name : n->attributeNames()) {
+        if (n->kindOf(name) == AttributeKind::g) {
+          add(*n->g(name));
+        } else if (n->kindOf(name) == AttributeKind::gs) {
+          for (auto& g : n->gs(name)) {
+            add(*g);
+          }
+        }
+      }
+    }
+  }
+
+  // Returns true if name is defined once in the model.
+  bool unique(const std::string& name) const {
+    auto it = counts.find(name);
+    return it != counts.end() && it->second == 1;
+  }
+
+  std::string fresh(const std::string& base) {
+    for (size_t i = 1; ; i++) {
+      std::string name = base + "_" + ONNX_NAMESPACE::to_string(i);
+      if (counts.count(name) == 0) {
+        counts[name] = 1;
+        return name;
+      }
+    }
+  }
+};
+
+// The values of a graph by name. Names not defined in a nested graph are
+// captured from the enclosing graph.
+struct Scope {
+  Graph& graph;
+  bool nested;
+  std::unordered_map<std::string, Value*> values;
+
+  Scope(Graph& graph, bool nested) : graph(graph), nested(nested) {
+    for (auto* v : graph.inputs()) {
+      values[v->uniqueName()] = v;
+    }
+    for (auto* n : graph.nodes()) {
+      for (auto* v : n->outputs()) {
+        values[v->uniqueName()] = v;
+      }
+    }
+  }
+
+  // Returns the value named name, or nullptr if the graph is not nested and
+  // does not define it.
+  Value* find(const std::string& name) {
+    auto it = values.find(name);
+    if (it != values.end()) {
+      return it->second;
+    }
+    if (!nested) {
+      return nullptr;
+    }
+    Node* captured = graph.create(kCaptured, 1);
+    graph.appendNode(captured);
+    captured->output()->setUniqueName(name);
+    values[name] = captured->output();
+    return captured->output();
+  }
+};
+
+// Renames the values captured by graph and its nested graphs.
+inline void RenameCaptured(
+    Graph& graph, const std::unordered_map<std::string, std::string>& renames) {
+  for (auto* n : graph.nodes()) {
+    if (n->kind() == kCaptured) {
+      auto it = renames.find(n->output()->uniqueName());
+      if (it != renames.end()) {
+        n->output()->setUniqueName(it->second);
+      }
+    }
+    for (auto name : n->attributeNames()) {
+      if (n->kindOf(name) == AttributeKind::g) {
+        RenameCaptured(*n->g(name), renames);
+      } else if (n->kindOf(name) == AttributeKind::gs) {
+        for (auto& g : n->gs(name)) {
+          RenameCaptured(*g, renames);
+        }
+      }
+    }
+  }
+}
+
+}} // namespace ONNX_NAMESPACE::optimization
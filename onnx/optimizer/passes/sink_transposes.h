@@ -0,0 +1,276 @@
+// ATTENTION: The code in this file is highly EXPERIMENTAL.
+// Adventurous users should note that the APIs will probably change.
+
+#pragma once
+
+// Before:
+//   T1 = Transpose(X, perm=p)
+//   Y = Relu(T1) + Transpose(Z, perm=p)
+//   W = Transpose(Y, perm=q)
+// After:
+//   W = Transpose(Relu(X) + Z, perm=compose(p, q))
+//
+// Transposes are pushed towards the outputs through elementwise ops and
+// Concat whose output has the element type of their inputs, since
+// Transpose only takes floating point tensors, until they reach another Transpose, where the two are fused
+// (and removed altogether when the composed permutation is the identity).
+// Along the way:
+//   - every input of a multi-input op has to be a Transpose with the same
+//     permutation or a constant, which is transposed ahead of time;
+//   - broadcast operands are either transposed or given a new axis;
+//   - the axis of Concat is remapped.
+
+#include <set>
+
+#include "onnx/optimizer/passes/constant_util.h"
+#include "onnx/optimizer/passes/optimize_pass.h"
+
+namespace ONNX_NAMESPACE { namespace optimization {
+
+struct SinkTransposes final : public OptimizePass {
+  explicit SinkTransposes()
+    : OptimizePass("sink_transposes", API_TYPE::IR) {
+  }
+
+  static bool is_unary_elementwise(NodeKind kind) {
+    static const std::set<NodeKind> kinds = {
+      Symbol("Abs"), Symbol("Affine"), Symbol("Ceil"),
+      Symbol("Clip"), Symbol("Elu"), Symbol("Exp"), Symbol("Floor"),
+      Symbol("HardSigmoid"), kIdentity, Symbol("LeakyRelu"), Symbol("Log"),
+      kNeg, Symbol("ParametricSoftplus"), Symbol("Reciprocal"),
+      Symbol("Relu"), Symbol("ScaledTanh"), Symbol("Selu"), kSigmoid,
+      Symbol("Softplus"), Symbol("Softsign"), Symbol("Sqrt"), kTanh,
+      Symbol("ThresholdedRelu")};
+    return kinds.count(kind) > 0;
+  }
+
+  // Binary elementwise ops with the limited broadcast semantics, leaving
+  // out the comparisons and logical ops, whose output is bool.
+  static bool is_binary_elementwise(NodeKind kind) {
+    static const std::set<NodeKind> kinds = {kAdd, kDiv, kMul, kPow, kSub};
+    return kinds.count(kind) > 0;
+  }
+
+  // Variadic elementwise ops whose inputs all have the same shape.
+  static bool is_variadic_elementwise(NodeKind kind) {
+    static const std::set<NodeKind> kinds = {
+      Symbol("Max"), Symbol("Mean"), Symbol("Min"), Symbol("Sum")};
+    return kinds.count(kind) > 0;
+  }
+
+  static std::vector<int64_t> invert_perm(const std::vector<int64_t>& perm) {
+    std::vector<int64_t> inv(perm.size());
+    for (size_t i = 0; i < perm.size(); i++) {
+      inv[static_cast<size_t>(perm[i])] = static_cast<int64_t>(i);
+    }
+    return inv;
+  }
+
+  static bool is_identity_perm(const std::vector<int64_t>& perm) {
+    for (size_t i = 0; i < perm.size(); i++) {
+      if (perm[i] != static_cast<int64_t>(i)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // How an input of the op the Transpose is sunk through gets rewritten.
+  struct InputRewrite {
+    size_t index;
+    Value* replacement;             // new input, or nullptr to keep it
+    Node* transpose;                // Transpose to destroy, if any
+    std::vector<int64_t> const_perm; // permutation of a constant input
+  };
+
+  // Plans the rewrite of input i of u, which will now see the untransposed
+  // tensors. A constant of rank `rank` has to be transposed by the inverse
+  // permutation; a lower-rank broadcast operand starting at `axis` is
+  // transposed only if its dimensions got reordered, and *new_axis is set
+  // to where they now start.
+  static bool plan_input(Node* u, size_t i, Value* t, const std::vector<int64_t>& perm,
+      int64_t axis, int64_t* new_axis, std::vector<InputRewrite>* plan) {
+    Value* v = u->inputs()[i];
+    if (v == t) {
+      plan->push_back({i, t->node()->input(), nullptr, {}});
+      return true;
+    }
+    Node* p = v->node();
+    if (p->kind() == kTranspose && v->uses().size() == 1 &&
+        p->hasAttribute(kperm) && p->is(kperm) == perm) {
+      plan->push_back({i, p->input(), p, {}});
+      return true;
+    }
+    const Tensor* c = getConstantTensor(v);
+    if (c == nullptr) {
+      return false;
+    }
+    if (numElements(*c) == 1 && axis >= 0) {
+      // a scalar broadcast operand is not affected by the transposition
+      return true;
+    }
+    const auto rank = static_cast<int64_t>(perm.size());
+    const auto m = static_cast<int64_t>(c->sizes().size());
+    if (axis < 0) {
+      if (m != rank) {
+        return false;
+      }
+      axis = 0;
+    } else if (m == 0 || axis + m > rank) {
+      return false;
+    }
+    // the dimensions of the operand now come from a contiguous range of
+    // the untransposed input starting at `start`
+    int64_t start = rank;
+    for (int64_t k = axis; k < axis + m; k++) {
+      start = std::min(start, perm[static_cast<size_t>(k)]);
+    }
+    auto inv = invert_perm(perm);
+    std::vector<int64_t> const_perm;
+    for (int64_t k = start; k < start + m; k++) {
+      if (k >= rank) {
+        return false;
+      }
+      int64_t src = inv[static_cast<size_t>(k)] - axis;
+      if (src < 0 || src >= m) {
+        return false;
+      }
+      const_perm.push_back(src);
+    }
+    *new_axis = start;
+    if (is_identity_perm(const_perm)) {
+      return true;
+    }
+    if (v->uses().size() != 1) {
+      return false;
+    }
+    plan->push_back({i, nullptr, nullptr, const_perm});
+    return true;
+  }
+
+  // Moves the Transpose n below its single user, returning false if this is
+  // not possible. n is left without uses on success.
+  bool sink(Graph& graph, Node* n) {
+    if (!n->hasAttribute(kperm) || n->output()->uses().size() != 1) {
+      return false;
+    }
+    auto perm = n->is(kperm);
+    auto t = n->output();
+    Node* u = t->uses()[0].user;
+
+    if (u->kind() == kTranspose) {
+      if (!u->hasAttribute(kperm)) {
+        return false;
+      }
+      std::vector<int64_t> composed;
+      for (auto p : u->is(kperm)) {
+        composed.push_back(perm[static_cast<size_t>(p)]);
+      }
+      if (is_identity_perm(composed)) {
+        // keep the name of graph outputs when the input is an intermediate value
+        auto x = n->input();
+        if (IsGraphOutput(u->output()) && !IsGraphOutput(x) &&
+            x->node()->kind() != kParam && x->node()->kind() != kCaptured) {
+          x->copyMetadata(u->output());
+        }
+        u->output()->replaceAllUsesWith(x);
+        u->destroy();
+      } else {
+        u->is_(kperm, std::move(composed));
+        u->replaceInput(0, n->input());
+      }
+      return true;
+    }
+    if (u->outputs().size() != 1) {
+      return false;
+    }
+
+    std::vector<InputRewrite> plan;
+    int64_t new_axis = -1;
+    bool ok = true;
+    if (is_unary_elementwise(u->kind())) {
+      plan.push_back({0, n->input(), nullptr, {}});
+    } else if (is_binary_elementwise(u->kind()) && u->inputs().size() == 2) {
+      bool broadcast = u->hasAttribute(kbroadcast) && u->i(kbroadcast) != 0;
+      int64_t axis = -1;
+      const Tensor* c = getConstantTensor(u->inputs()[1]);
+      if (broadcast && c != nullptr) {
+        axis = u->hasAttribute(kaxis) ? u->i(kaxis)
+          : static_cast<int64_t>(perm.size()) - static_cast<int64_t>(c->sizes().size());
+      }
+      ok = plan_input(u, 0, t, perm, -1, &new_axis, &plan) &&
+        plan_input(u, 1, t, perm, axis, &new_axis, &plan);
+    } else if (is_variadic_elementwise(u->kind()) ||
+        (u->kind() == Symbol("Concat") && u->hasAttribute(kaxis))) {
+      for (size_t i = 0; ok && i < u->inputs().size(); i++) {
+        ok = plan_input(u, i, t, perm, -1, &new_axis, &plan);
+      }
+    } else {
+      return false;
+    }
+    if (!ok) {
+      return false;
+    }
+
+    for (auto& r : plan) {
+      if (r.replacement != nullptr) {
+        u->replaceInput(r.index, r.replacement);
+        if (r.transpose != nullptr) {
+          r.transpose->destroy();
+        }
+      } else {
+        bool transposed = transposeConstant(u->inputs()[r.index], r.const_perm);
+        ONNX_ASSERT(transposed);
+      }
+    }
+    if (u->kind() == Symbol("Concat")) {
+      u->i_(kaxis, perm[static_cast<size_t>(u->i(kaxis))]);
+    } else if (new_axis >= 0 && u->hasAttribute(kbroadcast) && u->i(kbroadcast) != 0) {
+      u->i_(kaxis, new_axis);
+    }
+
+    // Y = u(...) now has the untransposed layout, add the Transpose after it.
+    auto y = u->output();
+    Node* nt = graph.create(kTranspose, 1);
+    nt->is_(kperm, std::vector<int64_t>(perm));
+    nt->insertAfter(u);
+    nt->output()->copyMetadata(y);
+    y->replaceAllUsesWith(nt->output());
+    nt->addInput(y);
+    // reuse the name of the eliminated value to keep names unique
+    y->setUniqueName(t->uniqueName());
+    if (y->sizes().size() == perm.size()) {
+      auto sizes = y->sizes();
+      for (size_t i = 0; i < perm.size(); i++) {
+        sizes[static_cast<size_t>(perm[i])] = y->sizes()[i];
+      }
+      y->setSizes(sizes);
+    } else {
+      y->setSizes({});
+    }
+    return true;
+  }
+
+  void sink_transposes(Graph& graph) {
+    for (auto* n : graph.nodes()) {
+      DescendOnGraphAttributes(n, [this](Graph& g){sink_transposes(g);});
+    }
+    bool changed = true;
+    while (changed) {
+      changed = false;
+      for (auto it = graph.begin(); it != graph.end(); ++it) {
+        auto* n = *it;
+        if (n->kind() == kTranspose && sink(graph, n)) {
+          it.destroyCurrent();
+          changed = true;
+        }
+      }
+    }
+  }
+
+  void optimize(Graph& graph) override {
+    sink_transposes(graph);
+  }
+};
+
+}} // namespace ONNX_NAMESPACE::optimization
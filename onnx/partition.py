@@ -0,0 +1,46 @@
+"""onnx partitioning. Splits the main graph of a model between a backend
+supporting some of its ops, such as an ONNXIFI backend, and the runtime
+running the others.
+
+"""
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+from __future__ import unicode_literals
+
+import onnx
+import onnx.onnx_cpp2py_export.partition as C
+import onnx.shape_inference
+from onnx import ModelProto
+
+"""Partition the main graph of the provided ModelProto.
+
+The nodes of the default domain whose op type is in supported_ops are grouped
+into partitions such that every path between two nodes of a partition stays
+in the partition, and replacing each partition by a single node keeps the
+graph acyclic. Each partition is returned as a model of its own, named
+"partition_<i>", and replaced in the main graph by a Partition node whose
+partition attribute is that name.
+
+Shape inference is run first, so that the inputs and outputs of the
+partitions have their inferred types.
+
+Arguments:
+    input (ModelProto): ModelProto
+    supported_ops (list of string): op types supported by the backend
+
+Return:
+    return (ModelProto, list of ModelProto) main model calling the partitions,
+        and the model of each partition
+"""
+
+
+def partition(model, supported_ops):
+    if not isinstance(model, ModelProto):
+        raise ValueError('Partitioning only accepts ModelProto, '
+                         'incorrect type: {}'.format(type(model)))
+
+    model_str = onnx.shape_inference.infer_shapes(model).SerializeToString()
+    main_str, partition_strs = C.partition(model_str, set(supported_ops))
+    return (onnx.load_from_string(main_str),
+            [onnx.load_from_string(s) for s in partition_strs])
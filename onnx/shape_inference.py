@@ -11,6 +11,12 @@ import onnx
 import onnx.onnx_cpp2py_export.shape_inference as C
 from onnx import ModelProto
 
+"""Memoizes the shapes inferred for the outputs of nodes, keyed on their
+schema, attributes and input types. Counts its hits and misses, and
+estimates the time the hits saved in saved_seconds.
+"""
+InferenceCache = C.InferenceCache
+
 """Apply shape inference to the provided ModelProto.
 
 Inferred shapes are added to the value_info field of the graph.
@@ -19,19 +25,113 @@ If the inferred values conflict with values already provided in the
 graph, that means that the provided values are invalid (or there is a
 bug in shape inference), and the result is unspecified.
 
+The shapes inferred for the outputs of each node but those with graph
+attributes are looked up in cache, and added to it, when cache is given.
+A cache can be reused by the inference of several models, so that the
+blocks they repeat are inferred once.
+
 Arguments:
     input (ModelProto): ModelProto
+    cache (InferenceCache): cache of the inferred shapes, or None
 
 Return:
     return (ModelProto) model with inferred shape information
 """
 
 
-def infer_shapes(model):
+def infer_shapes(model, cache=None):
     if not isinstance(model, ModelProto):
         raise ValueError('Shape inference only accepts ModelProto, '
                          'incorrect type: {}'.format(type(model)))
 
     model_str = model.SerializeToString()
-    inferred_model_str = C.infer_shapes(model_str)
+    inferred_model_str = C.infer_shapes(model_str, cache)
     return onnx.load_from_string(inferred_model_str)
+
+
+"""Check the provided ModelProto and apply shape inference to it, in one
+pass over its graph.
+
+Raises the error onnx.checker.check_model would raise for the model.
+Otherwise raises the first error of its nodes in order: the error
+infer_shapes would raise for the node, or an onnx.checker.ValidationError
+if the type of one of its inputs is not allowed by its schema or differs
+from that of another input of the same type constraint.
+
+Arguments:
+    input (ModelProto): ModelProto
+
+Return:
+    return (ModelProto) model with inferred shape information
+"""
+
+
+def check_and_infer_shapes(model):
+    if not isinstance(model, ModelProto):
+        raise ValueError('Shape inference only accepts ModelProto, '
+                         'incorrect type: {}'.format(type(model)))
+
+    model_str = model.SerializeToString()
+    inferred_model_str = C.check_and_infer_shapes(model_str)
+    return onnx.load_from_string(inferred_model_str)
+
+
+"""Same as check_and_infer_shapes, but on the IR graph the model converts to,
+as optimizer passes see it, without converting it back to a ModelProto in
+between.
+
+The IR cannot tell a scalar from a value whose shape is not known, so the
+values whose shape is not known have an empty shape in the model returned.
+
+Arguments:
+    input (ModelProto): ModelProto
+
+Return:
+    return (ModelProto) model with inferred shape information
+"""
+
+
+def check_and_infer_shapes_on_graph(model):
+    if not isinstance(model, ModelProto):
+        raise ValueError('Shape inference only accepts ModelProto, '
+                         'incorrect type: {}'.format(type(model)))
+
+    model_str = model.SerializeToString()
+    inferred_model_str = C.check_and_infer_shapes_on_graph(model_str)
+    return onnx.load_from_string(inferred_model_str)
+
+
+"""Infers the shapes of the values of the main graph of a ModelProto like
+infer_shapes, and re-infers them when the types of some of its inputs
+change, e.g. to specialize it for another batch size. Only the nodes which
+read a value whose type changed are re-inferred.
+
+Arguments:
+    input (ModelProto): ModelProto, which is not modified
+"""
+
+
+class IncrementalInference(object):
+    def __init__(self, model):
+        if not isinstance(model, ModelProto):
+            raise ValueError('Shape inference only accepts ModelProto, '
+                             'incorrect type: {}'.format(type(model)))
+
+        self._inference = C.IncrementalInference(model.SerializeToString())
+
+    # Sets the types of the inputs named in input_types, a dict of TypeProto
+    # by input name, and re-infers the nodes which depend on them. The value_info
+    # of the values of which nothing is inferred anymore is removed. Returns
+    # the number of nodes re-inferred.
+    #
+    # Raises, changing nothing, if a name is not that of an input. If the
+    # inference of a node raises, the nodes not re-inferred yet are re-inferred
+    # by the next call.
+    def update_input_types(self, input_types):
+        return self._inference.update_input_types(
+            {name: t.SerializeToString() for name, t in input_types.items()})
+
+    # The model with the shapes inferred so far.
+    @property
+    def model(self):
+        return onnx.load_from_string(self._inference.model())
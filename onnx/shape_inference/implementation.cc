@@ -0,0 +1,617 @@
+#include "onnx/shape_inference/implementation.h"
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <unordered_set>
+
+#include "onnx/common/ir_pb_converter.h"
+
+namespace ONNX_NAMESPACE {
+namespace shape_inference {
+
+void checkShapesAndTypes(
+    const TypeProto_Tensor& inferredType,
+    const TypeProto_Tensor& existingType) {
+  if (inferredType.elem_type() != TensorProto::UNDEFINED &&
+      existingType.elem_type() != TensorProto::UNDEFINED &&
+      existingType.elem_type() != inferredType.elem_type()) {
+    std::stringstream ss;
+    ss << "Inferred elem type differs from existing elem type: ("
+       << inferredType.elem_type()
+       << ") vs ("
+       << existingType.elem_type()
+       << ")";
+    throw std::runtime_error(ss.str());
+  }
+
+  if (!inferredType.has_shape() || !existingType.has_shape()) {
+    return;
+  }
+
+  if (inferredType.shape().dim_size() != existingType.shape().dim_size()) {
+    std::stringstream ss;
+    ss << "Inferred shape and existing shape differ in rank: ("
+       << inferredType.shape().dim_size()
+       << ") vs ("
+       << existingType.shape().dim_size()
+       << ")";
+    throw std::runtime_error(ss.str());
+  }
+
+  for (int i = 0; i < inferredType.shape().dim_size(); ++i) {
+    const auto& inferredDim = inferredType.shape().dim(i);
+    const auto& existingDim = existingType.shape().dim(i);
+    if (inferredDim.has_dim_value() &&
+        existingDim.has_dim_value() &&
+        inferredDim.dim_value() != existingDim.dim_value()) {
+      std::stringstream ss;
+      ss << "Inferred shape and existing shape differ in dimension "
+         << i
+         << ": ("
+         << inferredDim.dim_value()
+         << ") vs ("
+         << existingDim.dim_value()
+         << ")";
+      throw std::runtime_error(ss.str());
+    }
+  }
+}
+
+void mergeShapesAndTypes(
+    const TypeProto_Tensor& inferredType,
+    TypeProto_Tensor* existingType) {
+  if (inferredType.elem_type() != TensorProto::UNDEFINED &&
+      existingType->elem_type() == TensorProto::UNDEFINED) {
+    existingType->set_elem_type(inferredType.elem_type());
+  }
+
+  if (!inferredType.has_shape()) {
+    return;
+  }
+
+  if (!existingType->has_shape()) {
+    // Ensure the shape is initialized. Note that this must be done
+    // even for (zero-dimensional) scalars.
+    existingType->mutable_shape();
+
+    for (int j = 0; j < inferredType.shape().dim_size(); ++j) {
+      existingType->mutable_shape()->add_dim();
+    }
+  }
+
+  for (int i = 0; i < inferredType.shape().dim_size(); ++i) {
+    const auto& inferredDim = inferredType.shape().dim(i);
+    auto* existingDim = existingType->mutable_shape()->mutable_dim(i);
+    if (!existingDim->has_dim_value()) {
+      *existingDim = inferredDim;
+    }
+  }
+}
+
+void mergeNodeOutputTypes(
+    const NodeProto& n,
+    const std::vector<TypeProto>& inferredTypes,
+    GraphProto* g,
+    std::unordered_map<std::string, TypeProto*>& valueTypesByName) {
+  for (int i = 0; i < n.output_size(); ++i) {
+    const auto& inferredType =
+        inferredTypes[static_cast<size_t>(i)].tensor_type();
+
+    // Bail out early if shape inference does nothing useful.
+    if (inferredType.elem_type() == TensorProto::UNDEFINED && !inferredType.has_shape()) {
+      continue;
+    }
+
+    // Find any pre-existing type and shape info. If there is such,
+    // then check for compatability with the inferred
+    // information. Otherwise, initialize it in an empty state.
+    auto iter = valueTypesByName.find(n.output(i));
+    TypeProto* existingType = nullptr;
+    if (iter != valueTypesByName.end()) {
+      existingType = iter->second;
+      checkShapesAndTypes(inferredType, existingType->tensor_type());
+    } else {
+      auto vi = g->add_value_info();
+      vi->set_name(n.output(i));
+      existingType = vi->mutable_type();
+    }
+
+    // Now we can merge pre-existing and inferred info, without
+    // further need for error-checking.
+    mergeShapesAndTypes(inferredType, existingType->mutable_tensor_type());
+
+    // Make merged info available to futher inference.
+    valueTypesByName[n.output(i)] = existingType;
+  }
+}
+
+namespace {
+
+template <typename T>
+void appendKeyPart(T part, std::string* key) {
+  key->append(reinterpret_cast<const char*>(&part), sizeof(part));
+}
+
+void appendKeyPart(const std::string& part, std::string* key) {
+  appendKeyPart(static_cast<uint32_t>(part.size()), key);
+  key->append(part);
+}
+
+void appendKeyPart(const google::protobuf::MessageLite& part, std::string* key) {
+  appendKeyPart(static_cast<uint32_t>(part.ByteSizeLong()), key);
+  part.AppendToString(key);
+}
+
+// Attributes and tensor types are appended field by field, which is much
+// cheaper than serializing them. Their documentation does not matter.
+void appendKeyPart(const AttributeProto& attr, std::string* key) {
+  if (attr.has_t() || attr.tensors_size() > 0 || attr.has_ref_attr_name()) {
+    key->push_back('s');
+    appendKeyPart(static_cast<const google::protobuf::MessageLite&>(attr), key);
+    return;
+  }
+  key->push_back('a');
+  appendKeyPart(attr.name(), key);
+  appendKeyPart(static_cast<int32_t>(attr.type()), key);
+  key->push_back(static_cast<char>(
+      (attr.has_f() ? 1 : 0) | (attr.has_i() ? 2 : 0) | (attr.has_s() ? 4 : 0)));
+  if (attr.has_f()) {
+    appendKeyPart(attr.f(), key);
+  }
+  if (attr.has_i()) {
+    appendKeyPart(attr.i(), key);
+  }
+  if (attr.has_s()) {
+    appendKeyPart(attr.s(), key);
+  }
+  appendKeyPart(static_cast<uint32_t>(attr.floats_size()), key);
+  for (float f : attr.floats()) {
+    appendKeyPart(f, key);
+  }
+  appendKeyPart(static_cast<uint32_t>(attr.ints_size()), key);
+  for (int64_t i : attr.ints()) {
+    appendKeyPart(i, key);
+  }
+  appendKeyPart(static_cast<uint32_t>(attr.strings_size()), key);
+  for (const auto& str : attr.strings()) {
+    appendKeyPart(str, key);
+  }
+}
+
+void appendKeyPart(const TypeProto& type, std::string* key) {
+  if (type.value_case() != TypeProto::kTensorType) {
+    key->push_back('s');
+    appendKeyPart(static_cast<const google::protobuf::MessageLite&>(type), key);
+    return;
+  }
+  const auto& tensor_type = type.tensor_type();
+  key->push_back('t');
+  appendKeyPart(static_cast<int32_t>(tensor_type.elem_type()), key);
+  if (!tensor_type.has_shape()) {
+    key->push_back('-');
+    return;
+  }
+  appendKeyPart(static_cast<uint32_t>(tensor_type.shape().dim_size()), key);
+  for (const auto& dim : tensor_type.shape().dim()) {
+    if (dim.has_dim_value()) {
+      key->push_back('v');
+      appendKeyPart(dim.dim_value(), key);
+    } else if (dim.has_dim_param()) {
+      key->push_back('p');
+      appendKeyPart(dim.dim_param(), key);
+    } else {
+      key->push_back('-');
+    }
+  }
+}
+
+bool sameTypes(const TypeProto& type, const TypeProto& otherType) {
+  std::string key, otherKey;
+  appendKeyPart(type, &key);
+  appendKeyPart(otherType, &otherKey);
+  return key == otherKey;
+}
+
+} // namespace
+
+bool InferenceCache::appendKey(
+    const OpSchema* schema,
+    const NodeProto& n,
+    const std::vector<const TypeProto*>& inputTypes,
+    std::string* key) {
+  for (const auto& attr : n.attribute()) {
+    if (attr.has_g() || attr.graphs_size() > 0) {
+      return false;
+    }
+  }
+  // The outputs inferred for a node depend on nothing but its schema, the
+  // number of its outputs, its attributes and the types of its inputs.
+  appendKeyPart(schema, key);
+  appendKeyPart(static_cast<uint32_t>(n.output_size()), key);
+  appendKeyPart(static_cast<uint32_t>(n.attribute_size()), key);
+  for (const auto& attr : n.attribute()) {
+    appendKeyPart(attr, key);
+  }
+  for (const auto* inputType : inputTypes) {
+    if (inputType) {
+      key->push_back('\1');
+      appendKeyPart(*inputType, key);
+    } else {
+      key->push_back('\0');
+    }
+  }
+  return true;
+}
+
+const std::vector<TypeProto>* InferenceCache::find(const std::string& key) {
+  auto iter = outputTypesByKey_.find(key);
+  if (iter == outputTypesByKey_.end()) {
+    ++misses_;
+    return nullptr;
+  }
+  ++hits_;
+  return &iter->second;
+}
+
+void InferenceCache::insert(
+    std::string key,
+    std::vector<TypeProto> outputTypes,
+    double seconds) {
+  outputTypesByKey_.emplace(std::move(key), std::move(outputTypes));
+  inferenceSeconds_ += seconds;
+}
+
+void InferShapes(ModelProto& m, InferenceCache* cache) {
+  std::unordered_map<std::string, int> opset_imports;
+  for (const auto& opset_import : m.opset_import()) {
+    opset_imports[opset_import.domain()] =
+        static_cast<int>(opset_import.version());
+  }
+
+  auto* g = m.mutable_graph();
+
+  std::unordered_map<std::string, TypeProto*> valueTypesByName;
+  for (auto& vi : *g->mutable_value_info()) {
+    valueTypesByName[vi.name()] = vi.mutable_type();
+  }
+  for (auto& vi : *g->mutable_input()) {
+    valueTypesByName[vi.name()] = vi.mutable_type();
+  }
+  for (auto& vi : *g->mutable_output()) {
+    valueTypesByName[vi.name()] = vi.mutable_type();
+  }
+
+  const OpSchemaTable schemas(opset_imports);
+  std::vector<const TypeProto*> inputTypes;
+  std::string key;
+  for (const auto& n : g->node()) {
+    const auto schema = schemas.Find(n.op_type(), n.domain());
+    if (!schema) {
+      continue;
+    }
+
+    bool cached = false;
+    if (cache) {
+      inputTypes.clear();
+      for (const auto& input : n.input()) {
+        auto iter = valueTypesByName.find(input);
+        inputTypes.push_back(
+            iter != valueTypesByName.end() ? iter->second : nullptr);
+      }
+      key.clear();
+      cached = InferenceCache::appendKey(schema, n, inputTypes, &key);
+      if (cached) {
+        if (const auto* outputTypes = cache->find(key)) {
+          mergeNodeOutputTypes(n, *outputTypes, g, valueTypesByName);
+          continue;
+        }
+      }
+    }
+
+    std::chrono::steady_clock::time_point start;
+    if (cached) {
+      start = std::chrono::steady_clock::now();
+    }
+    InferenceContextImpl ctx(n, valueTypesByName);
+    schema->GetTypeAndShapeInferenceFunction()(ctx);
+    if (cached) {
+      const std::chrono::duration<double> seconds =
+          std::chrono::steady_clock::now() - start;
+      cache->insert(key, ctx.allOutputTypes_, seconds.count());
+    }
+
+    mergeNodeOutputTypes(n, ctx.allOutputTypes_, g, valueTypesByName);
+  }
+}
+
+namespace {
+
+// The context of a node of a Graph, whose attributes are converted when
+// they are first read.
+struct GraphInferenceContext final : public InferenceContext {
+  GraphInferenceContext(
+      Node* n,
+      const std::vector<const TypeProto*>& inputTypes)
+    : node_(n), allInputTypes_(inputTypes) {
+    allOutputTypes_.resize(n->outputs().size());
+  }
+
+  const AttributeProto* getAttribute(const std::string& name) const override {
+    auto iter = attributesByName_.find(name);
+    if (iter != attributesByName_.end()) {
+      return iter->second;
+    }
+    const AttributeProto* attr = nullptr;
+    Symbol symbol(name);
+    if (node_->hasAttribute(symbol)) {
+      addAttribute(&attributes_, node_, symbol);
+      attr = &attributes_.attribute(attributes_.attribute_size() - 1);
+    }
+    attributesByName_[name] = attr;
+    return attr;
+  }
+  size_t getNumInputs() const override {
+    return allInputTypes_.size();
+  }
+
+  const TypeProto* getInputType(size_t index) const override {
+    if (index >= allInputTypes_.size()) {
+      throw std::runtime_error(
+          "input " + ONNX_NAMESPACE::to_string(index) + " is out of bounds");
+    }
+    return allInputTypes_[index];
+  }
+
+  size_t getNumOutputs() const override {
+    return allOutputTypes_.size();
+  }
+
+  TypeProto* getOutputType(size_t index) override {
+    if (index >= allOutputTypes_.size()) {
+      throw std::runtime_error(
+          "output " + ONNX_NAMESPACE::to_string(index) + " is out of bounds");
+    }
+    return &allOutputTypes_[index];
+  }
+
+ private:
+  Node* node_;
+  // the attributes read so far, which hold the converted ones
+  mutable NodeProto attributes_;
+  mutable std::unordered_map<std::string, const AttributeProto*> attributesByName_;
+  const std::vector<const TypeProto*>& allInputTypes_;
+  std::vector<TypeProto> allOutputTypes_;
+};
+
+} // namespace
+
+void InferShapes(Graph& graph) {
+  std::unordered_map<std::string, int> opset_imports;
+  for (const auto& opset : graph.opset_versions()) {
+    opset_imports[opset.domain()] = static_cast<int>(opset.version());
+  }
+
+  // The values which would have a type in the exported model: the inputs
+  // and outputs of graph, and the values with some type information.
+  std::unordered_set<const Value*> graphValues(
+      graph.outputs().begin(), graph.outputs().end());
+  auto hasType = [&graphValues](Value* v) {
+    return v->node()->kind() == kParam || graphValues.count(v) > 0 ||
+        v->elemType() != TensorProto::UNDEFINED || !v->sizes().empty();
+  };
+
+  // The types of the values read or inferred so far. Unlike the values,
+  // they tell a scalar from a value whose shape is not known, which empty
+  // sizes mean for the values computed by nodes.
+  std::unordered_map<const Value*, TypeProto> valueTypes;
+  auto typeOf = [&](Value* v) -> const TypeProto* {
+    auto it = valueTypes.find(v);
+    if (it != valueTypes.end()) {
+      return &it->second;
+    }
+    if (!hasType(v)) {
+      return nullptr;
+    }
+    auto* tensorType = valueTypes[v].mutable_tensor_type();
+    if (v->node()->kind() == kParam || graphValues.count(v) > 0 ||
+        !v->sizes().empty()) {
+      encodeTypeProtoTensorType(tensorType, v);
+    } else {
+      tensorType->set_elem_type(v->elemType());
+    }
+    return &valueTypes[v];
+  };
+
+  const OpSchemaTable schemas(opset_imports);
+  std::vector<const TypeProto*> inputTypes;
+  for (auto* n : graph.nodes()) {
+    if (n->kind() == kUndefined || n->kind() == kCaptured) {
+      continue;
+    }
+    const auto schema = schemas.Find(n->kind(), n->domain());
+    if (!schema) {
+      continue;
+    }
+
+    const size_t num_inputs = n->inputs().size();
+    inputTypes.assign(num_inputs, nullptr);
+    for (size_t i = 0; i < num_inputs; ++i) {
+      Value* v = n->inputs()[i];
+      if (v->node()->kind() != kUndefined) {
+        inputTypes[i] = typeOf(v);
+      }
+    }
+
+    GraphInferenceContext ctx(n, inputTypes);
+    schema->GetTypeAndShapeInferenceFunction()(ctx);
+
+    for (size_t i = 0; i < n->outputs().size(); ++i) {
+      const auto& inferredType = ctx.getOutputType(i)->tensor_type();
+
+      // Bail out early if shape inference does nothing useful.
+      if (inferredType.elem_type() == TensorProto::UNDEFINED && !inferredType.has_shape()) {
+        continue;
+      }
+
+      Value* v = n->outputs()[i];
+      TypeProto_Tensor existingType;
+      if (const TypeProto* type = typeOf(v)) {
+        existingType = type->tensor_type();
+        checkShapesAndTypes(inferredType, existingType);
+      }
+      mergeShapesAndTypes(inferredType, &existingType);
+
+      v->setElemType(existingType.elem_type());
+      v->setSizes(tensorShapeProtoToDimensions(existingType.shape()));
+      *valueTypes[v].mutable_tensor_type() = std::move(existingType);
+    }
+  }
+}
+
+IncrementalInference::IncrementalInference(ModelProto& m)
+    : g_(m.mutable_graph()) {
+  InferShapes(m);
+
+  std::unordered_map<std::string, int> opset_imports;
+  for (const auto& opset_import : m.opset_import()) {
+    opset_imports[opset_import.domain()] =
+        static_cast<int>(opset_import.version());
+  }
+  for (auto& vi : *g_->mutable_value_info()) {
+    valueTypesByName_[vi.name()] = vi.mutable_type();
+  }
+  for (auto& vi : *g_->mutable_input()) {
+    valueTypesByName_[vi.name()] = vi.mutable_type();
+    inputNames_.insert(vi.name());
+  }
+  for (auto& vi : *g_->mutable_output()) {
+    valueTypesByName_[vi.name()] = vi.mutable_type();
+    outputNames_.insert(vi.name());
+  }
+
+  const OpSchemaTable schemas(opset_imports);
+  schemas_.reserve(static_cast<size_t>(g_->node_size()));
+  for (int i = 0; i < g_->node_size(); ++i) {
+    const auto& n = g_->node(i);
+    schemas_.push_back(schemas.Find(n.op_type(), n.domain()));
+    if (!schemas_.back()) {
+      continue;
+    }
+    for (const auto& input : n.input()) {
+      auto& consumers = consumersByName_[input];
+      if (consumers.empty() || consumers.back() != i) {
+        consumers.push_back(i);
+      }
+    }
+  }
+  queued_.assign(schemas_.size(), false);
+}
+
+void IncrementalInference::setValueType(
+    const std::string& name,
+    const TypeProto& type) {
+  auto iter = valueTypesByName_.find(name);
+  TypeProto* existingType =
+      iter != valueTypesByName_.end() ? iter->second : nullptr;
+  const bool isGraphValue =
+      inputNames_.count(name) > 0 || outputNames_.count(name) > 0;
+
+  TypeProto newType = type;
+  if (existingType && outputNames_.count(name) > 0 &&
+      existingType->has_tensor_type() &&
+      newType.tensor_type().elem_type() == TensorProto::UNDEFINED) {
+    newType.mutable_tensor_type()->set_elem_type(
+        existingType->tensor_type().elem_type());
+  }
+  const bool isKnown = newType.has_tensor_type()
+      ? newType.tensor_type().elem_type() != TensorProto::UNDEFINED ||
+          newType.tensor_type().has_shape()
+      : newType.value_case() != TypeProto::VALUE_NOT_SET;
+
+  // The nodes reading the value are only re-inferred if its type changes.
+  if (existingType ? sameTypes(*existingType, newType) : !isKnown) {
+    return;
+  }
+  if (existingType && (isKnown || isGraphValue)) {
+    *existingType = std::move(newType);
+  } else if (existingType) {
+    valueTypesByName_.erase(iter);
+    removedValueInfos_.insert(name);
+  } else {
+    auto* vi = g_->add_value_info();
+    vi->set_name(name);
+    *vi->mutable_type() = std::move(newType);
+    valueTypesByName_[name] = vi->mutable_type();
+  }
+
+  auto consumers = consumersByName_.find(name);
+  if (consumers == consumersByName_.end()) {
+    return;
+  }
+  for (int i : consumers->second) {
+    if (!queued_[static_cast<size_t>(i)]) {
+      queued_[static_cast<size_t>(i)] = true;
+      queue_.push_back(i);
+      std::push_heap(queue_.begin(), queue_.end(), std::greater<int>());
+    }
+  }
+}
+
+size_t IncrementalInference::updateInputTypes(
+    const std::unordered_map<std::string, TypeProto>& inputTypes) {
+  for (const auto& input : inputTypes) {
+    if (inputNames_.count(input.first) == 0) {
+      throw std::runtime_error(input.first + " is not an input of the graph");
+    }
+  }
+  for (const auto& input : inputTypes) {
+    setValueType(input.first, input.second);
+  }
+
+  // The nodes are re-inferred in order, so that a node is re-inferred once
+  // all the values it reads are up to date. A node leaves the queue only
+  // once it is re-inferred.
+  size_t num_reinferred = 0;
+  while (!queue_.empty()) {
+    const int i = queue_.front();
+    const auto& n = g_->node(i);
+    InferenceContextImpl ctx(n, valueTypesByName_);
+    try {
+      schemas_[static_cast<size_t>(i)]->GetTypeAndShapeInferenceFunction()(ctx);
+    } catch (...) {
+      removeValueInfos();
+      throw;
+    }
+    std::pop_heap(queue_.begin(), queue_.end(), std::greater<int>());
+    queue_.pop_back();
+    queued_[static_cast<size_t>(i)] = false;
+    ++num_reinferred;
+    for (int j = 0; j < n.output_size(); ++j) {
+      setValueType(n.output(j), ctx.allOutputTypes_[static_cast<size_t>(j)]);
+    }
+  }
+
+  removeValueInfos();
+  return num_reinferred;
+}
+
+void IncrementalInference::removeValueInfos() {
+  if (removedValueInfos_.empty()) {
+    return;
+  }
+  // Swapping the elements of a repeated field moves no element, so the
+  // types of the value_info which are kept stay where they are.
+  auto* valueInfos = g_->mutable_value_info();
+  int numKept = 0;
+  for (int i = 0; i < valueInfos->size(); ++i) {
+    if (removedValueInfos_.count(valueInfos->Get(i).name()) == 0) {
+      valueInfos->SwapElements(numKept++, i);
+    }
+  }
+  valueInfos->DeleteSubrange(numKept, valueInfos->size() - numKept);
+  removedValueInfos_.clear();
+}
+
+} // namespace shape_inference
+} // namespace ONNX_NAMESPACE
@@ -1,5 +1,8 @@
 #pragma once
 
+#include <unordered_set>
+
+#include "onnx/common/ir.h"
 #include "onnx/defs/schema.h"
 #include "onnx/proto_utils.h"
 #include "onnx/string_utils.h"
@@ -63,153 +66,132 @@ struct InferenceContextImpl : public InferenceContext {
   std::vector<TypeProto> allOutputTypes_;
 };
 
+// Throws if the inferred type and shape of a value conflict with its
+// existing ones.
 void checkShapesAndTypes(
     const TypeProto_Tensor& inferredType,
-    const TypeProto_Tensor& existingType) {
-  if (inferredType.elem_type() != TensorProto::UNDEFINED &&
-      existingType.elem_type() != TensorProto::UNDEFINED &&
-      existingType.elem_type() != inferredType.elem_type()) {
-    std::stringstream ss;
-    ss << "Inferred elem type differs from existing elem type: ("
-       << inferredType.elem_type()
-       << ") vs ("
-       << existingType.elem_type()
-       << ")";
-    throw std::runtime_error(ss.str());
-  }
-
-  if (!inferredType.has_shape() || !existingType.has_shape()) {
-    return;
-  }
-
-  if (inferredType.shape().dim_size() != existingType.shape().dim_size()) {
-    std::stringstream ss;
-    ss << "Inferred shape and existing shape differ in rank: ("
-       << inferredType.shape().dim_size()
-       << ") vs ("
-       << existingType.shape().dim_size()
-       << ")";
-    throw std::runtime_error(ss.str());
-  }
-
-  for (int i = 0; i < inferredType.shape().dim_size(); ++i) {
-    const auto& inferredDim = inferredType.shape().dim(i);
-    const auto& existingDim = existingType.shape().dim(i);
-    if (inferredDim.has_dim_value() &&
-        existingDim.has_dim_value() &&
-        inferredDim.dim_value() != existingDim.dim_value()) {
-      std::stringstream ss;
-      ss << "Inferred shape and existing shape differ in dimension "
-         << i
-         << ": ("
-         << inferredDim.dim_value()
-         << ") vs ("
-         << existingDim.dim_value()
-         << ")";
-      throw std::runtime_error(ss.str());
-    }
-  }
-}
+    const TypeProto_Tensor& existingType);
 
+// Fills in the existing type and shape of a value with the inferred ones.
 void mergeShapesAndTypes(
     const TypeProto_Tensor& inferredType,
-    TypeProto_Tensor* existingType) {
-  if (inferredType.elem_type() != TensorProto::UNDEFINED &&
-      existingType->elem_type() == TensorProto::UNDEFINED) {
-    existingType->set_elem_type(inferredType.elem_type());
-  }
-
-  if (!inferredType.has_shape()) {
-    return;
-  }
-
-  if (!existingType->has_shape()) {
-    // Ensure the shape is initialized. Note that this must be done
-    // even for (zero-dimensional) scalars.
-    existingType->mutable_shape();
-
-    for (int j = 0; j < inferredType.shape().dim_size(); ++j) {
-      existingType->mutable_shape()->add_dim();
-    }
-  }
-
-  for (int i = 0; i < inferredType.shape().dim_size(); ++i) {
-    const auto& inferredDim = inferredType.shape().dim(i);
-    auto* existingDim = existingType->mutable_shape()->mutable_dim(i);
-    if (!existingDim->has_dim_value()) {
-      *existingDim = inferredDim;
-    }
-  }
-}
-
-void InferShapes(ModelProto& m) {
-  std::unordered_map<std::string, int> opset_imports;
-  for (const auto& opset_import : m.opset_import()) {
-    opset_imports[opset_import.domain()] =
-        static_cast<int>(opset_import.version());
-  }
-
-  auto* g = m.mutable_graph();
-
-  std::unordered_map<std::string, TypeProto*> valueTypesByName;
-  for (auto& vi : *g->mutable_value_info()) {
-    valueTypesByName[vi.name()] = vi.mutable_type();
-  }
-  for (auto& vi : *g->mutable_input()) {
-    valueTypesByName[vi.name()] = vi.mutable_type();
-  }
-  for (auto& vi : *g->mutable_output()) {
-    valueTypesByName[vi.name()] = vi.mutable_type();
-  }
-
-  for (const auto& n : g->node()) {
-    // Resolve domain for node
-    auto dit = opset_imports.find(n.domain());
-    if (dit == opset_imports.end()) {
-      continue;
-    }
-    auto domain_version = dit->second;
-
-    const auto schema =
-        OpSchemaRegistry::Schema(n.op_type(), domain_version, n.domain());
-    if (!schema) {
-      continue;
-    }
-
-    InferenceContextImpl ctx(n, valueTypesByName);
-    schema->GetTypeAndShapeInferenceFunction()(ctx);
-
-    for (int i = 0; i < n.output_size(); ++i) {
-      const auto& inferredType = ctx.getOutputType(i)->tensor_type();
-
-      // Bail out early if shape inference does nothing useful.
-      if (inferredType.elem_type() == TensorProto::UNDEFINED && !inferredType.has_shape()) {
-        continue;
-      }
-
-      // Find any pre-existing type and shape info. If there is such,
-      // then check for compatability with the inferred
-      // information. Otherwise, initialize it in an empty state.
-      auto iter = valueTypesByName.find(n.output(i));
-      TypeProto* existingType = nullptr;
-      if (iter != valueTypesByName.end()) {
-        existingType = iter->second;
-        checkShapesAndTypes(inferredType, existingType->tensor_type());
-      } else {
-        auto vi = g->add_value_info();
-        vi->set_name(n.output(i));
-        existingType = vi->mutable_type();
-      }
-
-      // Now we can merge pre-existing and inferred info, without
-      // further need for error-checking.
-      mergeShapesAndTypes(inferredType, existingType->mutable_tensor_type());
+    TypeProto_Tensor* existingType);
+
+// Checks the types and shapes inferred for the outputs of n against their
+// existing ones, and merges them into g, adding value_info if needed.
+void mergeNodeOutputTypes(
+    const NodeProto& n,
+    const std::vector<TypeProto>& inferredTypes,
+    GraphProto* g,
+    std::unordered_map<std::string, TypeProto*>& valueTypesByName);
+
+// Memoizes the types and shapes inferred for the outputs of nodes, keyed on
+// their schema, attributes and input types, so that the blocks a model
+// repeats are inferred once. A cache can be reused by the inference of
+// several models, but not concurrently.
+class InferenceCache final {
+ public:
+  // Appends the key of node n of the given schema and input types, where
+  // unknown types are null, to key. Returns false if n is not cached, as
+  // it has nested graphs.
+  static bool appendKey(
+      const OpSchema* schema,
+      const NodeProto& n,
+      const std::vector<const TypeProto*>& inputTypes,
+      std::string* key);
+
+  // Returns the output types cached for key, or null.
+  const std::vector<TypeProto>* find(const std::string& key);
+
+  // Caches the output types inferred for key, which took seconds to infer.
+  void insert(
+      std::string key,
+      std::vector<TypeProto> outputTypes,
+      double seconds);
+
+  // The number of nodes found in the cache, and not found in it.
+  size_t hits() const {
+    return hits_;
+  }
+  size_t misses() const {
+    return misses_;
+  }
+  double hitRate() const {
+    return hits_ + misses_ > 0
+        ? static_cast<double>(hits_) / static_cast<double>(hits_ + misses_)
+        : 0;
+  }
+  // An estimate of the time saved by the hits: the average time taken to
+  // infer the misses, for each of them.
+  double savedSeconds() const {
+    return misses_ > 0 ? inferenceSeconds_ * static_cast<double>(hits_) /
+            static_cast<double>(misses_)
+                       : 0;
+  }
+
+ private:
+  std::unordered_map<std::string, std::vector<TypeProto>> outputTypesByKey_;
+  size_t hits_ = 0;
+  size_t misses_ = 0;
+  double inferenceSeconds_ = 0;
+};
 
-      // Make merged info available to futher inference.
-      valueTypesByName[n.output(i)] = existingType;
-    }
-  }
-}
+// Infers the types and shapes of the values of the main graph of m, adding
+// them to its value_info. The outputs of the nodes are looked up in cache
+// and added to it when set.
+void InferShapes(ModelProto& m, InferenceCache* cache = nullptr);
+
+// Infers the types and shapes of the values of graph, setting them on the
+// values, like InferShapes does for the model graph exports to. Empty sizes
+// of the values computed by nodes are taken as a shape which is not known.
+void InferShapes(Graph& graph);
+
+// Infers the types and shapes of the values of the main graph of a model,
+// and re-infers them when the types of some of its inputs change, e.g. to
+// specialize it for another batch size. Only the nodes which read a value
+// whose type changed are re-inferred, so the cost of an update is
+// proportional to the part of the graph it affects. The model must outlive
+// this, and not be modified but through it.
+class IncrementalInference final {
+ public:
+  // Infers the types and shapes of the values of m like InferShapes, and
+  // indexes its graph for updates.
+  explicit IncrementalInference(ModelProto& m);
+
+  // Sets the types of the inputs of the graph named in inputTypes, and
+  // re-infers the nodes which depend on them. The types inferred for the
+  // outputs of those nodes replace the ones inferred before: the value_info
+  // of the values of which nothing is inferred anymore is removed, but the
+  // outputs of the graph keep their element type. Returns the number of
+  // nodes re-inferred.
+  //
+  // Nothing is changed if a name is not that of an input. If an inference
+  // function throws, the graph keeps the types set and re-inferred so far,
+  // and the node which threw and the nodes not re-inferred yet stay queued,
+  // so that the next call re-infers them.
+  size_t updateInputTypes(
+      const std::unordered_map<std::string, TypeProto>& inputTypes);
+
+ private:
+  // Sets the type of the value named name, and queues the nodes which read
+  // it, if type differs from its current one.
+  void setValueType(const std::string& name, const TypeProto& type);
+
+  // Removes from the graph the value_info named in removedValueInfos_.
+  void removeValueInfos();
+
+  GraphProto* g_;
+  std::unordered_map<std::string, TypeProto*> valueTypesByName_;
+  std::unordered_set<std::string> inputNames_;
+  std::unordered_set<std::string> outputNames_;
+  // the schema of each node, and the nodes reading each value
+  std::vector<const OpSchema*> schemas_;
+  std::unordered_map<std::string, std::vector<int>> consumersByName_;
+  // the nodes to re-infer, smallest index first, which is their order
+  std::vector<int> queue_;
+  std::vector<bool> queued_;
+  std::unordered_set<std::string> removedValueInfos_;
+};
 
 } // namespace shape_inference
 } // namespace ONNX_NAMESPACE
@@ -119,6 +119,32 @@ class TestChecker(unittest.TestCase):
 
         checker.check_model(model)
 
+    def test_check_model_threads(self):
+        def make_model(bad_attribute, bad_input):
+            nodes = []
+            last = "X"
+            for i in range(100):
+                kwargs = {"foo": 1} if i == bad_attribute else {}
+                nodes.append(helper.make_node(
+                    "Relu", ["Z" if i == bad_input else last], ["Y" + str(i)], **kwargs))
+                last = "Y" + str(i)
+            graph = helper.make_graph(
+                nodes,
+                "test",
+                [helper.make_tensor_value_info("X", TensorProto.FLOAT, [1, 2])],
+                [helper.make_tensor_value_info(last, TensorProto.FLOAT, [1, 2])])
+            return helper.make_model(graph, producer_name='test')
+
+        for num_threads in [0, 1, 4]:
+            checker.check_model(make_model(-1, -1), num_threads)
+            # the error of the first bad node is reported
+            with self.assertRaises(checker.ValidationError) as cm:
+                checker.check_model(make_model(30, 60), num_threads)
+            assert "Unrecognized attribute: foo" in str(cm.exception)
+            with self.assertRaises(checker.ValidationError) as cm:
+                checker.check_model(make_model(60, 30), num_threads)
+            assert "topologically sorted" in str(cm.exception)
+
     def test_check_old_model(self):
         node = helper.make_node(
             "Pad", ["X"], ["Y"], paddings=(0, 0, 0, 0))
@@ -139,6 +165,85 @@ class TestChecker(unittest.TestCase):
         tensor.raw_data = np.random.randn(2, 3).astype(np.float32).tobytes()
         self.assertRaises(checker.ValidationError, checker.check_tensor, tensor)
 
+    def test_check_tensor_raw_data_size(self):
+        tensor = TensorProto()
+        tensor.name = 'test'
+        tensor.data_type = TensorProto.FLOAT
+        tensor.dims.extend([2, 3])
+        tensor.raw_data = np.random.randn(2, 3).astype(np.float32).tobytes()
+        checker.check_tensor(tensor)
+
+        # the raw data must hold exactly the elements of the tensor
+        tensor.raw_data = np.random.randn(2, 2).astype(np.float32).tobytes()
+        self.assertRaises(checker.ValidationError, checker.check_tensor, tensor)
+
+    def test_check_tensor_metadata(self):
+        tensor = TensorProto()
+        tensor.name = 'test'
+        tensor.data_type = TensorProto.FLOAT
+        tensor.dims.extend([2, 3])
+        checker.check_tensor_metadata(tensor, 24)
+
+        # the raw data must hold exactly the elements of the tensor
+        self.assertRaises(checker.ValidationError, checker.check_tensor_metadata, tensor, 20)
+        # and nothing else may hold them
+        tensor.float_data.extend([1, 2, 3, 4, 5, 6])
+        self.assertRaises(checker.ValidationError, checker.check_tensor_metadata, tensor, 24)
+
+    def _check_non_finite_offset(self, tensor, raw_data, offset):
+        for chunk_size in [1, 6, 64, 1000, 1 << 24]:
+            for num_threads in [1, 3, 4]:
+                with self.assertRaises(checker.ValidationError) as cm:
+                    checker.check_tensor_finite(tensor, raw_data, chunk_size=chunk_size,
+                                                num_threads=num_threads)
+                assert 'at byte {} of'.format(offset) in str(cm.exception)
+
+    def test_check_tensor_finite(self):
+        data = np.ones(1000, dtype=np.float32)
+        tensor = TensorProto()
+        tensor.name = 'test'
+        tensor.data_type = TensorProto.FLOAT
+        tensor.dims.append(1000)
+        checker.check_tensor_finite(tensor, data.tobytes())
+        checker.check_tensor_finite(tensor, data.tobytes(), chunk_size=64, num_threads=4)
+
+        # the first NaN or infinity is reported
+        data[900] = np.nan
+        data[700] = np.inf
+        self._check_non_finite_offset(tensor, data.tobytes(), 700 * 4)
+
+        self.assertRaises(checker.ValidationError, checker.check_tensor_finite,
+                          tensor, data[:999].tobytes())
+        tensor.float_data.append(1)
+        self.assertRaises(checker.ValidationError, checker.check_tensor_finite,
+                          tensor, data.tobytes())
+
+    def test_check_tensor_finite_float16(self):
+        data = np.full(100, 65504, dtype=np.float16)
+        tensor = TensorProto()
+        tensor.data_type = TensorProto.FLOAT16
+        tensor.dims.extend([10, 10])
+        checker.check_tensor_finite(tensor, data.tobytes())
+
+        data[37] = -np.inf
+        self._check_non_finite_offset(tensor, data.tobytes(), 37 * 2)
+
+    def test_check_tensor_finite_complex(self):
+        data = np.ones(100, dtype=np.complex64)
+        tensor = TensorProto()
+        tensor.data_type = TensorProto.COMPLEX64
+        tensor.dims.append(100)
+        checker.check_tensor_finite(tensor, data.tobytes())
+
+        # the imaginary part of an element
+        data[42] = complex(1, np.nan)
+        self._check_non_finite_offset(tensor, data.tobytes(), 42 * 8 + 4)
+
+        tensor.data_type = TensorProto.COMPLEX128
+        data = np.ones(100, dtype=np.complex128)
+        data[42] = complex(np.inf, 1)
+        self._check_non_finite_offset(tensor, data.tobytes(), 42 * 16)
+
     def test_check_string_tensor(self):
         tensor = TensorProto()
         tensor.data_type = TensorProto.STRING
@@ -188,6 +293,41 @@ class TestChecker(unittest.TestCase):
         checker.check_graph(graph)
         #self.assertRaises(checker.ValidationError, checker.check_graph, graph)
 
+    def test_nested_graph_scope(self):
+        def make_graph(branch_nodes):
+            branch = helper.make_graph(
+                branch_nodes,
+                "branch",
+                inputs=[],
+                outputs=[
+                    helper.make_tensor_value_info("Z", TensorProto.FLOAT, [1, 2])
+                ]
+            )
+            return helper.make_graph(
+                [helper.make_node("Relu", ["X"], ["Y"]),
+                 helper.make_node(
+                     "If", ["cond"], ["W"], then_branch=branch, else_branch=branch),
+                 helper.make_node("Relu", ["W"], ["V"])],
+                "test",
+                inputs=[
+                    helper.make_tensor_value_info("cond", TensorProto.BOOL, [1]),
+                    helper.make_tensor_value_info("X", TensorProto.FLOAT, [1, 2])
+                ],
+                outputs=[
+                    helper.make_tensor_value_info("V", TensorProto.FLOAT, [1, 2])
+                ],
+            )
+
+        # the branches read values of the outer graph defined before the If
+        checker.check_graph(make_graph([helper.make_node("Add", ["X", "Y"], ["Z"])]))
+        # but not the values defined after it
+        self.assertRaises(checker.ValidationError, checker.check_graph,
+                          make_graph([helper.make_node("Add", ["X", "V"], ["Z"])]))
+        # and they cannot redefine the values of the outer graph
+        self.assertRaises(checker.ValidationError, checker.check_graph,
+                          make_graph([helper.make_node("Relu", ["X"], ["Y"]),
+                                      helper.make_node("Relu", ["Y"], ["Z"])]))
+
 
 if __name__ == '__main__':
     unittest.main()
@@ -0,0 +1,90 @@
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+from __future__ import unicode_literals
+
+from onnx import helper, TensorProto
+from onnx.helper import make_node, make_tensor_value_info
+
+import onnx.cost
+import unittest
+
+
+class TestCost(unittest.TestCase):
+    def _estimated(self, nodes, inputs, outputs):
+        graph = helper.make_graph(
+            nodes,
+            "test",
+            [make_tensor_value_info(name, TensorProto.FLOAT, shape) for name, shape in inputs],
+            [make_tensor_value_info(name, TensorProto.FLOAT, shape) for name, shape in outputs])
+        model = helper.make_model(graph, producer_name='onnx-test')
+        return onnx.cost.estimate_cost(model)
+
+    def test_conv(self):
+        cost = self._estimated(
+            [make_node('Conv', ['X', 'W', 'B'], ['Y'], pads=[1, 1, 1, 1])],
+            [('X', (1, 4, 8, 8)), ('W', (4, 4, 3, 3)), ('B', (4,))],
+            [('Y', (1, 4, 8, 8))])
+        # a dot product of 4 * 3 * 3 elements plus the bias per output
+        assert cost.nodes[0].cost == onnx.cost.OpCost(
+            2 * 256 * 36 + 256, 4 * (256 + 144 + 4), 4 * 256)
+        assert cost.total == cost.nodes[0].cost
+        assert cost.num_unknown == 0
+
+    def test_gemm(self):
+        cost = self._estimated(
+            [make_node('Gemm', ['A', 'B', 'C'], ['Y'], transB=1)],
+            [('A', (2, 3)), ('B', (4, 3)), ('C', (2, 4))],
+            [('Y', (2, 4))])
+        assert cost.nodes[0].cost == onnx.cost.OpCost(
+            2 * 2 * 4 * 3 + 2 * 2 * 4, 4 * (6 + 12 + 8), 4 * 8)
+
+    def test_matmul(self):
+        cost = self._estimated(
+            [make_node('MatMul', ['A', 'B'], ['Y'])],
+            [('A', (5, 2, 3)), ('B', (3, 4))],
+            [('Y', (5, 2, 4))])
+        assert cost.nodes[0].cost == onnx.cost.OpCost(
+            2 * 5 * 2 * 4 * 3, 4 * (30 + 12), 4 * 40)
+
+    def test_pool_and_reduce(self):
+        cost = self._estimated(
+            [make_node('MaxPool', ['X'], ['Y'], kernel_shape=[2, 2], strides=[2, 2]),
+             make_node('GlobalAveragePool', ['X'], ['Z']),
+             make_node('ReduceSum', ['Y'], ['S'], axes=[2, 3]),
+             make_node('ArgMax', ['X'], ['I'], axis=1)],
+            [('X', (1, 4, 8, 8))],
+            [('Z', (1, 4, 1, 1)), ('S', (1, 4, 1, 1))])
+        assert [n.cost for n in cost.nodes] == [
+            onnx.cost.OpCost(64 * 4, 4 * 256, 4 * 64),
+            onnx.cost.OpCost(256, 4 * 256, 4 * 4),
+            onnx.cost.OpCost(64, 4 * 64, 4 * 4),
+            # the indices are int64
+            onnx.cost.OpCost(256, 4 * 256, 8 * 64)]
+
+    def test_lstm(self):
+        cost = self._estimated(
+            [make_node('LSTM', ['X', 'W', 'R'], ['Y', 'Y_h', ''], hidden_size=6)],
+            [('X', (5, 2, 3)), ('W', (1, 24, 3)), ('R', (1, 24, 6))],
+            [('Y', (5, 1, 2, 6)), ('Y_h', (1, 2, 6))])
+        # 4 gates of 6 for 5 steps of a batch of 2
+        assert cost.nodes[0].cost == onnx.cost.OpCost(
+            5 * 2 * 24 * (2 * (3 + 6) + 1), 4 * (30 + 72 + 144), 4 * (60 + 12))
+
+    def test_elementwise_and_unknown(self):
+        cost = self._estimated(
+            [make_node('Abs', ['X'], ['Y']),
+             make_node('Sum', ['X', 'X', 'X'], ['Z']),
+             # the shape of Y is not inferred
+             make_node('Mul', ['Y', 'X'], ['T'])],
+            [('X', (2, 3))],
+            [('T', (2, 3))])
+        assert cost.nodes[0].cost == onnx.cost.OpCost(6, 24, 24)
+        assert cost.nodes[1].cost == onnx.cost.OpCost(12, 72, 24)
+        assert cost.nodes[2].cost == onnx.cost.OpCost(-1, -1, -1)
+        assert cost.total == onnx.cost.OpCost(18, 96, 48)
+        assert cost.num_unknown == 1
+
+
+if __name__ == '__main__':
+    unittest.main()
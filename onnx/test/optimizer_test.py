@@ -7,6 +7,7 @@ from onnx import checker, helper, TensorProto
 
 import numpy as np  # type: ignore
 
+import onnx.fused_elementwise
 import onnx.optimizer
 import unittest
 
@@ -392,6 +393,651 @@ class TestOptimizer(unittest.TestCase):
         assert optimized_model.graph.node[0].op_type == 'Conv'
         assert optimized_model.graph.node[1].op_type == 'Add'
 
+    def test_fuse_matmul_add_bias_into_gemm(self):
+        matmul = helper.make_node("MatMul", ["X", "Y"], ["Z"])
+        add = helper.make_node("Add", ["Z", "B"], ["A"], broadcast=1)
+        graph = helper.make_graph(
+            [matmul, add],
+            "test",
+            [helper.make_tensor_value_info("X", TensorProto.FLOAT, (32, 10)),
+             helper.make_tensor_value_info("Y", TensorProto.FLOAT, (10, 16)),
+             helper.make_tensor_value_info("B", TensorProto.FLOAT, (16,))],
+            [helper.make_tensor_value_info("A", TensorProto.FLOAT, (32, 16))]
+        )
+        optimized_model = self._optimized(graph, ["fuse_matmul_add_bias_into_gemm"])
+
+        assert len(list(optimized_model.graph.node)) == 1
+        assert optimized_model.graph.node[0].op_type == "Gemm"
+        assert list(optimized_model.graph.node[0].input) == ["X", "Y", "B"]
+        assert optimized_model.graph.output[0].name == "A"
+
+    def test_fuse_matmul_add_bias_into_gemm_3d_no_fuse(self):
+        matmul = helper.make_node("MatMul", ["X", "Y"], ["Z"])
+        add = helper.make_node("Add", ["Z", "B"], ["A"], broadcast=1)
+        graph = helper.make_graph(
+            [matmul, add],
+            "test",
+            [helper.make_tensor_value_info("X", TensorProto.FLOAT, (2, 32, 10)),
+             helper.make_tensor_value_info("Y", TensorProto.FLOAT, (2, 10, 16)),
+             helper.make_tensor_value_info("B", TensorProto.FLOAT, (16,))],
+            [helper.make_tensor_value_info("A", TensorProto.FLOAT, (2, 32, 16))]
+        )
+        optimized_model = self._optimized(graph, ["fuse_matmul_add_bias_into_gemm"])
+
+        assert len(list(optimized_model.graph.node)) == 2
+        assert optimized_model.graph.node[0].op_type == "MatMul"
+        assert optimized_model.graph.node[1].op_type == "Add"
+
+    def test_fold_transpose_into_weights(self):
+        weight = np.random.randn(16, 10).astype(np.float32)
+        nodes = [helper.make_node("Gemm", ["X", "W", "B"], ["Z"], broadcast=1, transB=1),
+                 helper.make_node("Transpose", ["V"], ["VT"], perm=[1, 0]),
+                 helper.make_node("MatMul", ["Z", "VT"], ["A"])]
+        graph = helper.make_graph(
+            nodes,
+            "test",
+            [helper.make_tensor_value_info("X", TensorProto.FLOAT, (32, 10)),
+             helper.make_tensor_value_info("W", TensorProto.FLOAT, (16, 10)),
+             helper.make_tensor_value_info("B", TensorProto.FLOAT, (16,)),
+             helper.make_tensor_value_info("V", TensorProto.FLOAT, (8, 16))],
+            [helper.make_tensor_value_info("A", TensorProto.FLOAT, (32, 8))],
+            initializer=[helper.make_tensor("W", TensorProto.FLOAT, (16, 10),
+                                            weight.flatten().tolist()),
+                         helper.make_tensor("V", TensorProto.FLOAT, (8, 16),
+                                            np.ones((8, 16)).flatten().tolist())]
+        )
+        optimized_model = self._optimized(graph, ["fold_transpose_into_weights"])
+
+        assert len(list(optimized_model.graph.node)) == 2
+        assert optimized_model.graph.node[0].op_type == "Gemm"
+        assert "transB" not in [a.name for a in optimized_model.graph.node[0].attribute]
+        assert optimized_model.graph.node[1].op_type == "MatMul"
+        assert list(optimized_model.graph.node[1].input) == ["Z", "V"]
+        initializers = {t.name: t for t in optimized_model.graph.initializer}
+        assert list(initializers["W"].dims) == [10, 16]
+        assert list(initializers["V"].dims) == [16, 8]
+        np.testing.assert_equal(
+            np.array(initializers["W"].float_data).reshape(10, 16), weight.T)
+
+    def test_sink_transposes_cancel(self):
+        nodes = [helper.make_node("Transpose", ["X"], ["T1"], perm=[0, 2, 3, 1]),
+                 helper.make_node("Relu", ["T1"], ["R"]),
+                 helper.make_node("Add", ["R", "B"], ["A"], broadcast=1),
+                 helper.make_node("Transpose", ["Z"], ["T2"], perm=[0, 2, 3, 1]),
+                 helper.make_node("Concat", ["A", "T2"], ["C"], axis=3),
+                 helper.make_node("Transpose", ["C"], ["O"], perm=[0, 3, 1, 2])]
+        graph = helper.make_graph(
+            nodes,
+            "test",
+            [helper.make_tensor_value_info("X", TensorProto.FLOAT, (1, 3, 4, 5)),
+             helper.make_tensor_value_info("Z", TensorProto.FLOAT, (1, 2, 4, 5)),
+             helper.make_tensor_value_info("B", TensorProto.FLOAT, (3,))],
+            [helper.make_tensor_value_info("O", TensorProto.FLOAT, (1, 5, 4, 5))],
+            initializer=[helper.make_tensor("B", TensorProto.FLOAT, (3,), [1, 2, 3])])
+        optimized_model = self._optimized(graph, ["sink_transposes"])
+
+        assert [n.op_type for n in optimized_model.graph.node] == ["Relu", "Add", "Concat"]
+        assert optimized_model.graph.node[1].attribute[1].name == "axis"
+        assert optimized_model.graph.node[1].attribute[1].i == 1
+        assert optimized_model.graph.node[2].attribute[0].i == 1
+        assert optimized_model.graph.output[0].name == "O"
+
+    def test_sink_transposes_constant(self):
+        nodes = [helper.make_node("Transpose", ["X"], ["T1"], perm=[1, 0]),
+                 helper.make_node("Mul", ["T1", "C"], ["M"]),
+                 helper.make_node("Relu", ["M"], ["O"])]
+        graph = helper.make_graph(
+            nodes,
+            "test",
+            [helper.make_tensor_value_info("X", TensorProto.FLOAT, (2, 3)),
+             helper.make_tensor_value_info("C", TensorProto.FLOAT, (3, 2))],
+            [helper.make_tensor_value_info("O", TensorProto.FLOAT, (3, 2))],
+            initializer=[helper.make_tensor("C", TensorProto.FLOAT, (3, 2),
+                                            [1, 2, 3, 4, 5, 6])])
+        optimized_model = self._optimized(graph, ["sink_transposes"])
+
+        assert [n.op_type for n in optimized_model.graph.node] == ["Mul", "Relu", "Transpose"]
+        assert list(optimized_model.graph.initializer[0].dims) == [2, 3]
+        assert list(optimized_model.graph.initializer[0].float_data) == [1, 3, 5, 2, 4, 6]
+        assert optimized_model.graph.output[0].name == "O"
+
+    def test_sink_transposes_element_type(self):
+        # Transpose only takes floating point tensors, so it is not sunk
+        # below ops with a bool or integer output
+        nodes = [helper.make_node("Transpose", ["X"], ["T1"], perm=[1, 0]),
+                 helper.make_node("Greater", ["T1", "C"], ["G"]),
+                 helper.make_node("Not", ["G"], ["N"]),
+                 helper.make_node("Transpose", ["X"], ["T2"], perm=[1, 0]),
+                 helper.make_node("Cast", ["T2"], ["K"], to=TensorProto.INT32)]
+        graph = helper.make_graph(
+            nodes,
+            "test",
+            [helper.make_tensor_value_info("X", TensorProto.FLOAT, (2, 3)),
+             helper.make_tensor_value_info("C", TensorProto.FLOAT, (3, 2))],
+            [helper.make_tensor_value_info("N", TensorProto.BOOL, (3, 2)),
+             helper.make_tensor_value_info("K", TensorProto.INT32, (3, 2))],
+            initializer=[helper.make_tensor("C", TensorProto.FLOAT, (3, 2),
+                                            [1, 2, 3, 4, 5, 6])])
+        optimized_model = self._optimized(graph, ["sink_transposes"])
+
+        assert [n.op_type for n in optimized_model.graph.node] == \
+            ["Transpose", "Greater", "Not", "Transpose", "Cast"]
+        assert list(optimized_model.graph.initializer[0].float_data) == [1, 2, 3, 4, 5, 6]
+
+    def test_fuse_consecutive_reshapes(self):
+        nodes = [helper.make_node("Flatten", ["X"], ["F"], axis=1),
+                 helper.make_node("Unsqueeze", ["F"], ["U"], axes=[0]),
+                 helper.make_node("Squeeze", ["U"], ["S"], axes=[0]),
+                 helper.make_node("Relu", ["S"], ["Y"])]
+        graph = helper.make_graph(
+            nodes,
+            "test",
+            [helper.make_tensor_value_info("X", TensorProto.FLOAT, (2, 3, 4, 5))],
+            [helper.make_tensor_value_info("Y", TensorProto.FLOAT, (2, 60))],
+            value_info=[helper.make_tensor_value_info("S", TensorProto.FLOAT, (2, 60))])
+        optimized_model = self._optimized(graph, ["fuse_consecutive_reshapes"])
+
+        assert [n.op_type for n in optimized_model.graph.node] == ["Constant", "Reshape", "Relu"]
+        assert list(optimized_model.graph.node[0].attribute[0].t.int64_data) == [2, 60]
+        assert list(optimized_model.graph.node[1].input) == ["X", optimized_model.graph.node[0].output[0]]
+
+    def test_fuse_consecutive_reshapes_identity(self):
+        nodes = [helper.make_node("Relu", ["X"], ["R"]),
+                 helper.make_node("Unsqueeze", ["R"], ["U"], axes=[0]),
+                 helper.make_node("Squeeze", ["U"], ["Y"], axes=[0])]
+        graph = helper.make_graph(
+            nodes,
+            "test",
+            [helper.make_tensor_value_info("X", TensorProto.FLOAT, (2, 3))],
+            [helper.make_tensor_value_info("Y", TensorProto.FLOAT, (2, 3))],
+            value_info=[helper.make_tensor_value_info("R", TensorProto.FLOAT, (2, 3))])
+        optimized_model = self._optimized(graph, ["fuse_consecutive_reshapes"])
+
+        assert len(optimized_model.graph.node) == 1
+        assert optimized_model.graph.node[0].op_type == "Relu"
+        assert optimized_model.graph.node[0].output[0] == "Y"
+
+    def test_fuse_consecutive_reshapes_unknown_shape(self):
+        nodes = [helper.make_node("Flatten", ["X"], ["F"], axis=1),
+                 helper.make_node("Relu", ["F"], ["Y"])]
+        graph = helper.make_graph(
+            nodes,
+            "test",
+            [helper.make_tensor_value_info("X", TensorProto.FLOAT, None)],
+            [helper.make_tensor_value_info("Y", TensorProto.FLOAT, None)])
+        optimized_model = self._optimized(graph, ["fuse_consecutive_reshapes"])
+
+        # the shapes of X and F are not known to be the same
+        assert [n.op_type for n in optimized_model.graph.node] == ["Flatten", "Relu"]
+
+    def test_fuse_consecutive_reshapes_legacy_opset(self):
+        nodes = [helper.make_node("Flatten", ["X"], ["F"], axis=1),
+                 helper.make_node("Unsqueeze", ["F"], ["U"], axes=[0]),
+                 helper.make_node("Relu", ["U"], ["Y"])]
+        graph = helper.make_graph(
+            nodes,
+            "test",
+            [helper.make_tensor_value_info("X", TensorProto.FLOAT, (2, 3, 4))],
+            [helper.make_tensor_value_info("Y", TensorProto.FLOAT, (1, 2, 12))],
+            value_info=[helper.make_tensor_value_info("U", TensorProto.FLOAT, (1, 2, 12))])
+        orig_model = helper.make_model(graph, producer_name='onnx-test',
+                                       opset_imports=[helper.make_opsetid("", 4)])
+        optimized_model = onnx.optimizer.optimize(orig_model, ["fuse_consecutive_reshapes"])
+        checker.check_model(optimized_model)
+
+        # Reshape-1 takes the shape as an attribute
+        assert [n.op_type for n in optimized_model.graph.node] == ["Reshape", "Relu"]
+        assert list(optimized_model.graph.node[0].input) == ["X"]
+        assert list(optimized_model.graph.node[0].attribute[0].ints) == [1, 2, 12]
+
+    def test_eliminate_broadcast_tile(self):
+        nodes = [helper.make_node("Tile", ["X", "repeats"], ["T"]),
+                 helper.make_node("Add", ["T", "A"], ["Y"]),
+                 helper.make_node("Sub", ["Y", "T"], ["Z"])]
+        graph = helper.make_graph(
+            nodes,
+            "test",
+            [helper.make_tensor_value_info("X", TensorProto.FLOAT, (1, 3, 1)),
+             helper.make_tensor_value_info("A", TensorProto.FLOAT, (2, 3, 4)),
+             helper.make_tensor_value_info("repeats", TensorProto.INT64, (3,))],
+            [helper.make_tensor_value_info("Z", TensorProto.FLOAT, (2, 3, 4))],
+            initializer=[helper.make_tensor("repeats", TensorProto.INT64, (3,), [2, 1, 4])],
+            value_info=[helper.make_tensor_value_info("Y", TensorProto.FLOAT, (2, 3, 4))])
+        optimized_model = self._optimized(graph, ["eliminate_broadcast_tile"])
+
+        assert [n.op_type for n in optimized_model.graph.node] == ["Squeeze", "Add", "Sub"]
+        squeezed = optimized_model.graph.node[0].output[0]
+        for node in optimized_model.graph.node[1:]:
+            assert node.input[1] == squeezed
+            attrs = {a.name: a.i for a in node.attribute}
+            assert attrs == {"broadcast": 1, "axis": 1}
+
+    def test_eliminate_broadcast_tile_no_fuse(self):
+        nodes = [helper.make_node("Tile", ["X", "repeats"], ["T"]),
+                 helper.make_node("Sub", ["T", "A"], ["Y"])]
+        graph = helper.make_graph(
+            nodes,
+            "test",
+            [helper.make_tensor_value_info("X", TensorProto.FLOAT, (1, 3, 1)),
+             helper.make_tensor_value_info("A", TensorProto.FLOAT, (2, 3, 4)),
+             helper.make_tensor_value_info("repeats", TensorProto.INT64, (3,))],
+            [helper.make_tensor_value_info("Y", TensorProto.FLOAT, (2, 3, 4))],
+            initializer=[helper.make_tensor("repeats", TensorProto.INT64, (3,), [2, 1, 4])])
+        optimized_model = self._optimized(graph, ["eliminate_broadcast_tile"])
+
+        assert [n.op_type for n in optimized_model.graph.node] == ["Tile", "Sub"]
+
+    def test_inference_mode(self):
+        nodes = [helper.make_node("BatchNormalization", ["X", "s", "b", "m", "v"],
+                                  ["Y", "rm", "rv", "sm", "sv"]),
+                 helper.make_node("Dropout", ["Y"], ["D", "mask"]),
+                 helper.make_node("Identity", ["D"], ["O"])]
+        nodes.extend(self._make_fake_loop_op(
+            [helper.make_node("Dropout", ["_X"], ["_D", "_mask"]),
+             helper.make_node("Identity", ["_D"], ["_O2"])],
+            [(TensorProto.FLOAT, (1, 3), "X")],
+            [(TensorProto.FLOAT, (1, 3), "O2")]))
+        graph = helper.make_graph(
+            nodes,
+            "test",
+            [helper.make_tensor_value_info("X", TensorProto.FLOAT, (1, 3)),
+             helper.make_tensor_value_info("s", TensorProto.FLOAT, (3,)),
+             helper.make_tensor_value_info("b", TensorProto.FLOAT, (3,)),
+             helper.make_tensor_value_info("m", TensorProto.FLOAT, (3,)),
+             helper.make_tensor_value_info("v", TensorProto.FLOAT, (3,))],
+            [helper.make_tensor_value_info("O", TensorProto.FLOAT, (1, 3)),
+             helper.make_tensor_value_info("O2", TensorProto.FLOAT, (1, 3))])
+        optimized_model = self._optimized(graph, ["inference_mode"])
+
+        # BatchNormalization, Constant (trip count), Constant (condition), Loop
+        assert len(optimized_model.graph.node) == 4
+        bn = optimized_model.graph.node[0]
+        assert bn.op_type == "BatchNormalization"
+        assert list(bn.output) == ["O"]
+        assert [(a.name, a.i) for a in bn.attribute] == [("is_test", 1)]
+        # Identity is kept since it maps a body input to a body output
+        body = optimized_model.graph.node[3].attribute[0].g
+        assert len(body.node) == 1
+        assert body.node[0].op_type == "Identity"
+        assert list(body.node[0].input) == ["_X"]
+        assert list(body.node[0].output) == ["_O2"]
+
+    def test_convert_to_nchwc(self):
+        nodes = [helper.make_node("Conv", ["X", "W", "B"], ["C"], pads=[1, 1, 1, 1]),
+                 helper.make_node("Relu", ["C"], ["R"]),
+                 helper.make_node("MaxPool", ["R"], ["Y"], kernel_shape=[2, 2], strides=[2, 2]),
+                 helper.make_node("Exp", ["R"], ["E"])]
+        graph = helper.make_graph(
+            nodes,
+            "test",
+            [helper.make_tensor_value_info("X", TensorProto.FLOAT, (1, 3, 4, 4)),
+             helper.make_tensor_value_info("W", TensorProto.FLOAT, (5, 3, 3, 3)),
+             helper.make_tensor_value_info("B", TensorProto.FLOAT, (5,))],
+            [helper.make_tensor_value_info("Y", TensorProto.FLOAT, (1, 5, 2, 2)),
+             helper.make_tensor_value_info("E", TensorProto.FLOAT, (1, 5, 4, 4))],
+            initializer=[helper.make_tensor("W", TensorProto.FLOAT, (5, 3, 3, 3),
+                                            list(range(135))),
+                         helper.make_tensor("B", TensorProto.FLOAT, (5,), [1, 2, 3, 4, 5])],
+            value_info=[helper.make_tensor_value_info("C", TensorProto.FLOAT, (1, 5, 4, 4)),
+                        helper.make_tensor_value_info("R", TensorProto.FLOAT, (1, 5, 4, 4))])
+        optimized_model = self._optimized(graph, ["convert_to_nchw8c"])
+
+        assert [n.op_type for n in optimized_model.graph.node] == \
+            ["ReorderInput", "Conv", "Relu", "ReorderOutput", "MaxPool", "ReorderOutput", "Exp"]
+        assert [n.domain for n in optimized_model.graph.node] == \
+            ["ai.onnx.nchwc"] * 2 + [""] + ["ai.onnx.nchwc"] * 3 + [""]
+        # R is used outside of the region, and keeps its name
+        assert list(optimized_model.graph.node[3].output) == ["R"]
+        assert list(optimized_model.graph.node[5].output) == ["Y"]
+        assert ("ai.onnx.nchwc", 1) in [(o.domain, o.version) for o in optimized_model.opset_import]
+
+        w = optimized_model.graph.initializer[0]
+        assert list(w.dims) == [1, 1, 3, 3, 8, 8]
+        # weight of input channel 2 for output channel 4, at kernel position (1, 2)
+        w_data = np.array(w.float_data).reshape(w.dims)
+        assert w_data[0, 0, 1, 2, 2, 4] == 4 * 27 + 2 * 9 + 1 * 3 + 2
+        assert w_data[0, 0, 1, 2, 3, 4] == 0
+        assert list(optimized_model.graph.initializer[1].float_data) == [1, 2, 3, 4, 5, 0, 0, 0]
+
+    def test_convert_to_nchwc_no_fuse(self):
+        # grouped convolutions are not converted
+        nodes = [helper.make_node("Conv", ["X", "W"], ["Y"], group=2)]
+        graph = helper.make_graph(
+            nodes,
+            "test",
+            [helper.make_tensor_value_info("X", TensorProto.FLOAT, (1, 4, 4, 4)),
+             helper.make_tensor_value_info("W", TensorProto.FLOAT, (4, 2, 1, 1))],
+            [helper.make_tensor_value_info("Y", TensorProto.FLOAT, (1, 4, 4, 4))],
+            initializer=[helper.make_tensor("W", TensorProto.FLOAT, (4, 2, 1, 1),
+                                            [1] * 8)])
+        optimized_model = self._optimized(graph, ["convert_to_nchw16c"])
+
+        assert [n.op_type for n in optimized_model.graph.node] == ["Conv"]
+        assert optimized_model.graph.node[0].domain == ""
+
+    def test_fuse_activation_into_conv_and_gemm(self):
+        nodes = [helper.make_node("Conv", ["X", "W"], ["Z"], pads=[1, 1, 1, 1]),
+                 helper.make_node("LeakyRelu", ["Z"], ["Y"], alpha=0.5),
+                 helper.make_node("Gemm", ["A", "B", "C"], ["G"], transB=1),
+                 helper.make_node("HardSigmoid", ["G"], ["H"])]
+        graph = helper.make_graph(
+            nodes,
+            "test",
+            [helper.make_tensor_value_info("X", TensorProto.FLOAT, (1, 3, 4, 4)),
+             helper.make_tensor_value_info("W", TensorProto.FLOAT, (2, 3, 3, 3)),
+             helper.make_tensor_value_info("A", TensorProto.FLOAT, (4, 5)),
+             helper.make_tensor_value_info("B", TensorProto.FLOAT, (6, 5)),
+             helper.make_tensor_value_info("C", TensorProto.FLOAT, (4, 6))],
+            [helper.make_tensor_value_info("Y", TensorProto.FLOAT, (1, 2, 4, 4)),
+             helper.make_tensor_value_info("H", TensorProto.FLOAT, (4, 6))])
+        optimized_model = self._optimized(graph, ["fuse_activation_into_conv_and_gemm"])
+
+        assert [n.op_type for n in optimized_model.graph.node] == ["FusedConv", "FusedGemm"]
+        conv, gemm = optimized_model.graph.node
+        assert list(conv.input) == ["X", "W"]
+        assert list(conv.output) == ["Y"]
+        conv_attrs = {a.name: a for a in conv.attribute}
+        assert list(conv_attrs["pads"].ints) == [1, 1, 1, 1]
+        assert conv_attrs["activation"].s == b"LeakyRelu"
+        assert conv_attrs["activation_alpha"].f == 0.5
+        assert list(gemm.output) == ["H"]
+        gemm_attrs = {a.name: a for a in gemm.attribute}
+        assert gemm_attrs["transB"].i == 1
+        assert gemm_attrs["activation"].s == b"HardSigmoid"
+        # the default values of the activation are made explicit
+        assert abs(gemm_attrs["activation_alpha"].f - 0.2) < 1e-6
+        assert gemm_attrs["activation_beta"].f == 0.5
+
+    def test_fuse_activation_into_conv_and_gemm_no_fuse(self):
+        # the output of the Gemm is used by another node
+        nodes = [helper.make_node("Gemm", ["A", "B", "C"], ["G"]),
+                 helper.make_node("Relu", ["G"], ["R"]),
+                 helper.make_node("Add", ["G", "R"], ["Y"])]
+        graph = helper.make_graph(
+            nodes,
+            "test",
+            [helper.make_tensor_value_info("A", TensorProto.FLOAT, (4, 5)),
+             helper.make_tensor_value_info("B", TensorProto.FLOAT, (5, 6)),
+             helper.make_tensor_value_info("C", TensorProto.FLOAT, (4, 6))],
+            [helper.make_tensor_value_info("Y", TensorProto.FLOAT, (4, 6))])
+        optimized_model = self._optimized(graph, ["fuse_activation_into_conv_and_gemm"])
+
+        assert [n.op_type for n in optimized_model.graph.node] == ["Gemm", "Relu", "Add"]
+
+    def test_fuse_elementwise(self):
+        nodes = [helper.make_node("Add", ["X", "B"], ["A"], broadcast=1),
+                 helper.make_node("Relu", ["A"], ["R"]),
+                 helper.make_node("Mul", ["R", "S"], ["M"], broadcast=1, axis=0),
+                 helper.make_node("Neg", ["M"], ["Y"])]
+        graph = helper.make_graph(
+            nodes,
+            "test",
+            [helper.make_tensor_value_info("X", TensorProto.FLOAT, (2, 3)),
+             helper.make_tensor_value_info("B", TensorProto.FLOAT, (3,)),
+             helper.make_tensor_value_info("S", TensorProto.FLOAT, (2,))],
+            [helper.make_tensor_value_info("R", TensorProto.FLOAT, (2, 3)),
+             helper.make_tensor_value_info("Y", TensorProto.FLOAT, (2, 3))])
+        optimized_model = self._optimized(graph, ["fuse_elementwise"])
+
+        assert len(optimized_model.graph.node) == 1
+        fused = optimized_model.graph.node[0]
+        assert fused.op_type == "FusedElementwise"
+        assert list(fused.input) == ["X", "B", "S"]
+        assert list(fused.output) == ["R", "Y"]
+        body = fused.attribute[0].g
+        assert [n.op_type for n in body.node] == ["Add", "Relu", "Mul", "Neg"]
+
+        inputs = {"X": np.random.randn(2, 3).astype(np.float32),
+                  "B": np.random.randn(3).astype(np.float32),
+                  "S": np.random.randn(2).astype(np.float32)}
+        expected = onnx.fused_elementwise.run_graph(graph, inputs)
+        actual = onnx.fused_elementwise.run_graph(optimized_model.graph, inputs)
+        for name in ["R", "Y"]:
+            np.testing.assert_allclose(actual[name], expected[name])
+
+    def test_fuse_elementwise_no_fuse(self):
+        # the shape of the output of Add is not the shape of the region, and
+        # the output of Relu is used by Transpose before Mul
+        nodes = [helper.make_node("Neg", ["B"], ["N"]),
+                 helper.make_node("Add", ["X", "N"], ["A"], broadcast=1),
+                 helper.make_node("Relu", ["A"], ["R"]),
+                 helper.make_node("Transpose", ["R"], ["T"]),
+                 helper.make_node("Mul", ["R", "X"], ["Y"])]
+        graph = helper.make_graph(
+            nodes,
+            "test",
+            [helper.make_tensor_value_info("X", TensorProto.FLOAT, (2, 3)),
+             helper.make_tensor_value_info("B", TensorProto.FLOAT, (3,))],
+            [helper.make_tensor_value_info("T", TensorProto.FLOAT, (3, 2)),
+             helper.make_tensor_value_info("Y", TensorProto.FLOAT, (2, 3))])
+        optimized_model = self._optimized(graph, ["fuse_elementwise"])
+
+        assert [n.op_type for n in optimized_model.graph.node] == \
+            ["Neg", "FusedElementwise", "Transpose", "Mul"]
+
+    def test_hoist_loop_invariants(self):
+        nodes = self._make_fake_loop_op(
+            [helper.make_node("Mul", ["W", "W"], ["_W2"]),
+             helper.make_node("Add", ["_X", "_W2"], ["_T"]),
+             helper.make_node("Mul", ["_T", "W"], ["_Y2"])],
+            [(TensorProto.FLOAT, (5,), "X")],
+            [(TensorProto.FLOAT, (5,), "Y2")])
+        graph = helper.make_graph(
+            nodes,
+            "test",
+            [helper.make_tensor_value_info("X", TensorProto.FLOAT, (5,)),
+             helper.make_tensor_value_info("W", TensorProto.FLOAT, (5,))],
+            [helper.make_tensor_value_info("Y2", TensorProto.FLOAT, (5,))])
+        optimized_model = self._optimized(graph, ["hoist_loop_invariants"])
+
+        # Constant (trip count), Constant (condition), Mul, Loop
+        assert [n.op_type for n in optimized_model.graph.node] == \
+            ["Constant", "Constant", "Mul", "Loop"]
+        assert list(optimized_model.graph.node[2].output) == ["_W2"]
+        body = optimized_model.graph.node[3].attribute[0].g
+        assert [n.op_type for n in body.node] == ["Add", "Mul"]
+        assert list(body.node[0].input) == ["_X", "_W2"]
+
+    def test_inline_constant_control_flow_if(self):
+        then_graph = helper.make_graph(
+            [helper.make_node("Relu", ["X"], ["T"])], "then_graph", [],
+            [helper.make_tensor_value_info("T", TensorProto.FLOAT, (5,))])
+        else_graph = helper.make_graph(
+            [helper.make_node("Neg", ["X"], ["E"])], "else_graph", [],
+            [helper.make_tensor_value_info("E", TensorProto.FLOAT, (5,))])
+        true = helper.make_tensor("condition", TensorProto.BOOL, (), [True])
+        nodes = [helper.make_node("Constant", [], ["condition"], value=true),
+                 helper.make_node("If", ["condition"], ["Y"], then_branch=then_graph,
+                                  else_branch=else_graph)]
+        graph = helper.make_graph(
+            nodes,
+            "test",
+            [helper.make_tensor_value_info("X", TensorProto.FLOAT, (5,))],
+            [helper.make_tensor_value_info("Y", TensorProto.FLOAT, (5,))])
+        optimized_model = self._optimized(graph, ["inline_constant_control_flow"])
+
+        assert [n.op_type for n in optimized_model.graph.node] == ["Constant", "Relu"]
+        assert list(optimized_model.graph.node[1].output) == ["Y"]
+
+    def test_inline_constant_control_flow_loop(self):
+        body_graph = helper.make_graph(
+            [helper.make_node("Add", ["x", "W"], ["y"])],
+            "body_graph",
+            [helper.make_tensor_value_info("i", TensorProto.INT64, ()),
+             helper.make_tensor_value_info("cond", TensorProto.BOOL, ()),
+             helper.make_tensor_value_info("x", TensorProto.FLOAT, (5,))],
+            [helper.make_tensor_value_info("cond", TensorProto.BOOL, ()),
+             helper.make_tensor_value_info("y", TensorProto.FLOAT, (5,)),
+             helper.make_tensor_value_info("y", TensorProto.FLOAT, (5,))])
+        trip_count = helper.make_tensor("trip_count", TensorProto.INT64, (), [3])
+        nodes = [helper.make_node("Constant", [], ["trip_count"], value=trip_count),
+                 helper.make_node("Loop", ["trip_count", "", "X"], ["Y", "S"],
+                                  body=body_graph)]
+        graph = helper.make_graph(
+            nodes,
+            "test",
+            [helper.make_tensor_value_info("X", TensorProto.FLOAT, (5,)),
+             helper.make_tensor_value_info("W", TensorProto.FLOAT, (5,))],
+            [helper.make_tensor_value_info("Y", TensorProto.FLOAT, (5,)),
+             helper.make_tensor_value_info("S", TensorProto.FLOAT, (3, 5))])
+        optimized_model = self._optimized(graph, ["inline_constant_control_flow"])
+
+        assert [n.op_type for n in optimized_model.graph.node] == \
+            ["Constant", "Add", "Add", "Add", "Unsqueeze", "Unsqueeze", "Unsqueeze", "Concat"]
+        assert list(optimized_model.graph.node[3].output) == ["Y"]
+        assert list(optimized_model.graph.node[7].output) == ["S"]
+
+    def test_inline_constant_control_flow_loop_int_scan(self):
+        # Unsqueeze and Concat do not take the int64 iteration numbers
+        body_graph = helper.make_graph(
+            [helper.make_node("Add", ["x", "W"], ["y"])],
+            "body_graph",
+            [helper.make_tensor_value_info("i", TensorProto.INT64, ()),
+             helper.make_tensor_value_info("cond", TensorProto.BOOL, ()),
+             helper.make_tensor_value_info("x", TensorProto.FLOAT, (5,))],
+            [helper.make_tensor_value_info("cond", TensorProto.BOOL, ()),
+             helper.make_tensor_value_info("y", TensorProto.FLOAT, (5,)),
+             helper.make_tensor_value_info("i", TensorProto.INT64, ())])
+        trip_count = helper.make_tensor("trip_count", TensorProto.INT64, (), [3])
+        cond = helper.make_tensor("cond", TensorProto.BOOL, (), [True])
+        nodes = [helper.make_node("Constant", [], ["trip_count"], value=trip_count),
+                 helper.make_node("Constant", [], ["cond"], value=cond),
+                 helper.make_node("Loop", ["trip_count", "cond", "X"], ["Y", "S"],
+                                  body=body_graph)]
+        graph = helper.make_graph(
+            nodes,
+            "test",
+            [helper.make_tensor_value_info("X", TensorProto.FLOAT, (5,)),
+             helper.make_tensor_value_info("W", TensorProto.FLOAT, (5,))],
+            [helper.make_tensor_value_info("Y", TensorProto.FLOAT, (5,)),
+             helper.make_tensor_value_info("S", TensorProto.INT64, (3,))])
+        optimized_model = self._optimized(graph, ["inline_constant_control_flow"])
+
+        assert [n.op_type for n in optimized_model.graph.node] == ["Constant", "Constant", "Loop"]
+
+    def test_reorder_for_peak_memory(self):
+        nodes = [helper.make_node("Conv", ["X", "W"], ["A"], pads=[1, 1, 1, 1]),
+                 helper.make_node("Conv", ["X", "W"], ["B"], pads=[1, 1, 1, 1]),
+                 helper.make_node("GlobalAveragePool", ["A"], ["Y"]),
+                 helper.make_node("GlobalAveragePool", ["B"], ["Z"])]
+        graph = helper.make_graph(
+            nodes,
+            "test",
+            [helper.make_tensor_value_info("X", TensorProto.FLOAT, (1, 4, 8, 8)),
+             helper.make_tensor_value_info("W", TensorProto.FLOAT, (4, 4, 3, 3))],
+            [helper.make_tensor_value_info("Y", TensorProto.FLOAT, (1, 4, 1, 1)),
+             helper.make_tensor_value_info("Z", TensorProto.FLOAT, (1, 4, 1, 1))],
+            value_info=[helper.make_tensor_value_info("A", TensorProto.FLOAT, (1, 4, 8, 8)),
+                        helper.make_tensor_value_info("B", TensorProto.FLOAT, (1, 4, 8, 8))])
+        optimized_model = self._optimized(graph, ["reorder_for_peak_memory"])
+
+        assert [n.output[0] for n in optimized_model.graph.node] == ["A", "Y", "B", "Z"]
+        props = {p.key: p.value for p in optimized_model.metadata_props}
+        # A and B are live together before, A and then B after
+        assert props["peak_memory_bytes_before"] == str(2 * 1024 + 16)
+        assert props["peak_memory_bytes_after"] == str(1024 + 2 * 16)
+
+    def test_reorder_for_peak_memory_unknown_shape(self):
+        nodes = [helper.make_node("Conv", ["X", "W"], ["A"], pads=[1, 1, 1, 1]),
+                 helper.make_node("Conv", ["X", "W"], ["B"], pads=[1, 1, 1, 1]),
+                 helper.make_node("GlobalAveragePool", ["A"], ["Y"]),
+                 helper.make_node("GlobalAveragePool", ["B"], ["Z"])]
+        graph = helper.make_graph(
+            nodes,
+            "test",
+            [helper.make_tensor_value_info("X", TensorProto.FLOAT, (1, 4, 8, 8)),
+             helper.make_tensor_value_info("W", TensorProto.FLOAT, (4, 4, 3, 3))],
+            [helper.make_tensor_value_info("Y", TensorProto.FLOAT, (1, 4, 1, 1)),
+             helper.make_tensor_value_info("Z", TensorProto.FLOAT, (1, 4, 1, 1))],
+            value_info=[helper.make_tensor_value_info("A", TensorProto.FLOAT, None),
+                        helper.make_tensor_value_info("B", TensorProto.FLOAT, None)])
+        optimized_model = self._optimized(graph, ["reorder_for_peak_memory"])
+
+        # A and B have no known size, so only Y and Z count
+        assert [n.output[0] for n in optimized_model.graph.node] == ["A", "B", "Y", "Z"]
+        props = {p.key: p.value for p in optimized_model.metadata_props}
+        assert props["peak_memory_bytes_before"] == str(2 * 16)
+        assert props["peak_memory_bytes_after"] == str(2 * 16)
+
+    def test_plan_memory(self):
+        nodes = [helper.make_node("Conv", ["X", "W"], ["A"], pads=[1, 1, 1, 1]),
+                 helper.make_node("Relu", ["A"], ["B"]),
+                 helper.make_node("GlobalAveragePool", ["B"], ["C"]),
+                 helper.make_node("Conv", ["X", "W"], ["D"], pads=[1, 1, 1, 1]),
+                 helper.make_node("GlobalAveragePool", ["D"], ["E"]),
+                 helper.make_node("Add", ["C", "E"], ["Y"])]
+        graph = helper.make_graph(
+            nodes,
+            "test",
+            [helper.make_tensor_value_info("X", TensorProto.FLOAT, (1, 4, 16, 16)),
+             helper.make_tensor_value_info("W", TensorProto.FLOAT, (4, 4, 3, 3))],
+            [helper.make_tensor_value_info("Y", TensorProto.FLOAT, (1, 4, 1, 1))],
+            value_info=[helper.make_tensor_value_info("A", TensorProto.FLOAT, (1, 4, 16, 16)),
+                        helper.make_tensor_value_info("B", TensorProto.FLOAT, (1, 4, 16, 16)),
+                        helper.make_tensor_value_info("C", TensorProto.FLOAT, (1, 4, 1, 1)),
+                        helper.make_tensor_value_info("D", TensorProto.FLOAT, (1, 4, 16, 16)),
+                        helper.make_tensor_value_info("E", TensorProto.FLOAT, (1, 4, 1, 1))])
+        optimized_model = self._optimized(graph, ["plan_memory"])
+
+        assert len(optimized_model.graph.node) == 6
+        props = {p.key: p.value for p in optimized_model.metadata_props}
+        lines = props["memory_plan"].splitlines()
+        assert lines[0] == "arena 4176"
+        # B reuses the buffer of A, D reuses it once B is dead, and C and
+        # E are live together with D
+        assert lines[1:] == ["0 4096 A",
+                             "0 4096 B",
+                             "4096 16 C",
+                             "0 4096 D",
+                             "4160 16 E"]
+
+    def test_plan_memory_unknown_shape(self):
+        nodes = [helper.make_node("Relu", ["X"], ["A"]),
+                 helper.make_node("Relu", ["A"], ["B"]),
+                 helper.make_node("Add", ["B", "B"], ["Y"])]
+        graph = helper.make_graph(
+            nodes,
+            "test",
+            [helper.make_tensor_value_info("X", TensorProto.FLOAT, ("N", 1000))],
+            [helper.make_tensor_value_info("Y", TensorProto.FLOAT, (2, 1000))],
+            value_info=[helper.make_tensor_value_info("A", TensorProto.FLOAT, None),
+                        helper.make_tensor_value_info("B", TensorProto.FLOAT, (2, 1000))])
+        optimized_model = self._optimized(graph, ["plan_memory"])
+
+        props = {p.key: p.value for p in optimized_model.metadata_props}
+        # A has no known size and is left out of the plan
+        assert props["memory_plan"].splitlines() == ["arena 8000", "0 8000 B"]
+
+    def test_optimize_batch(self):
+        # the branches of the If are optimized concurrently
+        branches = [helper.make_graph(
+            [helper.make_node("Transpose", ["X"], ["T"], perm=[1, 0]),
+             helper.make_node("Transpose", ["T"], [name], perm=[1, 0])],
+            name,
+            [],
+            [helper.make_tensor_value_info(name, TensorProto.FLOAT, (2, 3))])
+            for name in ["then", "else"]]
+        models = []
+        for i in range(8):
+            graph = helper.make_graph(
+                [helper.make_node("If", ["C"], ["Y"],
+                                  then_branch=branches[0], else_branch=branches[1]),
+                 helper.make_node("Transpose", ["Y"], ["Z"], perm=[i % 2, 1 - i % 2])],
+                "test",
+                [helper.make_tensor_value_info("C", TensorProto.BOOL, ()),
+                 helper.make_tensor_value_info("X", TensorProto.FLOAT, (2, 3))],
+                [helper.make_tensor_value_info("Z", TensorProto.FLOAT, (2, 3) if i % 2 == 0 else (3, 2))])
+            models.append(helper.make_model(graph, producer_name='onnx-test'))
+        passes = ["fuse_consecutive_transposes", "eliminate_nop_transpose"]
+        optimized_models = onnx.optimizer.optimize_batch(models, passes, num_threads=4)
+        assert len(optimized_models) == len(models)
+        for model, optimized_model in zip(models, optimized_models):
+            checker.check_model(optimized_model)
+            assert optimized_model == onnx.optimizer.optimize(model, passes)
+            for branch in optimized_model.graph.node[0].attribute:
+                assert len(branch.g.node) == 0
+        assert [len(m.graph.node) for m in optimized_models[:2]] == [1, 2]
+
     def test_preserve_value_info(self):
         trans1 = helper.make_node("Transpose", ["X"], ["Y"], perm=[1, 0, 2])
         trans2 = helper.make_node("Transpose", ["Y"], ["Z"], perm=[2, 0, 1])
@@ -0,0 +1,85 @@
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+from __future__ import unicode_literals
+
+from onnx import checker, helper, TensorProto
+from onnx.helper import make_node, make_tensor_value_info
+
+import onnx.partition
+import unittest
+
+
+class TestPartition(unittest.TestCase):
+    def _partitioned(self, nodes, inputs, outputs, supported_ops):
+        graph = helper.make_graph(
+            nodes,
+            "test",
+            [make_tensor_value_info(name, TensorProto.FLOAT, (2, 3)) for name in inputs],
+            [make_tensor_value_info(name, TensorProto.FLOAT, (2, 3)) for name in outputs])
+        model = helper.make_model(graph, producer_name='onnx-test')
+        main, partitions = onnx.partition.partition(model, supported_ops)
+        checker.check_model(main)
+        for p in partitions:
+            checker.check_model(p)
+        return main, partitions
+
+    def test_partition(self):
+        main, partitions = self._partitioned(
+            [make_node('Relu', ['X'], ['A']),
+             make_node('Abs', ['A'], ['B']),
+             make_node('Add', ['A', 'B'], ['C']),
+             make_node('Relu', ['C'], ['D']),
+             make_node('Sigmoid', ['X'], ['E']),
+             make_node('Mul', ['D', 'E'], ['F'])],
+            ['X'], ['F'], ['Relu', 'Add', 'Mul', 'Sigmoid'])
+        # Add cannot join the first Relu, as it reads it through Abs
+        assert [n.op_type for n in main.graph.node] == ['Partition', 'Abs', 'Partition']
+        assert [n.attribute[0].s for n in main.graph.node if n.op_type == 'Partition'] == \
+            [b'partition_0', b'partition_1']
+        assert [p.graph.name for p in partitions] == ['partition_0', 'partition_1']
+        assert [n.op_type for n in partitions[0].graph.node] == ['Relu', 'Sigmoid']
+        assert [i.name for i in partitions[0].graph.input] == ['X']
+        assert [o.name for o in partitions[0].graph.output] == ['A', 'E']
+        assert [n.op_type for n in partitions[1].graph.node] == ['Add', 'Relu', 'Mul']
+        assert [i.name for i in partitions[1].graph.input] == ['A', 'B', 'E']
+        assert [o.name for o in partitions[1].graph.output] == ['F']
+        # the boundary values have their inferred types
+        assert partitions[1].graph.input[1].type.tensor_type.elem_type == TensorProto.FLOAT
+
+    def test_partition_reorders_nodes(self):
+        main, partitions = self._partitioned(
+            [make_node('Relu', ['X'], ['A']),
+             make_node('Abs', ['X'], ['B']),
+             make_node('Add', ['A', 'B'], ['C'])],
+            ['X'], ['C'], ['Relu', 'Add'])
+        # the partition reads the output of Abs, which now runs first
+        assert [n.op_type for n in main.graph.node] == ['Abs', 'Partition']
+        assert list(main.graph.node[1].input) == ['X', 'B']
+        assert len(partitions) == 1
+
+    def test_partition_none_supported(self):
+        main, partitions = self._partitioned(
+            [make_node('Relu', ['X'], ['Y'])],
+            ['X'], ['Y'], [])
+        assert [n.op_type for n in main.graph.node] == ['Relu']
+        assert partitions == []
+
+    def test_partition_without_inputs_or_outputs(self):
+        value = helper.make_tensor('value', TensorProto.FLOAT, (2, 3), [1, -2, 3, -4, 5, -6])
+        nodes = [make_node('Constant', [], ['C'], value=value),
+                 make_node('Relu', ['C'], ['R']),
+                 make_node('Add', ['X', 'R'], ['Y']),
+                 make_node('Sigmoid', ['X'], ['D'])]
+        # the Constant-fed partition has no inputs
+        main, partitions = self._partitioned(nodes, ['X'], ['Y'], ['Constant', 'Relu'])
+        assert [n.op_type for n in main.graph.node] == ['Constant', 'Relu', 'Add', 'Sigmoid']
+        assert partitions == []
+        # the output of Sigmoid is not used
+        main, partitions = self._partitioned(nodes, ['X'], ['Y'], ['Sigmoid'])
+        assert [n.op_type for n in main.graph.node] == ['Constant', 'Relu', 'Add', 'Sigmoid']
+        assert partitions == []
+
+
+if __name__ == '__main__':
+    unittest.main()
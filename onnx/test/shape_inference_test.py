@@ -283,6 +283,13 @@ class TestShapeInference(unittest.TestCase):
             [])
         self._assert_inferred(graph, [make_tensor_value_info('z', TensorProto.FLOAT, None)])
 
+    def test_maxpool(self):
+        graph = self._make_graph(
+            [('x', TensorProto.FLOAT, (5, 3, 8, 9))],
+            [make_node('MaxPool', ['x'], 'y', kernel_shape=[2, 3], strides=[2, 3], pads=[0, 0, 0, 3])],
+            [])
+        self._assert_inferred(graph, [make_tensor_value_info('y', TensorProto.FLOAT, (5, 3, 4, 4))])
+
     def test_relu(self):
         self._identity_prop('Relu')
 
@@ -416,6 +423,229 @@ class TestShapeInference(unittest.TestCase):
             [])
         self._assert_inferred(graph, [make_tensor_value_info('z', TensorProto.FLOAT, (4, 5))])
 
+    def test_check_and_infer_shapes(self):
+        graph = self._make_graph(
+            [("X", TensorProto.FLOAT, (2, 3, 4))],
+            [make_node("Transpose", ["X"], ["Y"], perm=[1, 0, 2]),
+             make_node("Relu", ["Y"], ["Z"])],
+            [])
+        model = helper.make_model(graph, producer_name='onnx-test')
+        self.assertEqual(
+            onnx.shape_inference.check_and_infer_shapes(model),
+            onnx.shape_inference.infer_shapes(model))
+
+        # check errors take precedence over inference errors of earlier nodes
+        graph.value_info.extend([make_tensor_value_info("Y", TensorProto.FLOAT, (5, 5, 5))])
+        graph.node.extend([make_node("Relu", ["W"], ["V"])])
+        model = helper.make_model(graph, producer_name='onnx-test')
+        self.assertRaises(checker.ValidationError, onnx.shape_inference.check_and_infer_shapes, model)
+        del graph.node[-1]
+        model = helper.make_model(graph, producer_name='onnx-test')
+        self.assertRaises(RuntimeError, onnx.shape_inference.check_and_infer_shapes, model)
+
+    def test_check_and_infer_shapes_input_types(self):
+        def make_model(x_type, y_type):
+            graph = self._make_graph(
+                [("X", x_type, (2, 3)), ("Y", y_type, (2, 3))],
+                [make_node("Add", ["X", "Y"], ["Z"]),
+                 make_node("Relu", ["Z"], ["W"])],
+                [])
+            return helper.make_model(graph, producer_name='onnx-test')
+
+        onnx.shape_inference.check_and_infer_shapes(make_model(TensorProto.FLOAT, TensorProto.FLOAT))
+        # the inputs of the same type constraint must have the same type
+        self.assertRaises(checker.ValidationError, onnx.shape_inference.check_and_infer_shapes,
+                          make_model(TensorProto.FLOAT, TensorProto.DOUBLE))
+        # and it must be one of the types it allows
+        self.assertRaises(checker.ValidationError, onnx.shape_inference.check_and_infer_shapes,
+                          make_model(TensorProto.STRING, TensorProto.STRING))
+
+    def test_check_and_infer_shapes_on_graph(self):
+        def make_model(nodes, y_shape):
+            graph = helper.make_graph(
+                nodes,
+                "test",
+                [make_tensor_value_info("X", TensorProto.FLOAT, (2, 3)),
+                 make_tensor_value_info("S", TensorProto.INT64, (2,))],
+                [make_tensor_value_info("Y", TensorProto.FLOAT, y_shape)])
+            return helper.make_model(graph, producer_name='onnx-test')
+
+        # the shape of R is not known, and Relu must not take R as a scalar
+        model = make_model([make_node("Reshape", ["X", "S"], ["R"]),
+                            make_node("Relu", ["R"], ["Y"])], ("N", "M"))
+        inferred_model = onnx.shape_inference.check_and_infer_shapes_on_graph(model)
+        self.assertEqual(list(inferred_model.graph.output), list(model.graph.output))
+        inferred_types = {vi.name: vi.type for vi in inferred_model.graph.value_info}
+        self.assertEqual(inferred_types["R"].tensor_type.elem_type, TensorProto.FLOAT)
+
+        model = make_model([make_node("Transpose", ["X"], ["R"]),
+                            make_node("Relu", ["R"], ["Y"])], (3, 2))
+        inferred_model = onnx.shape_inference.check_and_infer_shapes_on_graph(model)
+        self.assertEqual(list(inferred_model.graph.value_info),
+                         [make_tensor_value_info("R", TensorProto.FLOAT, (3, 2))])
+
+        model = make_model([make_node("Transpose", ["X"], ["R"]),
+                            make_node("Relu", ["R"], ["Y"], foo=1)], (3, 2))
+        self.assertRaises(checker.ValidationError,
+                          onnx.shape_inference.check_and_infer_shapes_on_graph, model)
+        model = make_model([make_node("Transpose", ["X"], ["R"]),
+                            make_node("Relu", ["R"], ["Y"])], (6, 1))
+        self.assertRaises(RuntimeError,
+                          onnx.shape_inference.check_and_infer_shapes_on_graph, model)
+
+    def _cached(self, nodes, inputs, cache=None):
+        graph = helper.make_graph(nodes, "test", inputs, [])
+        model = helper.make_model(graph, producer_name='onnx-test')
+        if cache is None:
+            cache = onnx.shape_inference.InferenceCache()
+        inferred_model = onnx.shape_inference.infer_shapes(model, cache)
+        shapes = {vi.name: [d.dim_value for d in vi.type.tensor_type.shape.dim]
+                  for vi in inferred_model.graph.value_info}
+        return inferred_model, shapes, cache
+
+    def test_infer_shapes_cache(self):
+        nodes = []
+        for i in range(3):
+            nodes.extend([make_node("Relu", ["X" + str(i)], ["R" + str(i)]),
+                          make_node("Softmax", ["R" + str(i)], ["X" + str(i + 1)])])
+        inputs = [make_tensor_value_info("X0", TensorProto.FLOAT, (2, 3))]
+        model = helper.make_model(helper.make_graph(nodes, "test", inputs, []),
+                                  producer_name='onnx-test')
+        inferred_model, _, cache = self._cached(nodes, inputs)
+        self.assertEqual((cache.hits, cache.misses), (4, 2))
+        self.assertEqual(inferred_model.SerializeToString(),
+                         onnx.shape_inference.infer_shapes(model).SerializeToString())
+        # a cache is reused across models
+        inferred_model, _, cache = self._cached(nodes, inputs, cache)
+        self.assertEqual((cache.hits, cache.misses), (10, 2))
+        self.assertEqual(inferred_model.SerializeToString(),
+                         onnx.shape_inference.infer_shapes(model).SerializeToString())
+
+    def test_infer_shapes_cache_graph_attributes(self):
+        branch = helper.make_graph(
+            [make_node("Relu", ["X"], ["Y"])], "branch", [],
+            [make_tensor_value_info("Y", TensorProto.FLOAT, (2, 3))])
+        nodes = [make_node("If", ["C"], ["A"], then_branch=branch, else_branch=branch),
+                 make_node("If", ["C"], ["B"], then_branch=branch, else_branch=branch),
+                 make_node("Relu", ["X"], ["D"])]
+        _, _, cache = self._cached(nodes, [
+            make_tensor_value_info("C", TensorProto.BOOL, ()),
+            make_tensor_value_info("X", TensorProto.FLOAT, (2, 3))])
+        self.assertEqual((cache.hits, cache.misses), (0, 1))
+
+    def test_infer_shapes_cache_key(self):
+        x = make_tensor_value_info("X", TensorProto.FLOAT, (2, 3))
+        # an input without a type is not one which is missing
+        untyped = onnx.ValueInfoProto()
+        untyped.name = "U"
+        _, _, cache = self._cached(
+            [make_node("Relu", ["U"], ["A"]),
+             make_node("Relu", ["M"], ["B"]),
+             make_node("Relu", ["U"], ["C"])],
+            [untyped])
+        self.assertEqual((cache.hits, cache.misses), (1, 2))
+
+        _, shapes, cache = self._cached(
+            [make_node("Transpose", ["X"], ["A"], perm=[1, 0]),
+             make_node("Transpose", ["X"], ["B"], perm=[0, 1]),
+             make_node("Transpose", ["X"], ["C"], perm=[1, 0])],
+            [x])
+        self.assertEqual((cache.hits, cache.misses), (1, 2))
+        self.assertEqual((shapes["A"], shapes["B"], shapes["C"]), ([3, 2], [2, 3], [3, 2]))
+
+        _, shapes, cache = self._cached(
+            [make_node("Split", ["X"], ["A", "B"], axis=1),
+             make_node("Split", ["X"], ["C", "D", "E"], axis=1)],
+            [x])
+        self.assertEqual((cache.hits, cache.misses), (0, 2))
+        self.assertEqual((shapes["A"], shapes["C"]), ([2, 2], [2, 1]))
+
+    def _incremental_model(self, nodes, x_shape):
+        graph = helper.make_graph(
+            nodes, "test", [make_tensor_value_info("X", TensorProto.FLOAT, x_shape)], [])
+        return helper.make_model(graph, producer_name='onnx-test')
+
+    def _value_infos(self, model):
+        return {vi.name: vi.type for vi in model.graph.value_info}
+
+    def test_incremental_inference(self):
+        nodes = [make_node("Transpose", ["X"], ["A"], perm=[1, 0]),
+                 make_node("Relu", ["A"], ["B"]),
+                 make_node("Split", ["B"], ["C", "D"])]
+        inference = onnx.shape_inference.IncrementalInference(
+            self._incremental_model(nodes, (2, 3)))
+        self.assertEqual(
+            self._value_infos(inference.model),
+            self._value_infos(onnx.shape_inference.infer_shapes(self._incremental_model(nodes, (2, 3)))))
+
+        x_type = make_tensor_value_info("X", TensorProto.FLOAT, (4, 5)).type
+        self.assertEqual(inference.update_input_types({"X": x_type}), 3)
+        self.assertEqual(
+            self._value_infos(inference.model),
+            self._value_infos(onnx.shape_inference.infer_shapes(self._incremental_model(nodes, (4, 5)))))
+        # nothing is re-inferred for the type the input already has
+        self.assertEqual(inference.update_input_types({"X": x_type}), 0)
+
+    def test_incremental_inference_unchanged_output(self):
+        nodes = [make_node("Shape", ["X"], ["S"]),
+                 make_node("Cast", ["S"], ["F"], to=TensorProto.FLOAT),
+                 make_node("Relu", ["F"], ["G"])]
+        inference = onnx.shape_inference.IncrementalInference(
+            self._incremental_model(nodes, (2, 3)))
+        # the shape of X has the same rank, so S keeps its type
+        x_type = make_tensor_value_info("X", TensorProto.FLOAT, (4, 5)).type
+        self.assertEqual(inference.update_input_types({"X": x_type}), 1)
+        x_type = make_tensor_value_info("X", TensorProto.FLOAT, (4, 5, 6)).type
+        self.assertEqual(inference.update_input_types({"X": x_type}), 3)
+        self.assertEqual(
+            self._value_infos(inference.model),
+            self._value_infos(onnx.shape_inference.infer_shapes(self._incremental_model(nodes, (4, 5, 6)))))
+
+    def test_incremental_inference_removes_value_info(self):
+        nodes = [make_node("Relu", ["X"], ["A"]),
+                 make_node("Relu", ["A"], ["B"])]
+        inference = onnx.shape_inference.IncrementalInference(
+            self._incremental_model(nodes, (2, 3)))
+        self.assertEqual(sorted(self._value_infos(inference.model)), ["A", "B"])
+
+        # nothing is inferred from an input without an element type or shape
+        x_type = onnx.TypeProto()
+        x_type.tensor_type.SetInParent()
+        self.assertEqual(inference.update_input_types({"X": x_type}), 2)
+        self.assertEqual(list(inference.model.graph.value_info), [])
+
+    def test_incremental_inference_unknown_input(self):
+        nodes = [make_node("Relu", ["X"], ["A"])]
+        inference = onnx.shape_inference.IncrementalInference(
+            self._incremental_model(nodes, (2, 3)))
+        model = inference.model
+        x_type = make_tensor_value_info("X", TensorProto.FLOAT, (4, 5)).type
+        self.assertRaises(RuntimeError, inference.update_input_types, {"X": x_type, "Y": x_type})
+        self.assertEqual(inference.model, model)
+
+    def test_incremental_inference_raises(self):
+        # the inference of a Conv without weights reads them once X has a shape
+        nodes = [make_node("Relu", ["X"], ["A"]),
+                 make_node("Conv", ["X"], ["B"]),
+                 make_node("Relu", ["A"], ["C"])]
+        inference = onnx.shape_inference.IncrementalInference(
+            self._incremental_model(nodes, None))
+        x_type = make_tensor_value_info("X", TensorProto.FLOAT, (1, 1, 4, 4)).type
+        self.assertRaises(RuntimeError, inference.update_input_types, {"X": x_type})
+        # the nodes before the Conv are re-inferred, and the ones after it are not
+        value_infos = self._value_infos(inference.model)
+        self.assertEqual(value_infos["A"], x_type)
+        self.assertEqual(value_infos["C"], make_tensor_value_info("C", TensorProto.FLOAT, None).type)
+        self.assertEqual(inference.model.graph.input[0].type, x_type)
+
+        # the Conv stays queued
+        self.assertRaises(RuntimeError, inference.update_input_types, {})
+        x_type = make_tensor_value_info("X", TensorProto.FLOAT, None).type
+        self.assertEqual(inference.update_input_types({"X": x_type}), 3)
+        self.assertEqual(
+            self._value_infos(inference.model),
+            self._value_infos(onnx.shape_inference.infer_shapes(self._incremental_model(nodes, None))))
+
 
 if __name__ == '__main__':
     unittest.main()
@@ -0,0 +1,378 @@
+#include <benchmark/benchmark.h>
+
+#include <onnx/checker.h>
+#include <onnx/onnx.pb.h>
+#include <onnx/shape_inference/implementation.h>
+
+using namespace ONNX_NAMESPACE;
+
+
+inline void createValueInfo2D(
+    ValueInfoProto& value_info,
+    const std::string& name,
+    int64_t h,
+    int64_t w) {
+  value_info.set_name(name);
+
+  TypeProto_Tensor* tensor_type =
+      value_info.mutable_type()->mutable_tensor_type();
+  tensor_type->set_elem_type(TensorProto_DataType_FLOAT);
+
+  TensorShapeProto* shape = tensor_type->mutable_shape();
+  shape->add_dim()->set_dim_value(h);
+  shape->add_dim()->set_dim_value(w);
+}
+
+// Appends num_nodes nodes to graph, each reading the output of the previous
+// one and a graph input, starting from the value named input. Returns the
+// name of the last output.
+inline std::string createChain(
+    GraphProto& graph,
+    const std::string& input,
+    const std::string& prefix,
+    int64_t num_nodes) {
+  std::string last = input;
+  for (int64_t i = 0; i < num_nodes; i++) {
+    NodeProto* node = graph.add_node();
+    std::string output = prefix + ONNX_NAMESPACE::to_string(i);
+    if (i % 2 == 0) {
+      node->set_op_type("Relu");
+      node->add_input(last);
+    } else {
+      node->set_op_type("Add");
+      node->add_input(last);
+      node->add_input("bias");
+    }
+    node->add_output(output);
+    last = output;
+  }
+  return last;
+}
+
+inline void createModel(ModelProto& model, int64_t num_nodes) {
+  model.set_ir_version(IR_VERSION);
+  OperatorSetIdProto* op_set_id = model.add_opset_import();
+  op_set_id->set_domain("");
+  op_set_id->set_version(6);
+
+  GraphProto* graph = model.mutable_graph();
+  graph->set_name("chain");
+  createValueInfo2D(*graph->add_input(), "input", 1, 16);
+  createValueInfo2D(*graph->add_input(), "bias", 1, 16);
+  std::string output = createChain(*graph, "input", "v", num_nodes);
+  createValueInfo2D(*graph->add_output(), output, 1, 16);
+}
+
+static void CheckChain(benchmark::State& state) {
+  ModelProto model;
+  createModel(model, state.range(0));
+
+  while (state.KeepRunning()) {
+    checker::check_model(model);
+  }
+
+  state.SetItemsProcessed(int64_t(state.iterations()) * state.range(0));
+  state.SetComplexityN(state.range(0));
+}
+BENCHMARK(CheckChain)
+    ->RangeMultiplier(10)
+    ->Range(1000, 1000000)
+    ->Unit(benchmark::kMillisecond)
+    ->Complexity(benchmark::oN);
+
+// The chain, followed by Ifs whose branches read values of the chain.
+static void CheckNestedGraphs(benchmark::State& state) {
+  ModelProto model;
+  createModel(model, state.range(0));
+
+  GraphProto* graph = model.mutable_graph();
+  std::string cond = "cond";
+  {
+    ValueInfoProto* value_info = graph->add_input();
+    value_info->set_name(cond);
+    TypeProto_Tensor* tensor_type =
+        value_info->mutable_type()->mutable_tensor_type();
+    tensor_type->set_elem_type(TensorProto_DataType_BOOL);
+    tensor_type->mutable_shape()->add_dim()->set_dim_value(1);
+  }
+  int64_t num_ifs = state.range(0) / 100;
+  for (int64_t i = 0; i < num_ifs; i++) {
+    NodeProto* node = graph->add_node();
+    node->set_op_type("If");
+    node->add_input(cond);
+    node->add_output("if" + ONNX_NAMESPACE::to_string(i));
+    for (const char* name : {"then_branch", "else_branch"}) {
+      AttributeProto* attr = node->add_attribute();
+      attr->set_name(name);
+      attr->set_type(AttributeProto::GRAPH);
+      GraphProto* branch = attr->mutable_g();
+      std::string prefix = name + ONNX_NAMESPACE::to_string(i) + "_";
+      branch->set_name(prefix);
+      std::string output =
+          createChain(*branch, "v" + ONNX_NAMESPACE::to_string(i * 100), prefix, 10);
+      createValueInfo2D(*branch->add_output(), output, 1, 16);
+    }
+  }
+
+  while (state.KeepRunning()) {
+    checker::check_model(model);
+  }
+
+  state.SetItemsProcessed(int64_t(state.iterations()) * state.range(0));
+  state.SetComplexityN(state.range(0));
+}
+BENCHMARK(CheckNestedGraphs)
+    ->RangeMultiplier(10)
+    ->Range(1000, 1000000)
+    ->Unit(benchmark::kMillisecond)
+    ->Complexity(benchmark::oN);
+
+// The chain, checked on all the hardware threads.
+static void CheckChainParallel(benchmark::State& state) {
+  ModelProto model;
+  createModel(model, state.range(0));
+
+  while (state.KeepRunning()) {
+    checker::check_model(model, 0);
+  }
+
+  state.SetItemsProcessed(int64_t(state.iterations()) * state.range(0));
+  state.SetComplexityN(state.range(0));
+}
+BENCHMARK(CheckChainParallel)
+    ->RangeMultiplier(10)
+    ->Range(1000, 1000000)
+    ->Unit(benchmark::kMillisecond)
+    ->Complexity(benchmark::oN);
+
+// The chain, checked and then inferred, looking up the schema of each node
+// twice.
+static void CheckThenInferChain(benchmark::State& state) {
+  ModelProto model;
+  createModel(model, state.range(0));
+
+  while (state.KeepRunning()) {
+    ModelProto inferred = model;
+    checker::check_model(inferred);
+    shape_inference::InferShapes(inferred);
+  }
+
+  state.SetItemsProcessed(int64_t(state.iterations()) * state.range(0));
+  state.SetComplexityN(state.range(0));
+}
+BENCHMARK(CheckThenInferChain)
+    ->RangeMultiplier(10)
+    ->Range(1000, 1000000)
+    ->Unit(benchmark::kMillisecond)
+    ->Complexity(benchmark::oN);
+
+// The chain, checked and inferred in one pass.
+static void CheckAndInferChain(benchmark::State& state) {
+  ModelProto model;
+  createModel(model, state.range(0));
+
+  while (state.KeepRunning()) {
+    ModelProto inferred = model;
+    checker::check_model_and_infer_shapes(inferred);
+  }
+
+  state.SetItemsProcessed(int64_t(state.iterations()) * state.range(0));
+  state.SetComplexityN(state.range(0));
+}
+BENCHMARK(CheckAndInferChain)
+    ->RangeMultiplier(10)
+    ->Range(1000, 1000000)
+    ->Unit(benchmark::kMillisecond)
+    ->Complexity(benchmark::oN);
+
+inline void createGemm(
+    GraphProto& graph,
+    const std::string& a,
+    const std::string& b,
+    const std::string& c,
+    const std::string& y,
+    bool transB = false) {
+  NodeProto* node = graph.add_node();
+  node->set_op_type("Gemm");
+  node->add_input(a);
+  node->add_input(b);
+  node->add_input(c);
+  node->add_output(y);
+  AttributeProto* broadcast = node->add_attribute();
+  broadcast->set_name("broadcast");
+  broadcast->set_type(AttributeProto::INT);
+  broadcast->set_i(1);
+  if (transB) {
+    AttributeProto* attr = node->add_attribute();
+    attr->set_name("transB");
+    attr->set_type(AttributeProto::INT);
+    attr->set_i(1);
+  }
+}
+
+inline void createNode(
+    GraphProto& graph,
+    const std::string& op_type,
+    const std::vector<std::string>& inputs,
+    const std::string& output) {
+  NodeProto* node = graph.add_node();
+  node->set_op_type(op_type);
+  for (const auto& input : inputs) {
+    node->add_input(input);
+  }
+  node->add_output(output);
+}
+
+// A transformer encoder of num_layers layers, each of them a single head
+// attention followed by a feed forward network, on a sequence of 128
+// vectors of 512 elements. The layers have weights of their own.
+inline void createTransformer(ModelProto& model, int64_t num_layers) {
+  const int64_t seq = 128, dim = 512, hidden = 2048;
+  model.set_ir_version(IR_VERSION);
+  OperatorSetIdProto* op_set_id = model.add_opset_import();
+  op_set_id->set_domain("");
+  op_set_id->set_version(6);
+
+  GraphProto* graph = model.mutable_graph();
+  graph->set_name("transformer");
+  createValueInfo2D(*graph->add_input(), "x", seq, dim);
+  std::string x = "x";
+  for (int64_t i = 0; i < num_layers; i++) {
+    const std::string l = ONNX_NAMESPACE::to_string(i) + "_";
+    for (const char* w : {"wq", "wk", "wv", "wo"}) {
+      createValueInfo2D(*graph->add_input(), l + w, dim, dim);
+    }
+    createValueInfo2D(*graph->add_input(), l + "w1", dim, hidden);
+    createValueInfo2D(*graph->add_input(), l + "w2", hidden, dim);
+    createValueInfo2D(*graph->add_input(), l + "b", 1, dim);
+    createValueInfo2D(*graph->add_input(), l + "b1", 1, hidden);
+    createValueInfo2D(*graph->add_input(), l + "bs", 1, seq);
+
+    createGemm(*graph, x, l + "wq", l + "b", l + "q");
+    createGemm(*graph, x, l + "wk", l + "b", l + "k");
+    createGemm(*graph, x, l + "wv", l + "b", l + "v");
+    createGemm(*graph, l + "q", l + "k", l + "bs", l + "s", true);
+    createNode(*graph, "Softmax", {l + "s"}, l + "p");
+    createGemm(*graph, l + "p", l + "v", l + "b", l + "a");
+    createGemm(*graph, l + "a", l + "wo", l + "b", l + "o");
+    createNode(*graph, "Add", {l + "o", x}, l + "r");
+    createGemm(*graph, l + "r", l + "w1", l + "b1", l + "h");
+    createNode(*graph, "Relu", {l + "h"}, l + "hr");
+    createGemm(*graph, l + "hr", l + "w2", l + "b", l + "f");
+    createNode(*graph, "Add", {l + "f", l + "r"}, l + "y");
+    x = l + "y";
+  }
+  createValueInfo2D(*graph->add_output(), x, seq, dim);
+}
+
+static void InferTransformer(benchmark::State& state) {
+  ModelProto model;
+  createTransformer(model, state.range(0));
+
+  while (state.KeepRunning()) {
+    ModelProto inferred = model;
+    shape_inference::InferShapes(inferred);
+  }
+
+  state.SetItemsProcessed(
+      int64_t(state.iterations()) * model.graph().node_size());
+}
+BENCHMARK(InferTransformer)->Arg(48)->Unit(benchmark::kMillisecond);
+
+// The transformer, inferred with a cache of its own, so that the layers
+// after the first one are found in it.
+static void InferTransformerMemoized(benchmark::State& state) {
+  ModelProto model;
+  createTransformer(model, state.range(0));
+
+  shape_inference::InferenceCache cache;
+  while (state.KeepRunning()) {
+    ModelProto inferred = model;
+    cache = shape_inference::InferenceCache();
+    shape_inference::InferShapes(inferred, &cache);
+  }
+
+  state.SetItemsProcessed(
+      int64_t(state.iterations()) * model.graph().node_size());
+  state.SetLabel(
+      "hit rate " + ONNX_NAMESPACE::to_string(cache.hitRate()) + ", " +
+      ONNX_NAMESPACE::to_string(cache.savedSeconds() * 1e6) +
+      " us saved per model");
+}
+BENCHMARK(InferTransformerMemoized)->Arg(48)->Unit(benchmark::kMillisecond);
+
+// Clears the shape of the output of the transformer, which is inferred
+// again for each specialization.
+inline void clearOutputShape(GraphProto& graph) {
+  graph.mutable_output(0)->mutable_type()->mutable_tensor_type()->clear_shape();
+}
+
+inline TypeProto createTensorType2D(int64_t h, int64_t w) {
+  ValueInfoProto value_info;
+  createValueInfo2D(value_info, "", h, w);
+  return value_info.type();
+}
+
+// The transformer, re-specialized for sequences of 64 and 128 vectors in
+// turn, by clearing the inferred types and inferring them again.
+static void ReinferTransformer(benchmark::State& state) {
+  ModelProto model;
+  createTransformer(model, state.range(0));
+  clearOutputShape(*model.mutable_graph());
+
+  int64_t i = 0;
+  while (state.KeepRunning()) {
+    GraphProto* graph = model.mutable_graph();
+    graph->clear_value_info();
+    clearOutputShape(*graph);
+    *graph->mutable_input(0)->mutable_type() =
+        createTensorType2D(i++ % 2 == 0 ? 64 : 128, 512);
+    shape_inference::InferShapes(model);
+  }
+
+  state.SetItemsProcessed(
+      int64_t(state.iterations()) * model.graph().node_size());
+}
+BENCHMARK(ReinferTransformer)->Arg(48)->Unit(benchmark::kMillisecond);
+
+// The same, re-inferring the nodes whose inputs change, i.e. all of them.
+static void ReinferTransformerIncremental(benchmark::State& state) {
+  ModelProto model;
+  createTransformer(model, state.range(0));
+  clearOutputShape(*model.mutable_graph());
+  shape_inference::IncrementalInference inference(model);
+
+  int64_t i = 0;
+  while (state.KeepRunning()) {
+    inference.updateInputTypes(
+        {{"x", createTensorType2D(i++ % 2 == 0 ? 64 : 128, 512)}});
+  }
+
+  state.SetItemsProcessed(
+      int64_t(state.iterations()) * model.graph().node_size());
+}
+BENCHMARK(ReinferTransformerIncremental)
+    ->Arg(48)
+    ->Unit(benchmark::kMillisecond);
+
+// The transformer, whose last feed forward network is resized in turn,
+// which changes the types of its last two nodes only.
+static void ReinferTransformerLastLayer(benchmark::State& state) {
+  ModelProto model;
+  createTransformer(model, state.range(0));
+  clearOutputShape(*model.mutable_graph());
+  shape_inference::IncrementalInference inference(model);
+
+  const std::string w2 =
+      ONNX_NAMESPACE::to_string(state.range(0) - 1) + "_w2";
+  int64_t i = 0;
+  while (state.KeepRunning()) {
+    inference.updateInputTypes(
+        {{w2, createTensorType2D(2048, i++ % 2 == 0 ? 256 : 512)}});
+  }
+}
+BENCHMARK(ReinferTransformerLastLayer)
+    ->Arg(48)
+    ->Unit(benchmark::kMicrosecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,57 @@
+#include <benchmark/benchmark.h>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <cstring>
+
+#include <onnx/defs/schema.h>
+
+using namespace ONNX_NAMESPACE;
+
+static const char* self_path = nullptr;
+
+// Starts this program again, to load the schemas and look one up, and waits
+// for it to exit.
+static void ProcessStartup(benchmark::State& state) {
+  while (state.KeepRunning()) {
+    pid_t pid = fork();
+    if (pid == 0) {
+      execlp(self_path, self_path, "--lookup-schema", static_cast<char*>(nullptr));
+      _exit(127);
+    }
+    int status = 0;
+    if (pid < 0 || waitpid(pid, &status, 0) != pid || !WIFEXITED(status) ||
+        WEXITSTATUS(status) != 0) {
+      state.SkipWithError("the child process failed");
+      break;
+    }
+  }
+}
+BENCHMARK(ProcessStartup)->Unit(benchmark::kMillisecond);
+
+// The work done for each operator when the library is loaded.
+static void SchemaConstruction(benchmark::State& state) {
+  while (state.KeepRunning()) {
+    OpSchema schema = OpSchema("Relu", __FILE__, __LINE__)
+        .SetDoc("Relu takes one input data (Tensor<T>) and produces one output data.")
+        .Input(0, "X", "Input tensor", "T")
+        .Output(0, "Y", "Output tensor", "T")
+        .TypeConstraint(
+            "T",
+            {"tensor(float16)", "tensor(float)", "tensor(double)"},
+            "Constrain input and output types to float tensors.")
+        .TypeAndShapeInferenceFunction(propagateShapeAndTypeFromFirstInput);
+    benchmark::DoNotOptimize(schema);
+  }
+}
+BENCHMARK(SchemaConstruction)->Unit(benchmark::kMicrosecond);
+
+int main(int argc, char** argv) {
+  if (argc == 2 && std::strcmp(argv[1], "--lookup-schema") == 0) {
+    return OpSchemaRegistry::Schema("Relu") != nullptr ? 0 : 1;
+  }
+  self_path = argv[0];
+  benchmark::Initialize(&argc, argv);
+  benchmark::RunSpecifiedBenchmarks();
+}